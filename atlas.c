@@ -0,0 +1,398 @@
+/****************************************************************************
+*                                                                           *
+*       atlas: the amino acid motifs of every k-mer in the three reading    *
+*       frames, not only of the Restriction Enzymes in dbase2.              *
+*                                                                           *
+*       The motif of a k-mer in a reading frame is, for each codon it       *
+*       touches, the set of amino acids coded by the codons that agree      *
+*       with it, kept as a bit per letter.  An atlas of all 4096 hexamers   *
+*       (or of all k-mers up to k = 8) can be written to a compact binary   *
+*       file, so that any motif can be looked for in a protein with         *
+*       AtlasScan without building a database for it.                       *
+*                                                                           *
+*       The binary file, little endian:                                     *
+*           "SMATLAS1", k and the number of slots (32 bits each),           *
+*           the amino acid of each of the 64 codons (2-bit code order),     *
+*           then for each k-mer (2-bit code, first base most significant)   *
+*           and each frame the 32-bit letter set of each slot.              *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "silmut.h"
+
+#define ATLAS_MAGIC     "SMATLAS1"
+#define ATLAS_HEADER    (8 + 4 + 4 + 64)
+#define MAX_K           8
+
+struct ATLAS
+{
+    int k, nslots;
+    uint32_t *set;          /* SET(atlas, kmer, frame, slot)            */
+    char codon_aa[64];
+};
+
+#define SET(a, kmer, frame, slot) \
+    ((a)->set[((size_t)(kmer) * 3 + (frame) - 1) * (a)->nslots + (slot)])
+
+typedef struct
+{
+    ATLAS *atlas;
+    long from, to;          /* k-mers [from, to) */
+} ATLAS_WORK;
+
+static const char base[5] = { 'A', 'C', 'G', 'T', '\0' };
+
+static long NumKmers(int k)
+{
+    return(1L << (2 * k));
+}
+
+/* number of codons a k-mer touches in a reading frame */
+static int FrameSlots(int k, int frame)
+{
+    return((frame - 1 + k + 2) / 3);
+}
+
+static ATLAS *NewAtlas(int k)
+{
+    ATLAS *atlas;
+
+    if ((k < 1) || (k > MAX_K) || ((atlas = calloc(1, sizeof(ATLAS))) == NULL))
+        return(NULL);
+    atlas->k = k;
+    atlas->nslots = FrameSlots(k, 3);
+    if ((atlas->set = calloc(NumKmers(k) * 3 * atlas->nslots, sizeof(uint32_t))) == NULL)
+    {
+        free(atlas);
+        return(NULL);
+    }
+    return(atlas);
+}
+
+void FreeAtlas(ATLAS *atlas)
+{
+    if (atlas == NULL)
+        return;
+    free(atlas->set);
+    free(atlas);
+}
+
+int AtlasK(const ATLAS *atlas)
+{
+    return(atlas->k);
+}
+
+/******************************************************************************
+*                                                                             *
+*   AtlasWorker:    Works out the motifs of a range of k-mers.                *
+*                                                                             *
+******************************************************************************/
+
+static void *AtlasWorker(void *arg)
+{
+    ATLAS_WORK *w = arg;
+    ATLAS *a = w->atlas;
+    long kmer;
+    int frame, slot, code, j, off, c;
+
+    for (kmer = w->from; kmer < w->to; kmer++)
+    {
+        for (frame = 1; frame <= 3; frame++)
+        {
+            for (slot = 0; slot < FrameSlots(a->k, frame); slot++)
+            {
+                for (code = 0; code < 64; code++)
+                {
+                    c = a->codon_aa[code];
+                    if ((c < 'A') || (c > 'Z'))
+                        continue;
+
+                    /* the bases of the codon inside the k-mer must be its own */
+                    for (j = 0; j < 3; j++)
+                    {
+                        off = 3 * slot + j - (frame - 1);
+                        if ((off >= 0) && (off < a->k) &&
+                                (((code >> (2 * (2 - j))) & 3) !=
+                                 ((kmer >> (2 * (a->k - 1 - off))) & 3)))
+                            break;
+                    }
+                    if (j == 3)
+                        SET(a, kmer, frame, slot) |= (uint32_t)1 << (c - 'A');
+                }
+            }
+        }
+    }
+    return(NULL);
+}
+
+/******************************************************************************
+*                                                                             *
+*   BuildAtlas:     Works out the motifs of all the k-mers.                   *
+*                                                                             *
+*   Input:          db. database whose codon table is used.                   *
+*                   k. length of the k-mers, 1 to 8.                          *
+*                   nthreads. number of threads sharing the k-mers.           *
+*                                                                             *
+*   Output:         the atlas, or NULL if k is out of range or memory is      *
+*                   exhausted.                                                *
+*                                                                             *
+******************************************************************************/
+
+ATLAS *BuildAtlas(const DATABASE *db, int k, int nthreads)
+{
+    ATLAS *atlas;
+    ATLAS_WORK *work;
+    pthread_t *threads;
+    long n;
+    int i, *started;
+
+    if ((atlas = NewAtlas(k)) == NULL)
+        return(NULL);
+    for (i = 0; i < 64; i++)
+        atlas->codon_aa[i] = CodonAminoAcid(db, i);
+
+    n = NumKmers(k);
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > n)
+        nthreads = n;
+    work = calloc(nthreads, sizeof(ATLAS_WORK));
+    threads = calloc(nthreads, sizeof(pthread_t));
+    started = calloc(nthreads, sizeof(int));
+    if ((work == NULL) || (threads == NULL) || (started == NULL))
+    {
+        free(work);
+        free(threads);
+        free(started);
+        FreeAtlas(atlas);
+        return(NULL);
+    }
+
+    /* a thread that cannot be started leaves its k-mers to this one */
+    for (i = 0; i < nthreads; i++)
+    {
+        work[i].atlas = atlas;
+        work[i].from = n * i / nthreads;
+        work[i].to = n * (i + 1) / nthreads;
+        if (i > 0)
+            started[i] = (pthread_create(&threads[i], NULL, AtlasWorker, &work[i]) == 0);
+    }
+    AtlasWorker(&work[0]);
+    for (i = 1; i < nthreads; i++)
+    {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            AtlasWorker(&work[i]);
+    }
+
+    free(work);
+    free(threads);
+    free(started);
+    return(atlas);
+}
+
+static void PutWord(unsigned char *p, uint32_t w)
+{
+    p[0] = w & 0xff;
+    p[1] = (w >> 8) & 0xff;
+    p[2] = (w >> 16) & 0xff;
+    p[3] = (w >> 24) & 0xff;
+}
+
+static uint32_t GetWord(const unsigned char *p)
+{
+    return(p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/******************************************************************************
+*                                                                             *
+*   WriteAtlas:     Writes an atlas to a binary file.                         *
+*                                                                             *
+*   Output:         0 on success, -1 if the file cannot be written.           *
+*                                                                             *
+******************************************************************************/
+
+int WriteAtlas(const ATLAS *atlas, const char *fname)
+{
+    unsigned char header[ATLAS_HEADER], word[4];
+    size_t i, n = NumKmers(atlas->k) * 3 * atlas->nslots;
+    FILE *fp;
+    int err;
+
+    if ((fp = fopen(fname, "wb")) == NULL)
+        return(-1);
+    memcpy(header, ATLAS_MAGIC, 8);
+    PutWord(&header[8], atlas->k);
+    PutWord(&header[12], atlas->nslots);
+    memcpy(&header[16], atlas->codon_aa, 64);
+    err = (fwrite(header, 1, ATLAS_HEADER, fp) != ATLAS_HEADER);
+    for (i = 0; !err && (i < n); i++)
+    {
+        PutWord(word, atlas->set[i]);
+        err = (fwrite(word, 1, 4, fp) != 4);
+    }
+    if (fclose(fp) != 0)
+        err = 1;
+    return(err ? -1 : 0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadAtlas:      Reads an atlas written by WriteAtlas.                     *
+*                                                                             *
+*   Output:         the atlas, or NULL if the file cannot be read, is not an  *
+*                   atlas or is truncated.                                    *
+*                                                                             *
+******************************************************************************/
+
+ATLAS *ReadAtlas(const char *fname)
+{
+    unsigned char header[ATLAS_HEADER], word[4];
+    ATLAS *atlas = NULL;
+    size_t i, n;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "rb")) == NULL)
+        return(NULL);
+    if ((fread(header, 1, ATLAS_HEADER, fp) == ATLAS_HEADER) &&
+            !memcmp(header, ATLAS_MAGIC, 8) && (GetWord(&header[8]) >= 1) &&
+            (GetWord(&header[8]) <= MAX_K) &&
+            (GetWord(&header[12]) == (uint32_t)FrameSlots(GetWord(&header[8]), 3)) &&
+            ((atlas = NewAtlas(GetWord(&header[8]))) != NULL))
+    {
+        memcpy(atlas->codon_aa, &header[16], 64);
+        n = NumKmers(atlas->k) * 3 * atlas->nslots;
+        for (i = 0; i < n; i++)
+        {
+            if (fread(word, 1, 4, fp) != 4)
+                break;
+            atlas->set[i] = GetWord(word);
+        }
+        if ((i < n) || (fgetc(fp) != EOF))
+        {
+            FreeAtlas(atlas);
+            atlas = NULL;
+        }
+    }
+    fclose(fp);
+    return(atlas);
+}
+
+/* a letter set as the letter, or as [letters] if there are several */
+static void PrintSet(uint32_t set, FILE *fp)
+{
+    int c, n = 0;
+
+    for (c = 0; c < 26; c++)
+        n += (set >> c) & 1;
+    if (n == 0)
+        fputc('-', fp);
+    if (n > 1)
+        fputc('[', fp);
+    for (c = 0; c < 26; c++)
+    {
+        if ((set >> c) & 1)
+            fputc('A' + c, fp);
+    }
+    if (n > 1)
+        fputc(']', fp);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintAtlas:     Writes an atlas as a table, one k-mer a line followed by  *
+*                   its motif in each reading frame, e.g.                     *
+*                                                                             *
+*                   GAATTC  1: EF  2: [GRX]I[HLPQR]  3: ...                   *
+*                                                                             *
+*                   where [...] is any one of the amino acids within.         *
+*                                                                             *
+******************************************************************************/
+
+void PrintAtlas(const ATLAS *atlas, FILE *fp)
+{
+    long kmer;
+    int i, frame, slot;
+
+    for (kmer = 0; kmer < NumKmers(atlas->k); kmer++)
+    {
+        for (i = atlas->k - 1; i >= 0; i--)
+            fputc(base[(kmer >> (2 * i)) & 3], fp);
+        for (frame = 1; frame <= 3; frame++)
+        {
+            fprintf(fp, "  %d: ", frame);
+            for (slot = 0; slot < FrameSlots(atlas->k, frame); slot++)
+                PrintSet(SET(atlas, kmer, frame, slot), fp);
+        }
+        fputc('\n', fp);
+    }
+}
+
+/******************************************************************************
+*                                                                             *
+*   AtlasScan:      Finds where a k-mer can be introduced in an amino acid    *
+*                   sequence by silent mutations, as ScanForRE does for the   *
+*                   enzymes of a database.                                    *
+*                                                                             *
+*   Input:          site. the k-mer, of the length of the atlas, in T or U.   *
+*                   aa. amino acid sequence, as normalized by Check_Input.    *
+*                   out, max_out. where to put the first max_out sites, in    *
+*                   order of position and reading frame; re is set to -1.     *
+*                                                                             *
+*   Output:         the number of sites, -1 if site is not a k-mer of bases   *
+*                   of the length of the atlas.                               *
+*                                                                             *
+******************************************************************************/
+
+int AtlasScan(const ATLAS *atlas, const char *site, const char *aa, OUTPUT *out,
+              int max_out)
+{
+    long kmer = 0;
+    int i, c, pos, frame, slot, nslots, len = strlen(aa), n = 0;
+
+    if ((int)strlen(site) != atlas->k)
+        return(-1);
+    for (i = 0; i < atlas->k; i++)
+    {
+        c = site[i] & ~0x20;
+        if (c == 'U')
+            c = 'T';
+        if ((c == 0) || (strchr(base, c) == NULL))
+            return(-1);
+        kmer = kmer * 4 + (strchr(base, c) - base);
+    }
+
+    for (pos = 0; pos < len; pos++)
+    {
+        for (frame = 1; frame <= 3; frame++)
+        {
+            nslots = FrameSlots(atlas->k, frame);
+            if (pos + nslots > len)
+                continue;
+            for (slot = 0; slot < nslots; slot++)
+            {
+                c = (unsigned char)aa[pos + slot];
+                if ((c < 'A') || (c > 'Z') ||
+                        !((SET(atlas, kmer, frame, slot) >> (c - 'A')) & 1))
+                    break;
+            }
+            if (slot < nslots)
+                continue;
+            if (n < max_out)
+            {
+                out[n].pos = pos;
+                out[n].number = nslots;
+                out[n].frame = frame;
+                out[n].re = -1;
+            }
+            n++;
+        }
+    }
+    return(n);
+}
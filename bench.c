@@ -0,0 +1,455 @@
+/****************************************************************************
+*                                                                           *
+*       Program (BENCH) for measuring the throughput of each stage of the   *
+*       SILMUT engine on deterministic random sequences.                    *
+*                                                                           *
+*       bench [-n sizes] [-gc fraction] [-e enzymes] [-s seed]              *
+*             [-r repeats] [-t stages] [-a dbase1] [-d dbase2]              *
+*       bench -verify cases [-s seed] [-a dbase1] [-d dbase2] [-g example]  *
+*                                                                           *
+*       sizes is a comma separated list of sequence lengths in bases with   *
+*       an optional k, m or g suffix (1k to 1g).  With -e, a random dbase2  *
+*       of that many enzymes is generated instead of reading -d.            *
+*       -verify checks the engine against a brute force reference on that   *
+*       many random cases instead of measuring it (see verify.c), then      *
+*       runs example.IN (GPGR.IN) and compares the result with example.OUT. *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "silmut.h"
+#include "seqgen.h"
+#include "verify.h"
+
+#define MAX_SIZES   16
+#define MIN_TIME    0.2
+#define FASTA_LINE  60
+
+typedef struct
+{
+    const char *aa_fname;
+    const char *re_fname;
+    long sizes[MAX_SIZES];
+    int nsizes;
+    double gc;
+    int nenzymes;
+    unsigned long seed;
+    int repeats;
+    const char *stages;
+    int verify;
+    const char *golden;         /* example checked by -verify, as .IN/.OUT */
+} OPTIONS;
+
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+static int Wanted(const OPTIONS *opt, const char *stage)
+{
+    const char *p = opt->stages;
+    size_t n = strlen(stage);
+
+    if (!strcmp(p, "all"))
+        return(1);
+    while ((p = strstr(p, stage)) != NULL)
+    {
+        if (((p == opt->stages) || (p[-1] == ',')) && ((p[n] == ',') || (p[n] == '\0')))
+            return(1);
+        p += n;
+    }
+    return(0);
+}
+
+static long ParseSize(const char *str)
+{
+    char *end;
+    long n = strtol(str, &end, 10);
+
+    switch (*end)
+    {
+    case 'k':
+    case 'K':
+        n *= 1000L;
+        break;
+    case 'm':
+    case 'M':
+        n *= 1000000L;
+        break;
+    case 'g':
+    case 'G':
+        n *= 1000000000L;
+        break;
+    }
+    return(n);
+}
+
+static void Report(const char *stage, long size, int reps, double sec,
+                   double bases, double hits)
+{
+    printf("%-12s %11ld %6d %12.6f %14.0f", stage, size, reps, sec / reps,
+           bases * reps / sec);
+    if (hits >= 0)
+        printf(" %14.0f", hits * reps / sec);
+    printf("\n");
+}
+
+/******************************************************************************
+*                                                                             *
+*   BenchLoad:      Measures ReadDataBase_AA and ReadDataBase_RE through      *
+*                   LoadDataBase, reported as enzymes per second.             *
+*                                                                             *
+******************************************************************************/
+
+static void BenchLoad(const OPTIONS *opt, const char *re_fname, int nre)
+{
+    int reps = 0;
+    double t0 = Now(), t;
+    DATABASE *db;
+
+    do
+    {
+        db = LoadDataBase(opt->aa_fname, re_fname, NULL);
+        FreeDataBase(db);
+        reps++;
+        t = Now() - t0;
+    } while ((opt->repeats > 0) ? (reps < opt->repeats) : (t < MIN_TIME));
+
+    Report("load", nre, reps, t, nre, -1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   WriteFasta:     Writes a sequence as a one record FASTA file in lines of  *
+*                   FASTA_LINE bases.                                         *
+*                                                                             *
+*   Output:         0 on success, -1 if the file cannot be written.           *
+*                                                                             *
+******************************************************************************/
+
+static int WriteFasta(const char *fname, const char *na, long size)
+{
+    FILE *fp;
+    long i;
+
+    if ((fp = fopen(fname, "w")) == NULL)
+        return(-1);
+    fprintf(fp, ">bench %ld\n", size);
+    for (i = 0; i < size; i += FASTA_LINE)
+        fprintf(fp, "%.*s\n", (int)((size - i < FASTA_LINE) ? size - i : FASTA_LINE), &na[i]);
+    return(fclose(fp) ? -1 : 0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadFasta:      Reads every record of a FASTA file and translates it      *
+*                   straight from the input, as silmut does.                  *
+*                                                                             *
+******************************************************************************/
+
+static void ReadFasta(const DATABASE *db, const char *fname)
+{
+    SEQFILE *sf;
+    RECORD rec;
+    char *aa_str[16];
+    size_t bad;
+    int i, n;
+
+    if ((sf = OpenSeqFile(fname, 1)) == NULL)
+        return;
+    memset(&rec, 0, sizeof(rec));
+    while (ReadRecord(sf, &rec) > 0)
+    {
+        n = ConvertRawNAToAA(db, rec.raw, rec.raw_len, aa_str, &bad);
+        for (i = 0; i < n; i++)
+            free(aa_str[i]);
+    }
+    FreeRecord(&rec);
+    CloseSeqFile(sf);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Keystroke:      One edit of the kind a user makes in a sequence editor:   *
+*                   in turn a base substituted, inserted and deleted at a     *
+*                   random position.                                          *
+*                                                                             *
+******************************************************************************/
+
+static void Keystroke(EDIT *ed, SEQGEN *g, int k)
+{
+    char ins[2];
+    int pos;
+
+    RandomNA(g, ins, 1, 0.5);
+    pos = (int)(SeqGenNext(g) % (EditLength(ed) - 1));
+    if (k % 3 == 0)
+        EditSubstitute(ed, pos, ins);
+    else if (k % 3 == 1)
+        EditInsert(ed, pos, ins);
+    else
+        EditDelete(ed, pos, 1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   BenchSize:      Measures every stage on one random nucleic acid sequence  *
+*                   and one random amino acid sequence of the same length.    *
+*                                                                             *
+******************************************************************************/
+
+static void BenchSize(const OPTIONS *opt, const DATABASE *db, long size)
+{
+    SEQGEN g;
+    SCAN *scan;
+    EDIT *ed;
+    CURSOR cur;
+    OUTPUT hit;
+    FILE *null;
+    char *na, *work, *aa_str[16];
+    char fa_tmp[] = "/tmp/silmut-bench-XXXXXX";
+    int i, n, fd, reps, hits;
+    double t0, t;
+
+    SeedSeqGen(&g, opt->seed);
+    na = malloc(size + 1);
+    work = malloc(size + 1);
+    if ((na == NULL) || (work == NULL))
+    {
+        fprintf(stderr, "Out of memory for %ld bases\n", size);
+        exit(-1);
+    }
+    RandomNA(&g, na, size, opt->gc);
+    scan = NewScan(db);
+    null = fopen("/dev/null", "w");
+
+#define REPEAT(body) \
+    for (reps = 0, t0 = Now(); ; ) \
+    { \
+        body; \
+        reps++; \
+        t = Now() - t0; \
+        if ((opt->repeats > 0) ? (reps >= opt->repeats) : (t >= MIN_TIME)) \
+            break; \
+    }
+
+    if (Wanted(opt, "check"))
+    {
+        REPEAT(memcpy(work, na, size + 1); Check_Input(db, work, 2));
+        Report("check", size, reps, t, size, -1);
+    }
+
+    n = ConvertNAToAA(db, na, aa_str, size % 3);
+    if (Wanted(opt, "translate"))
+    {
+        REPEAT(for (i = 0; i < n; i++) free(aa_str[i]);
+               n = ConvertNAToAA(db, na, aa_str, size % 3));
+        Report("translate", size, reps, t, size, -1);
+    }
+
+    hits = ScanForRE(scan, aa_str[0]);
+    if (Wanted(opt, "scan"))
+    {
+        REPEAT(ScanForRE(scan, aa_str[0]));
+        Report("scan", size, reps, t, size, hits);
+    }
+
+    if (Wanted(opt, "first"))
+    {
+        REPEAT(OpenCursor(&cur, db, aa_str[0], 0, -1); NextHit(&cur, &hit));
+        Report("first", size, reps, t, size, 1);
+    }
+
+    if (Wanted(opt, "format") && (null != NULL))
+    {
+        REPEAT(PrintResult(scan, aa_str[0], null));
+        Report("format", size, reps, t, size, hits);
+    }
+
+    if (Wanted(opt, "pipeline") && (null != NULL))
+    {
+        REPEAT(for (i = 0; i < n; i++) free(aa_str[i]);
+               memcpy(work, na, size + 1);
+               Check_Input(db, work, 2);
+               n = ConvertNAToAA(db, work, aa_str, size % 3);
+               for (i = 0; i < n; i++)
+               {
+                   if (!Duplicate(aa_str, i))
+                   {
+                       ScanForRE(scan, aa_str[i]);
+                       PrintResult(scan, aa_str[i], null);
+                   }
+               });
+        Report("pipeline", size, reps, t, size, hits);
+    }
+
+    if (Wanted(opt, "fasta"))
+    {
+        if (((fd = mkstemp(fa_tmp)) >= 0) && (close(fd) == 0) &&
+                (WriteFasta(fa_tmp, na, size) == 0))
+        {
+            REPEAT(ReadFasta(db, fa_tmp));
+            Report("fasta", size, reps, t, size, -1);
+        }
+        remove(fa_tmp);
+    }
+
+    if (Wanted(opt, "edit") && (size >= 2) && ((ed = NewEdit(db, na, 2)) != NULL))
+    {
+        i = 0;
+        REPEAT(Keystroke(ed, &g, i++));
+        Report("edit", size, reps, t, size, -1);
+        FreeEdit(ed);
+    }
+
+    if (Wanted(opt, "protein"))
+    {
+        RandomAA(&g, work, size / 3, ValidAminoAcids(db));
+        hits = ScanForRE(scan, work);
+        REPEAT(ScanForRE(scan, work));
+        Report("protein", size, reps, t, size, hits);
+    }
+#undef REPEAT
+
+    for (i = 0; i < n; i++)
+        free(aa_str[i]);
+    if (null != NULL)
+        fclose(null);
+    FreeScan(scan);
+    free(work);
+    free(na);
+}
+
+int main(int argc, char *argv[])
+{
+    OPTIONS opt;
+    DATABASE *db;
+    SEQGEN g;
+    FILE *fp;
+    char re_tmp[] = "/tmp/silmut-bench-XXXXXX";
+    char in_fname[FILENAME_MAX], out_fname[FILENAME_MAX];
+    const char *re_fname, *bad_fname, *p;
+    int i, n, fd;
+
+    opt.aa_fname = "dbase1";
+    opt.re_fname = "dbase2";
+    opt.nsizes = 0;
+    opt.gc = 0.5;
+    opt.nenzymes = 0;
+    opt.seed = 1;
+    opt.repeats = 0;
+    opt.stages = "all";
+    opt.verify = 0;
+    opt.golden = "GPGR";
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((i + 1 < argc) && !strcmp(argv[i], "-n"))
+        {
+            for (p = argv[++i]; *p && (opt.nsizes < MAX_SIZES); )
+            {
+                opt.sizes[opt.nsizes++] = ParseSize(p);
+                p = strchr(p, ',');
+                if (p == NULL)
+                    break;
+                p++;
+            }
+        }
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-gc"))
+            opt.gc = atof(argv[++i]);
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-e"))
+            opt.nenzymes = atoi(argv[++i]);
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-s"))
+            opt.seed = strtoul(argv[++i], NULL, 10);
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-r"))
+            opt.repeats = atoi(argv[++i]);
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-t"))
+            opt.stages = argv[++i];
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-a"))
+            opt.aa_fname = argv[++i];
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-d"))
+            opt.re_fname = argv[++i];
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-verify"))
+            opt.verify = atoi(argv[++i]);
+        else if ((i + 1 < argc) && !strcmp(argv[i], "-g"))
+            opt.golden = argv[++i];
+        else
+        {
+            fprintf(stderr, "Invalid Option %s \n", argv[i]);
+            fprintf(stderr, "Usage %s [-n sizes] [-gc fraction] [-e enzymes] [-s seed]"
+                    " [-r repeats] [-t stages] [-a dbase1] [-d dbase2]\n", argv[0]);
+            fprintf(stderr, "      %s -verify cases [-s seed] [-a dbase1] [-d dbase2]"
+                    " [-g example]\n", argv[0]);
+            fprintf(stderr, "Stages: load,check,translate,scan,first,format,pipeline,fasta,"
+                    "edit,protein\n");
+            exit(-1);
+        }
+    }
+
+    if (opt.verify > 0)
+    {
+        n = VerifyEngine(opt.aa_fname, opt.seed, opt.verify, stdout);
+        if (n < 0)
+        {
+            printf("Error opening DataBase file %s\n", opt.aa_fname);
+            exit(-1);
+        }
+        printf("%d of %d cases failed\n", n, opt.verify);
+
+        /* the example shipped with the program */
+        sprintf(in_fname, "%.*s.IN", FILENAME_MAX - 8, opt.golden);
+        sprintf(out_fname, "%.*s.OUT", FILENAME_MAX - 8, opt.golden);
+        if ((i = VerifyGolden(opt.aa_fname, opt.re_fname, in_fname, out_fname,
+                              stdout)) != 0)
+            printf("%s does not give %s\n", in_fname, out_fname);
+        return((n || i) ? 1 : 0);
+    }
+
+    if (opt.nsizes == 0)
+    {
+        opt.sizes[opt.nsizes++] = 1000L;
+        opt.sizes[opt.nsizes++] = 10000L;
+        opt.sizes[opt.nsizes++] = 100000L;
+        opt.sizes[opt.nsizes++] = 1000000L;
+        opt.sizes[opt.nsizes++] = 10000000L;
+    }
+
+    re_fname = opt.re_fname;
+    if (opt.nenzymes > 0)
+    {
+        SeedSeqGen(&g, opt.seed);
+        if (((fd = mkstemp(re_tmp)) < 0) || ((fp = fdopen(fd, "w")) == NULL))
+        {
+            fprintf(stderr, "Cannot create %s\n", re_tmp);
+            exit(-1);
+        }
+        WriteRandomDataBase_RE(&g, fp, opt.nenzymes, opt.gc);
+        fclose(fp);
+        re_fname = re_tmp;
+    }
+
+    if ((db = LoadDataBase(opt.aa_fname, re_fname, &bad_fname)) == NULL)
+    {
+        printf("Error opening DataBase file %s\n", bad_fname);
+        exit(-1);
+    }
+
+    printf("%-12s %11s %6s %12s %14s %14s\n", "stage", "size", "reps", "sec/rep",
+           "bases/s", "hits/s");
+    if (Wanted(&opt, "load"))
+        BenchLoad(&opt, re_fname, NumEnzymes(db));
+    for (i = 0; i < opt.nsizes; i++)
+        BenchSize(&opt, db, opt.sizes[i]);
+
+    FreeDataBase(db);
+    if (opt.nenzymes > 0)
+        remove(re_tmp);
+    return(0);
+}
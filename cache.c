@@ -0,0 +1,275 @@
+/****************************************************************************
+*                                                                           *
+*       cache: content addressed cache of SILMUT results.                   *
+*                                                                           *
+*       A result is stored under the 128-bit SequenceHash of the            *
+*       normalized sequence, which also covers the database and the         *
+*       options, so a repeated sequence is printed from the cache without   *
+*       being translated or scanned again.  The cache is kept in memory     *
+*       for the run and, if it has a directory, in one file per result      *
+*       there, named by the hash, so that later runs find it too.           *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "silmut.h"
+
+#define CACHE_MIN_SLOTS     1024
+#define CACHE_MAX_BYTES     (256L << 20)    /* results kept in memory    */
+
+typedef struct
+{
+    uint64_t key[2];
+    char *out;
+    size_t nout;
+    int used;
+} CACHE_ENTRY;
+
+struct CACHE
+{
+    char *dir;
+    CACHE_ENTRY *slot;
+    size_t nslots, nused;
+    size_t bytes;
+};
+
+/******************************************************************************
+*                                                                             *
+*   OpenCache:      Creates an empty result cache.                            *
+*                                                                             *
+*   Input:          dir. directory of the results kept across runs, created   *
+*                   if needed, or NULL to keep them in memory only.           *
+*                                                                             *
+*   Output:         the cache, or NULL if the directory cannot be created or  *
+*                   memory is exhausted.                                      *
+*                                                                             *
+******************************************************************************/
+
+CACHE *OpenCache(const char *dir)
+{
+    CACHE *cache;
+
+    if ((cache = calloc(1, sizeof(CACHE))) == NULL)
+        return(NULL);
+    cache->nslots = CACHE_MIN_SLOTS;
+    if ((cache->slot = calloc(cache->nslots, sizeof(CACHE_ENTRY))) == NULL)
+    {
+        free(cache);
+        return(NULL);
+    }
+    if (dir != NULL)
+    {
+        if (((mkdir(dir, 0777) < 0) && (errno != EEXIST)) ||
+                ((cache->dir = malloc(strlen(dir) + 1)) == NULL))
+        {
+            CloseCache(cache);
+            return(NULL);
+        }
+        strcpy(cache->dir, dir);
+    }
+    return(cache);
+}
+
+void CloseCache(CACHE *cache)
+{
+    size_t i;
+
+    if (cache == NULL)
+        return;
+    for (i = 0; i < cache->nslots; i++)
+        free(cache->slot[i].out);
+    free(cache->slot);
+    free(cache->dir);
+    free(cache);
+}
+
+/* the slot of a key, or the empty slot where it would go */
+static CACHE_ENTRY *FindSlot(const CACHE *cache, const uint64_t key[2])
+{
+    size_t i = key[0] & (cache->nslots - 1);
+
+    while (cache->slot[i].used &&
+            ((cache->slot[i].key[0] != key[0]) || (cache->slot[i].key[1] != key[1])))
+        i = (i + 1) & (cache->nslots - 1);
+    return(&cache->slot[i]);
+}
+
+static int GrowCache(CACHE *cache)
+{
+    CACHE_ENTRY *old = cache->slot, *e;
+    size_t i, n = cache->nslots;
+
+    if ((cache->slot = calloc(2 * n, sizeof(CACHE_ENTRY))) == NULL)
+    {
+        cache->slot = old;
+        return(-1);
+    }
+    cache->nslots = 2 * n;
+    for (i = 0; i < n; i++)
+    {
+        if (old[i].used)
+        {
+            e = FindSlot(cache, old[i].key);
+            *e = old[i];
+        }
+    }
+    free(old);
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   KeepResult:     Keeps a copy of a result in memory, unless the cache is   *
+*                   full.                                                     *
+*                                                                             *
+******************************************************************************/
+
+static const char *KeepResult(CACHE *cache, const uint64_t key[2], const char *out,
+                              size_t nout)
+{
+    CACHE_ENTRY *e;
+
+    if (cache->bytes + nout > CACHE_MAX_BYTES)
+        return(NULL);
+    if ((2 * (cache->nused + 1) > cache->nslots) && (GrowCache(cache) < 0))
+        return(NULL);
+    e = FindSlot(cache, key);
+    if (e->used)
+        return(e->out);
+    if ((e->out = malloc(nout ? nout : 1)) == NULL)
+        return(NULL);
+    memcpy(e->out, out, nout);
+    e->nout = nout;
+    e->key[0] = key[0];
+    e->key[1] = key[1];
+    e->used = 1;
+    cache->nused++;
+    cache->bytes += nout;
+    return(e->out);
+}
+
+/* dir/xx/yyyy...: the first two hex digits of the key name a subdirectory */
+static void ResultFile(const CACHE *cache, const uint64_t key[2], char *fname, int sub)
+{
+    char hex[33];
+
+    sprintf(hex, "%016llx%016llx", (unsigned long long)key[0], (unsigned long long)key[1]);
+    if (sub)
+        sprintf(fname, "%s/%.2s", cache->dir, hex);
+    else
+        sprintf(fname, "%s/%.2s/%s", cache->dir, hex, &hex[2]);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CacheLookup:    Finds the result of a sequence.                           *
+*                                                                             *
+*   Input:          key. SequenceHash of the sequence.                        *
+*                   nout. set to the length of the result.                    *
+*                                                                             *
+*   Output:         the result, valid until the cache is closed, or NULL if   *
+*                   it is not in the cache.                                   *
+*                                                                             *
+******************************************************************************/
+
+const char *CacheLookup(CACHE *cache, const uint64_t key[2], size_t *nout)
+{
+    CACHE_ENTRY *e = FindSlot(cache, key);
+    const char *out = NULL;
+    char *buf, *fname;
+    FILE *fp;
+    long n;
+
+    if (e->used)
+    {
+        *nout = e->nout;
+        return(e->out);
+    }
+    if (cache->dir == NULL)
+        return(NULL);
+
+    if ((fname = malloc(strlen(cache->dir) + 40)) == NULL)
+        return(NULL);
+    ResultFile(cache, key, fname, 0);
+    if ((fp = fopen(fname, "rb")) != NULL)
+    {
+        if ((fseek(fp, 0, SEEK_END) == 0) && ((n = ftell(fp)) >= 0) &&
+                (fseek(fp, 0, SEEK_SET) == 0) && ((buf = malloc(n ? n : 1)) != NULL))
+        {
+            if (fread(buf, 1, n, fp) == (size_t)n)
+            {
+                *nout = n;
+                out = KeepResult(cache, key, buf, n);
+            }
+            free(buf);
+        }
+        fclose(fp);
+    }
+    free(fname);
+    return(out);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CacheStore:     Adds the result of a sequence to the cache.               *
+*                                                                             *
+*   Input:          key. SequenceHash of the sequence.                        *
+*                   out, nout. the result.                                    *
+*                                                                             *
+*   Output:         0 on success, -1 if it could not be written to the        *
+*                   directory.                                                *
+*                                                                             *
+*   Notes:          A file is written under a temporary name and renamed,     *
+*                   so runs sharing a directory never read a partial one.     *
+*                                                                             *
+******************************************************************************/
+
+int CacheStore(CACHE *cache, const uint64_t key[2], const char *out, size_t nout)
+{
+    char *fname, *tmp;
+    FILE *fp;
+    size_t n;
+    int fd, status = -1;
+
+    KeepResult(cache, key, out, nout);
+    if (cache->dir == NULL)
+        return(0);
+
+    fname = malloc(strlen(cache->dir) + 40);
+    tmp = malloc(strlen(cache->dir) + 40);
+    if ((fname == NULL) || (tmp == NULL))
+    {
+        free(fname);
+        free(tmp);
+        return(-1);
+    }
+    ResultFile(cache, key, tmp, 1);
+    if ((mkdir(tmp, 0777) == 0) || (errno == EEXIST))
+    {
+        strcat(tmp, "/.tmpXXXXXX");
+        if ((fd = mkstemp(tmp)) >= 0)
+        {
+            if ((fp = fdopen(fd, "wb")) == NULL)
+                close(fd);
+            else
+            {
+                n = fwrite(out, 1, nout, fp);
+                if ((fclose(fp) == 0) && (n == nout))
+                {
+                    ResultFile(cache, key, fname, 0);
+                    status = rename(tmp, fname);
+                }
+            }
+            if (status < 0)
+                remove(tmp);
+        }
+    }
+    free(fname);
+    free(tmp);
+    return(status);
+}
@@ -0,0 +1,317 @@
+/****************************************************************************
+*                                                                           *
+*       conserved: the potential mutation sites shared by the sequences     *
+*       of an alignment, such as the strains of a virus.                    *
+*                                                                           *
+*       Each aligned sequence is scanned without its gaps and its sites     *
+*       are set as bits, one per enzyme, in a bitset for every column of    *
+*       the alignment.  The bitsets are folded into the totals a word of    *
+*       64 enzymes at a time: for sites in every sequence by AND, for       *
+*       sites in a share of them by bit-sliced counters, where plane p      *
+*       holds bit p of the count of each enzyme and a sequence is added     *
+*       with a ripple of AND and XOR.  So a sequence costs its scan and a   *
+*       few word operations per column, whatever the number of sequences.   *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "silmut.h"
+
+struct CONSERVED
+{
+    const DATABASE *db;
+    double percent;             /* share of the sequences wanted        */
+    int na;                     /* from the first sequence              */
+    int columns, ncoord, nwords;
+    long nseq;
+    uint64_t *seq;              /* sites of the sequence being added    */
+    uint64_t *all;              /* percent 100: sites of every sequence */
+    uint64_t **plane;           /* otherwise: bit-sliced counts         */
+    int nplanes;
+    int *touched, ntouched;     /* words set in seq                     */
+    int *column;                /* column of each residue or base       */
+    char *str;                  /* the sequence without its gaps        */
+};
+
+/******************************************************************************
+*                                                                             *
+*   NewConserved:   Creates an empty set of conserved sites.                  *
+*                                                                             *
+*   Input:          percent. the share of the sequences, from 0 to 100, a     *
+*                   site must be in to be reported.                           *
+*                                                                             *
+*   Output:         the set, or NULL if memory is exhausted.                  *
+*                                                                             *
+******************************************************************************/
+
+CONSERVED *NewConserved(const DATABASE *db, double percent)
+{
+    CONSERVED *cs;
+
+    if ((cs = calloc(1, sizeof(CONSERVED))) == NULL)
+        return(NULL);
+    cs->db = db;
+    cs->percent = percent;
+    cs->nwords = (NumEnzymes(db) + 63) / 64;
+    return(cs);
+}
+
+void FreeConserved(CONSERVED *cs)
+{
+    int p;
+
+    if (cs == NULL)
+        return;
+    for (p = 0; p < cs->nplanes; p++)
+        free(cs->plane[p]);
+    free(cs->plane);
+    free(cs->seq);
+    free(cs->all);
+    free(cs->touched);
+    free(cs->column);
+    free(cs->str);
+    free(cs);
+}
+
+/* sizes the bitsets for the alignment of the first sequence, 0 or -1 */
+static int Allocate(CONSERVED *cs, int columns)
+{
+    size_t words;
+
+    cs->columns = columns;
+    cs->ncoord = cs->na ? columns : 3 * columns;
+    words = (size_t)cs->ncoord * cs->nwords + 1;
+    cs->seq = calloc(words, sizeof(uint64_t));
+    cs->touched = malloc(words * sizeof(int));
+    cs->column = malloc((columns + 1) * sizeof(int));
+    if (cs->percent >= 100)
+    {
+        if ((cs->all = malloc(words * sizeof(uint64_t))) != NULL)
+            memset(cs->all, 0xff, words * sizeof(uint64_t));
+    }
+    if ((cs->seq == NULL) || (cs->touched == NULL) || (cs->column == NULL) ||
+            ((cs->percent >= 100) && (cs->all == NULL)))
+        return(-1);
+    return(0);
+}
+
+/* adds the word k of the sequence's bitset to the bit-sliced counts */
+static int AddWord(CONSERVED *cs, int k)
+{
+    uint64_t carry = cs->seq[k], t, **plane;
+    size_t words = (size_t)cs->ncoord * cs->nwords + 1;
+    int p;
+
+    for (p = 0; carry; p++)
+    {
+        if (p == cs->nplanes)
+        {
+            if ((plane = realloc(cs->plane, (p + 1) * sizeof(uint64_t *))) == NULL)
+                return(-1);
+            cs->plane = plane;
+            if ((cs->plane[p] = calloc(words, sizeof(uint64_t))) == NULL)
+                return(-1);
+            cs->nplanes++;
+        }
+        t = cs->plane[p][k] & carry;
+        cs->plane[p][k] ^= carry;
+        carry = t;
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   AddAligned:     Adds the sites of one aligned sequence.                   *
+*                                                                             *
+*   Input:          aln. the sequence with '-' or '.' for gaps; white space   *
+*                   is skipped.  Every sequence must have as many columns as  *
+*                   the first.                                                *
+*                   type. 1 for amino acids, 2 for nucleic acids, 0 to take   *
+*                   the alignment as nucleic acid if its first sequence holds *
+*                   only bases.                                               *
+*                   bad. set to the column of an invalid character.           *
+*                                                                             *
+*   Output:         1 if the sequence was added, 0 if it has invalid          *
+*                   characters, -1 if it is not as long as the alignment,     *
+*                   -2 if memory is exhausted.                                *
+*                                                                             *
+*   Notes:          A nucleic acid sequence is translated in the first        *
+*                   reading frame without its gaps, and a site is placed in   *
+*                   the column of its first base.  An amino acid site is      *
+*                   placed in the column of its residue and its frame.        *
+*                                                                             *
+******************************************************************************/
+
+int AddAligned(CONSERVED *cs, const char *aln, int type, size_t *bad)
+{
+    CURSOR cur;
+    OUTPUT hit;
+    char *aa[16];
+    const char *p;
+    int i, k, n, col, len, coord;
+
+    for (p = aln, col = 0; *p; p++)
+        col += !isspace((unsigned char)*p);
+    if (cs->columns == 0)
+    {
+        if (col == 0)
+            return(-1);
+        if ((cs->str = malloc(col + 1)) == NULL)
+            return(-2);
+        cs->na = (type == 2);
+        if (type == 0)
+        {
+            for (p = aln, n = 0; *p; p++)
+                if (!isspace((unsigned char)*p) && (*p != '-') && (*p != '.'))
+                    cs->str[n++] = *p;
+            cs->str[n] = '\0';
+            cs->na = (n > 0) && ValidateInput(cs->db, cs->str, 2, NULL);
+        }
+        if (Allocate(cs, col) < 0)
+            return(-2);
+    }
+    if (col != cs->columns)
+        return(-1);
+
+    /* the residues or bases, and the column of each */
+    for (p = aln, col = 0, len = 0; *p; p++)
+    {
+        if (isspace((unsigned char)*p))
+            continue;
+        if (isdigit((unsigned char)*p))
+        {
+            *bad = col;
+            return(0);
+        }
+        if ((*p != '-') && (*p != '.'))
+        {
+            cs->column[len] = col;
+            cs->str[len++] = *p;
+        }
+        col++;
+    }
+    cs->str[len] = '\0';
+    if ((len == 0) || !ValidateInput(cs->db, cs->str, cs->na ? 2 : 1, bad))
+    {
+        *bad = len ? cs->column[*bad] : 0;
+        return(0);
+    }
+
+    n = 1;
+    aa[0] = cs->str;
+    if (cs->na)
+    {
+        if ((n = ConvertNAToAA(cs->db, cs->str, aa, 0)) == 0)
+            return(-2);
+        aa[0][len / 3] = '\0';
+    }
+
+    /* set the bits of the sequence, noting each word the first time */
+    cs->ntouched = 0;
+    OpenCursor(&cur, cs->db, aa[0], 0, -1);
+    while (NextHit(&cur, &hit))
+    {
+        if (cs->na)
+            coord = cs->column[3 * hit.pos + hit.frame - 1];
+        else
+            coord = 3 * cs->column[hit.pos] + hit.frame - 1;
+        k = coord * cs->nwords + hit.re / 64;
+        if (cs->seq[k] == 0)
+            cs->touched[cs->ntouched++] = k;
+        cs->seq[k] |= 1ULL << (hit.re % 64);
+    }
+    if (cs->na)
+    {
+        for (i = 0; i < n; i++)
+            free(aa[i]);
+    }
+
+    if (cs->all)
+    {
+        for (k = 0; k < cs->ncoord * cs->nwords; k++)
+            cs->all[k] &= cs->seq[k];
+    }
+    for (i = 0; i < cs->ntouched; i++)
+    {
+        k = cs->touched[i];
+        if (!cs->all && (AddWord(cs, k) < 0))
+            return(-2);
+        cs->seq[k] = 0;
+    }
+    cs->nseq++;
+    return(1);
+}
+
+/* the number of sequences with bit b of word k */
+static long Count(const CONSERVED *cs, int k, int b)
+{
+    long count = 0;
+    int p;
+
+    if (cs->all)
+        return(((cs->all[k] >> b) & 1) ? cs->nseq : 0);
+    for (p = 0; p < cs->nplanes; p++)
+        count |= (long)((cs->plane[p][k] >> b) & 1) << p;
+    return(count);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintConserved: Writes the sites in at least the chosen share of the      *
+*                   sequences as a tab separated table, by column and then    *
+*                   in database order.                                        *
+*                                                                             *
+*   Output:         the number of characters written.                         *
+*                                                                             *
+*   Notes:          The column is counted from 1.  The frame is that of the   *
+*                   motif for an amino acid alignment and '-' for a nucleic   *
+*                   acid one, whose column is that of the first base.         *
+*                                                                             *
+******************************************************************************/
+
+int PrintConserved(const CONSERVED *cs, FILE *fp)
+{
+    uint64_t bits;
+    long need, count;
+    int coord, w, b, p, re, c;
+
+    c = fprintf(fp, "#column\tframe\tenzyme\tsite\tsequences\tpercent\n");
+    if (cs->nseq == 0)
+        return(c);
+    need = (long)(cs->percent * cs->nseq / 100);
+    if (need * 100.0 < cs->percent * cs->nseq)
+        need++;
+    if (need < 1)
+        need = 1;
+
+    for (coord = 0; coord < cs->ncoord; coord++)
+    {
+        for (w = 0; w < cs->nwords; w++)
+        {
+            if (cs->all)
+                bits = cs->all[coord * cs->nwords + w];
+            else
+                for (p = 0, bits = 0; p < cs->nplanes; p++)
+                    bits |= cs->plane[p][coord * cs->nwords + w];
+            for ( ; bits; bits &= bits - 1)
+            {
+                for (b = 0; !((bits >> b) & 1); b++)
+                    ;
+                re = w * 64 + b;
+                if ((count = Count(cs, coord * cs->nwords + w, b)) < need)
+                    continue;
+                if (cs->na)
+                    c += fprintf(fp, "%d\t-", coord + 1);
+                else
+                    c += fprintf(fp, "%d\t%d", coord / 3 + 1, coord % 3 + 1);
+                c += fprintf(fp, "\t%s\t%s\t%ld\t%.1f\n", EnzymeName(cs->db, re),
+                             EnzymeSite(cs->db, re), count, 100.0 * count / cs->nseq);
+            }
+        }
+    }
+    return(c);
+}
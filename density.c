@@ -0,0 +1,90 @@
+/****************************************************************************
+*                                                                           *
+*       density: a coverage track of the number of distinct enzymes whose   *
+*       sites can be introduced silently in windows along a nucleic acid    *
+*       sequence, for genome browsers.                                      *
+*                                                                           *
+*       The sites are taken from two CURSORs on the same translation: the   *
+*       leading one adds the sites entering the window to a count per       *
+*       enzyme, the trailing one takes away those leaving it.  Both only    *
+*       move forward, so a sequence costs one scan for each cursor and      *
+*       one step per window, and no site is stored.                         *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+/* the first base of a site, counted from 0 */
+static long long SiteStart(const OUTPUT *hit)
+{
+    return(3LL * hit->pos + hit->frame - 1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintDensity:   Writes the number of distinct enzymes with a site in      *
+*                   each window of a nucleic acid sequence, as bedGraph or    *
+*                   as fixedStep wiggle.                                      *
+*                                                                             *
+*   Input:          aa. translation of the whole codons of the sequence.      *
+*                   nbases. length of the nucleic acid sequence.              *
+*                   name. the chromosome, up to the first white space.        *
+*                   window, step. the windows start every step bases and are  *
+*                   window bases long.                                        *
+*                   wig. 1 for wiggle, 0 for bedGraph.                        *
+*                                                                             *
+*   Output:         the number of characters written, or -1 if memory is      *
+*                   exhausted.                                                *
+*                                                                             *
+*   Notes:          A site is in a window if its first base is.  The value    *
+*                   of the window starting at s is given for the step from s  *
+*                   to s + step, so that the intervals do not overlap, and    *
+*                   the last windows are cut at the end of the sequence.      *
+*                                                                             *
+******************************************************************************/
+
+int PrintDensity(const DATABASE *db, const char *aa, long long nbases, const char *name,
+                 int window, int step, int wig, FILE *fp)
+{
+    CURSOR lead, trail;
+    OUTPUT in, out;
+    long long start, end;
+    int *count, more_in, more_out, distinct = 0, n, c = 0;
+
+    if ((count = calloc(NumEnzymes(db) + 1, sizeof(int))) == NULL)
+        return(-1);
+    n = strcspn(name, " \t");
+    if (wig)
+        c += fprintf(fp, "fixedStep chrom=%.*s start=1 step=%d span=%d\n", n, name, step,
+                     step);
+
+    OpenCursor(&lead, db, aa, 0, -1);
+    OpenCursor(&trail, db, aa, 0, -1);
+    more_in = NextHit(&lead, &in);
+    more_out = NextHit(&trail, &out);
+    for (start = 0; start < nbases; start += step)
+    {
+        while (more_in && (SiteStart(&in) < start + window))
+        {
+            if (count[in.re]++ == 0)
+                distinct++;
+            more_in = NextHit(&lead, &in);
+        }
+        while (more_out && (SiteStart(&out) < start))
+        {
+            if (--count[out.re] == 0)
+                distinct--;
+            more_out = NextHit(&trail, &out);
+        }
+        end = (start + step < nbases) ? start + step : nbases;
+        if (wig)
+            c += fprintf(fp, "%d\n", distinct);
+        else
+            c += fprintf(fp, "%.*s\t%lld\t%lld\t%d\n", n, name, start, end, distinct);
+    }
+    free(count);
+    return(c);
+}
@@ -0,0 +1,450 @@
+/****************************************************************************
+*                                                                           *
+*       design: finds the best ways to introduce several unique             *
+*       Restriction Enzyme sites at once, e.g. a cassette flanked by two    *
+*       enzymes 300 to 600 bases apart.                                     *
+*                                                                           *
+*       The sites are taken in order along the sequence.  The candidates    *
+*       of each enzyme are its sites found by ScanForRE, with the base      *
+*       changes HitEdits gives, or the one site it already has.  Two sites  *
+*       never share a codon, so each is costed alone.  A pass over the      *
+*       candidates, with a sliding window minimum over those of the         *
+*       previous enzyme, finds the fewest edits of every partial design;    *
+*       a best first search back from the last enzyme then lists the        *
+*       designs in order of edits, so the top N cost little more than the   *
+*       best one.                                                           *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "silmut.h"
+
+typedef struct
+{
+    int start;              /* first base of the recognition sequence  */
+    int edits;
+    int best;               /* fewest edits of a design ending here    */
+    OUTPUT hit;
+} CANDIDATE;
+
+typedef struct
+{
+    int layer, c;           /* candidate c of enzyme layer             */
+    int edits;              /* edits of the sites after it             */
+    int prio;               /* edits + best of the candidate           */
+    int parent;             /* node of the next site, -1 for the last  */
+} NODE;
+
+typedef struct
+{
+    NODE *node;
+    int nnodes, max_nodes;
+    int *heap;
+    int nheap, max_heap;
+} SEARCH;
+
+static const char complement[5] = { 'T', 'G', 'C', 'A', '\0' };
+
+/******************************************************************************
+*                                                                             *
+*   CountSites:     Counts the recognition sequence of an enzyme on both      *
+*                   strands of a nucleic acid sequence.                       *
+*                                                                             *
+*   Input:          first. set to the first base of the first one.            *
+*                                                                             *
+******************************************************************************/
+
+static int CountSites(const char *site, const char *na, int len, int *first)
+{
+    char rev[SITE_LEN + 1];
+    int i, n = 0, palindrome;
+
+    for (i = 0; i < SITE_LEN; i++)
+        rev[i] = complement[strchr("ACGT", site[SITE_LEN - 1 - i]) - "ACGT"];
+    rev[SITE_LEN] = '\0';
+    palindrome = !strcmp(site, rev);
+
+    for (i = 0; i + SITE_LEN <= len; i++)
+    {
+        if (!memcmp(&na[i], site, SITE_LEN) ||
+                (!palindrome && !memcmp(&na[i], rev, SITE_LEN)))
+        {
+            if (n++ == 0)
+                *first = i;
+        }
+    }
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Candidates:     Collects the sites of one enzyme that can be made by      *
+*                   silent mutations and leave it cutting only once.          *
+*                                                                             *
+*   Output:         the number of candidates, in order of position, or -1     *
+*                   if memory is exhausted.                                   *
+*                                                                             *
+*   Notes:          An enzyme that already cuts the sequence once can only    *
+*                   use that site, on either strand and with no edits; one    *
+*                   that cuts it more than once has none.                     *
+*                                                                             *
+******************************************************************************/
+
+static int Candidates(const DATABASE *db, const SCAN *scan, const char *na, int len,
+                      const char *aa, int re, int max_edits, CANDIDATE **cand)
+{
+    char win[10];
+    OUTPUT h;
+    const OUTPUT *hit;
+    int k, n = 0, nwin, edits, present, first = 0;
+
+    present = CountSites(EnzymeSite(db, re), na, len, &first);
+    if ((*cand = malloc((NumHits(scan) + 1) * sizeof(CANDIDATE))) == NULL)
+        return(-1);
+    if (present > 1)
+        return(0);
+    if (present == 1)
+    {
+        (*cand)[0].start = first;
+        (*cand)[0].edits = 0;
+        (*cand)[0].hit.pos = first / 3;
+        (*cand)[0].hit.number = (first % 3 + SITE_LEN - 1) / 3 + 1;
+        (*cand)[0].hit.frame = first % 3 + 1;
+        (*cand)[0].hit.re = re;
+        return(1);
+    }
+
+    for (k = 0; k < NumHits(scan); k++)
+    {
+        hit = GetHit(scan, k);
+        if (hit->re != re)
+            continue;
+
+        /* HitEdits on the codons of the site only, rather than on all of na */
+        nwin = len - 3 * hit->pos;
+        if (nwin > 9)
+            nwin = 9;
+        memcpy(win, &na[3 * hit->pos], nwin);
+        win[nwin] = '\0';
+        h = *hit;
+        h.pos = 0;
+        edits = HitEdits(db, win, &aa[hit->pos], &h);
+
+        if ((edits < 1) || (edits > max_edits))
+            continue;
+        (*cand)[n].start = 3 * hit->pos + hit->frame - 1;
+        (*cand)[n].edits = edits;
+        (*cand)[n].hit = *hit;
+        n++;
+    }
+    return(n);
+}
+
+/* the last start of the site before one at start: at least min_space bases
+   back, and on codons of its own, as the edits of each are costed alone */
+static int LastBefore(const DESIGN_SITE *site, int start)
+{
+    int last = start - site->min_space, codon = 3 * (start / 3) - SITE_LEN;
+
+    return((codon < last) ? codon : last);
+}
+
+/******************************************************************************
+*                                                                             *
+*   BestDesigns:    Sets the fewest edits of a design of the first enzymes    *
+*                   that ends at each candidate of the next one.              *
+*                                                                             *
+*   Input:          prev, nprev. candidates of the previous enzyme.           *
+*                   site. the distances allowed from the previous site.       *
+*                                                                             *
+*   Notes:          The window of previous candidates moves forward with the  *
+*                   candidate, and a deque keeps those in it whose best       *
+*                   can still be the smallest, so each pass is linear.        *
+*                                                                             *
+******************************************************************************/
+
+static void BestDesigns(const CANDIDATE *prev, int nprev, CANDIDATE *cand, int ncand,
+                        const DESIGN_SITE *site, int *deque)
+{
+    int c, next = 0, head = 0, tail = 0, hi = site->max_space;
+
+    for (c = 0; c < ncand; c++)
+    {
+        while ((next < nprev) && (prev[next].start <= LastBefore(site, cand[c].start)))
+        {
+            if (prev[next].best < INT_MAX)
+            {
+                while ((tail > head) && (prev[deque[tail - 1]].best >= prev[next].best))
+                    tail--;
+                deque[tail++] = next;
+            }
+            next++;
+        }
+        while ((tail > head) && (prev[deque[head]].start < cand[c].start - hi))
+            head++;
+        cand[c].best = (tail > head) ? cand[c].edits + prev[deque[head]].best : INT_MAX;
+    }
+}
+
+static int Before(const SEARCH *s, int a, int b)
+{
+    if (s->node[a].prio != s->node[b].prio)
+        return(s->node[a].prio < s->node[b].prio);
+    return(a < b);
+}
+
+static int PushNode(SEARCH *s, int layer, int c, int edits, int prio, int parent)
+{
+    NODE *node;
+    int *heap, i, up;
+
+    if (s->nnodes == s->max_nodes)
+    {
+        s->max_nodes = s->max_nodes ? 2 * s->max_nodes : 1024;
+        if ((node = realloc(s->node, s->max_nodes * sizeof(NODE))) == NULL)
+            return(-1);
+        s->node = node;
+    }
+    if (s->nheap == s->max_heap)
+    {
+        s->max_heap = s->max_heap ? 2 * s->max_heap : 1024;
+        if ((heap = realloc(s->heap, s->max_heap * sizeof(int))) == NULL)
+            return(-1);
+        s->heap = heap;
+    }
+    s->node[s->nnodes].layer = layer;
+    s->node[s->nnodes].c = c;
+    s->node[s->nnodes].edits = edits;
+    s->node[s->nnodes].prio = prio;
+    s->node[s->nnodes].parent = parent;
+
+    for (i = s->nheap++; i > 0; i = up)
+    {
+        up = (i - 1) / 2;
+        if (!Before(s, s->nnodes, s->heap[up]))
+            break;
+        s->heap[i] = s->heap[up];
+    }
+    s->heap[i] = s->nnodes++;
+    return(0);
+}
+
+static int PopNode(SEARCH *s)
+{
+    int top = s->heap[0], last = s->heap[--s->nheap], i = 0, k;
+
+    while ((k = 2 * i + 1) < s->nheap)
+    {
+        if ((k + 1 < s->nheap) && Before(s, s->heap[k + 1], s->heap[k]))
+            k++;
+        if (!Before(s, s->heap[k], last))
+            break;
+        s->heap[i] = s->heap[k];
+        i = k;
+    }
+    s->heap[i] = last;
+    return(top);
+}
+
+/* first candidate starting at or after pos */
+static int FirstFrom(const CANDIDATE *cand, int n, int pos)
+{
+    int lo = 0, hi = n, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (cand[mid].start < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return(lo);
+}
+
+/******************************************************************************
+*                                                                             *
+*   AllCandidates:  Translates the whole codons of na, scans them and         *
+*                   collects the candidates of every enzyme of the design.    *
+*                                                                             *
+*   Output:         0 on success, -1 if memory is exhausted or dbase1 lacks   *
+*                   a codon.                                                  *
+*                                                                             *
+******************************************************************************/
+
+static int AllCandidates(const DATABASE *db, const char *na, int len,
+                         const DESIGN_SITE *site, int nsites, int max_edits,
+                         CANDIDATE **cand, int *ncand)
+{
+    SCAN *scan;
+    char *buf, *aa_str[16];
+    int i, ncodons = len / 3, status = -1;
+
+    aa_str[0] = NULL;
+    if ((buf = malloc(3 * ncodons + 1)) == NULL)
+        return(-1);
+    memcpy(buf, na, 3 * ncodons);
+    buf[3 * ncodons] = '\0';
+    if ((scan = NewScan(db)) != NULL)
+    {
+        /* a codon missing from dbase1 would shift the positions */
+        if ((ConvertNAToAA(db, buf, aa_str, 0) == 1) &&
+                ((int)strlen(aa_str[0]) == ncodons))
+        {
+            ScanForRE(scan, aa_str[0]);
+            for (i = 0; i < nsites; i++)
+            {
+                ncand[i] = Candidates(db, scan, na, len, aa_str[0], site[i].re, max_edits,
+                                      &cand[i]);
+                if (ncand[i] < 0)
+                    break;
+            }
+            status = (i == nsites) ? 0 : -1;
+        }
+        free(aa_str[0]);
+        FreeScan(scan);
+    }
+    free(buf);
+    return(status);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Search:         Lists the designs in order of edits.                      *
+*                                                                             *
+*   Output:         the number of designs, or -1 if memory is exhausted.      *
+*                                                                             *
+*   Notes:          A node is a candidate together with the sites chosen      *
+*                   after it.  Its priority adds the fewest edits of the      *
+*                   sites before it, which are exact, so the first complete   *
+*                   designs taken off the heap are the best ones.             *
+*                                                                             *
+******************************************************************************/
+
+static int Search(CANDIDATE **cand, const int *ncand, const DESIGN_SITE *site,
+                  int nsites, int max_edits, DESIGN *best, int nbest)
+{
+    SEARCH s;
+    NODE node;
+    int i, j, c, hi, n = 0;
+
+    memset(&s, 0, sizeof(s));
+    i = nsites - 1;
+    for (c = 0; c < ncand[i]; c++)
+    {
+        if ((cand[i][c].best <= max_edits) &&
+                (PushNode(&s, i, c, 0, cand[i][c].best, -1) < 0))
+            n = -1;
+    }
+
+    while ((n >= 0) && (n < nbest) && (s.nheap > 0))
+    {
+        j = PopNode(&s);
+        node = s.node[j];
+        i = node.layer;
+        if (i == 0)
+        {
+            best[n].edits = node.prio;
+            best[n].nsites = nsites;
+            for (; j >= 0; j = s.node[j].parent)
+            {
+                i = s.node[j].layer;
+                c = s.node[j].c;
+                best[n].start[i] = cand[i][c].start;
+                best[n].site_edits[i] = cand[i][c].edits;
+                best[n].hit[i] = cand[i][c].hit;
+            }
+            n++;
+            continue;
+        }
+
+        /* the previous sites that fit before this one */
+        node.edits += cand[i][node.c].edits;
+        hi = LastBefore(&site[i], cand[i][node.c].start);
+        c = FirstFrom(cand[i - 1], ncand[i - 1], cand[i][node.c].start - site[i].max_space);
+        for (; (n >= 0) && (c < ncand[i - 1]) && (cand[i - 1][c].start <= hi); c++)
+        {
+            if ((cand[i - 1][c].best <= max_edits - node.edits) &&
+                    (PushNode(&s, i - 1, c, node.edits, node.edits + cand[i - 1][c].best,
+                              j) < 0))
+                n = -1;
+        }
+    }
+    free(s.node);
+    free(s.heap);
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   DesignSites:    Finds the designs that introduce a site of each of        *
+*                   several enzymes with the fewest base changes.             *
+*                                                                             *
+*   Input:          na. nucleic acid sequence, as normalized by Check_Input;  *
+*                   it is read in reading frame 1, without a partial codon.   *
+*                   site, nsites. the enzymes in order along the sequence,    *
+*                   each one different, and the distance of each from the     *
+*                   previous one.                                             *
+*                   max_edits. most base changes of a design, -1 for any.     *
+*                   best, nbest. where to put the designs, and how many.      *
+*                                                                             *
+*   Output:         number of designs found, at most nbest, in order of       *
+*                   edits, or -1 on invalid arguments, on exhausted memory    *
+*                   or if dbase1 does not code for all 64 codons.             *
+*                                                                             *
+*   Notes:          Every enzyme cuts the designed sequence only once: it is  *
+*                   either introduced where it did not cut, or kept at the    *
+*                   one site where it did.  Two sites share no codon, so      *
+*                   each is made by the fewest changes to its own codons;     *
+*                   whether those create other sites is not checked.          *
+*                                                                             *
+******************************************************************************/
+
+int DesignSites(const DATABASE *db, const char *na, const DESIGN_SITE *site, int nsites,
+                int max_edits, DESIGN *best, int nbest)
+{
+    CANDIDATE *cand[MAX_DESIGN];
+    int ncand[MAX_DESIGN];
+    int i, j, c, len, *deque, n = -1;
+
+    if ((nsites < 1) || (nsites > MAX_DESIGN))
+        return(-1);
+    for (i = 0; i < nsites; i++)
+    {
+        if ((site[i].re < 0) || (site[i].re >= NumEnzymes(db)))
+            return(-1);
+        for (j = 0; j < i; j++)
+        {
+            if (site[j].re == site[i].re)
+                return(-1);
+        }
+    }
+    if (max_edits < 0)
+        max_edits = INT_MAX - 1;
+    if ((len = strlen(na)) < 3)
+        return(0);
+
+    memset(cand, 0, sizeof(cand));
+    if (AllCandidates(db, na, len, site, nsites, max_edits, cand, ncand) == 0)
+    {
+        /* Fewest edits of the designs ending at each candidate */
+        for (c = 0; c < ncand[0]; c++)
+            cand[0][c].best = cand[0][c].edits;
+        for (i = 1; i < nsites; i++)
+        {
+            if ((deque = malloc((ncand[i - 1] + 1) * sizeof(int))) == NULL)
+                break;
+            BestDesigns(cand[i - 1], ncand[i - 1], cand[i], ncand[i], &site[i], deque);
+            free(deque);
+        }
+        if (i == nsites)
+            n = Search(cand, ncand, site, nsites, max_edits, best, nbest);
+    }
+
+    for (i = 0; i < nsites; i++)
+        free(cand[i]);
+    return(n);
+}
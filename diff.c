@@ -0,0 +1,461 @@
+/****************************************************************************
+*                                                                           *
+*       diff: the sites gained and lost by editing a nucleic acid           *
+*       sequence, e.g. a construct before and after a mutagenesis.          *
+*                                                                           *
+*       The two versions are aligned cheaply, as they are mostly the same:  *
+*       they are read together until they differ, and the shortest edit     *
+*       after which they agree again for DIFF_ANCHOR bases gives a window   *
+*       of change, so each substitution, insertion or deletion has its own. *
+*       Only the sites that can reach into a window are looked for, in      *
+*       each version, and the two lists are merged with the bases of one    *
+*       mapped onto the other.  A site is either one that can be            *
+*       introduced by silent mutations (a ScanForRE hit) or a recognition   *
+*       sequence that is there already, on either strand.                   *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+#define DIFF_ANCHOR     16      /* bases that agree after an edit; edits  */
+                                /* closer than this share a window        */
+#define DIFF_SHIFT      64      /* longest edit looked for, in bases      */
+
+typedef struct
+{
+    long pos;                   /* first base of the site               */
+    int re;
+} SITE;
+
+typedef struct
+{
+    SITE *site;
+    long n, cap;
+} SITES;
+
+typedef struct
+{
+    long a0, a1;                /* changed bases of the first version   */
+    long b0, b1;                /* and those of the second              */
+} WINDOW;
+
+typedef struct
+{
+    DIFF *diff;
+    long n, cap;
+} DIFFS;
+
+static int AddSite(SITES *s, long pos, int re)
+{
+    SITE *p;
+
+    if (s->n == s->cap)
+    {
+        if ((p = realloc(s->site, (2 * s->cap + 64) * sizeof(SITE))) == NULL)
+            return(-1);
+        s->site = p;
+        s->cap = 2 * s->cap + 64;
+    }
+    s->site[s->n].pos = pos;
+    s->site[s->n++].re = re;
+    return(0);
+}
+
+static int AddDiff(DIFFS *d, int change, int kind, long pos, int re)
+{
+    DIFF *p;
+
+    if (d->n == d->cap)
+    {
+        if ((p = realloc(d->diff, (2 * d->cap + 64) * sizeof(DIFF))) == NULL)
+            return(-1);
+        d->diff = p;
+        d->cap = 2 * d->cap + 64;
+    }
+    d->diff[d->n].change = change;
+    d->diff[d->n].kind = kind;
+    d->diff[d->n].pos = pos;
+    d->diff[d->n++].re = re;
+    return(0);
+}
+
+/* the recognition sequences starting in [from, to), by position and enzyme */
+static int PresentSites(const SITE_TABLE *t, const char *na, long len, long from, long to,
+                        SITES *s)
+{
+    const uint64_t *bits;
+    uint64_t w;
+    long i;
+    int k, b;
+
+    if (from < 0)
+        from = 0;
+    if (to > len - SITE_LEN + 1)
+        to = len - SITE_LEN + 1;
+    for (i = from; i < to; i++)
+    {
+        bits = SiteBits(t, SiteCode(&na[i]));
+        for (k = 0; k < SiteWords(t); k++)
+        {
+            for (w = bits[k]; w; w &= w - 1)
+            {
+                for (b = 0; !((w >> b) & 1); b++)
+                    ;
+                if (AddSite(s, i, k * 64 + b) < 0)
+                    return(-1);
+            }
+        }
+    }
+    return(0);
+}
+
+/* the sites of the motif positions [from, to), by first base and enzyme */
+static int SilentSites(const DATABASE *db, const char *aa, long from, long to, SITES *s)
+{
+    CURSOR cur;
+    OUTPUT hit;
+
+    OpenCursor(&cur, db, aa, from < 0 ? 0 : (int)from, (int)to);
+    while (NextHit(&cur, &hit))
+    {
+        if (AddSite(s, 3L * hit.pos + hit.frame - 1, hit.re) < 0)
+            return(-1);
+    }
+    return(0);
+}
+
+/* the base of the second version at base x of the first, -1 if changed */
+static long MapBase(const WINDOW *w, long nw, long x)
+{
+    long lo = 0, hi = nw, mid;
+
+    /* the last window starting at or before x */
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (w[mid].a0 <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return(x);
+    w += lo - 1;
+    if (x >= w->a1)
+        return(x - w->a1 + w->b1);
+    if (w->a1 - w->a0 == w->b1 - w->b0)
+        return(x - w->a0 + w->b0);
+    return(-1);
+}
+
+/* merges the sites of the two versions in a window into gains and losses */
+static int Compare(const WINDOW *w, long nw, int kind, const SITES *a, const SITES *b,
+                   DIFFS *d)
+{
+    long i = 0, j = 0, x;
+    int status = 0;
+
+    while ((status == 0) && ((i < a->n) || (j < b->n)))
+    {
+        x = (i < a->n) ? MapBase(w, nw, a->site[i].pos) : -1;
+        if ((i < a->n) && (x < 0))
+        {
+            status = AddDiff(d, -1, kind, a->site[i].pos, a->site[i].re);
+            i++;
+        }
+        else if ((i < a->n) && (j < b->n) && (x == b->site[j].pos) &&
+                 (a->site[i].re == b->site[j].re))
+        {
+            i++;
+            j++;
+        }
+        else if ((i < a->n) && ((j == b->n) || (x < b->site[j].pos) ||
+                                ((x == b->site[j].pos) && (a->site[i].re < b->site[j].re))))
+        {
+            status = AddDiff(d, -1, kind, a->site[i].pos, a->site[i].re);
+            i++;
+        }
+        else
+        {
+            status = AddDiff(d, 1, kind, b->site[j].pos, b->site[j].re);
+            j++;
+        }
+    }
+    return(status);
+}
+
+/* the translation of the whole codons, or NULL if memory is exhausted */
+static char *Translate(const DATABASE *db, const char *na, long len)
+{
+    char *aa[16], *str;
+    size_t bad;
+    int i, n;
+
+    if (len < 3)
+        return(calloc(1, 1));
+    if ((n = ConvertRawNAToAA(db, na, len, aa, &bad)) <= 0)
+        return(NULL);
+    str = aa[0];
+    str[len / 3] = '\0';
+    for (i = 1; i < n; i++)
+        free(aa[i]);
+    return(str);
+}
+
+static int CompareDiffs(const void *a, const void *b)
+{
+    const DIFF *x = a, *y = b;
+
+    if (x->pos != y->pos)
+        return(x->pos < y->pos ? -1 : 1);
+    if (x->change != y->change)
+        return(x->change < y->change ? -1 : 1);
+    if (x->kind != y->kind)
+        return(x->kind < y->kind ? -1 : 1);
+    return((x->re > y->re) - (x->re < y->re));
+}
+
+/* orders sites by position, kind and enzyme, whether gained or lost */
+static int CompareSame(const void *a, const void *b)
+{
+    const DIFF *x = a, *y = b;
+
+    if (x->pos != y->pos)
+        return(x->pos < y->pos ? -1 : 1);
+    if (x->kind != y->kind)
+        return(x->kind < y->kind ? -1 : 1);
+    return((x->re > y->re) - (x->re < y->re));
+}
+
+/* 1 if the versions agree for DIFF_ANCHOR bases from i and j, or to both ends */
+static int Anchored(const char *wt, long la, long i, const char *mut, long lb, long j)
+{
+    if ((i > la) || (j > lb))
+        return(0);
+    if ((la - i < DIFF_ANCHOR) || (lb - j < DIFF_ANCHOR))
+        return((la - i == lb - j) && !memcmp(&wt[i], &mut[j], la - i));
+    return(!memcmp(&wt[i], &mut[j], DIFF_ANCHOR));
+}
+
+/* the shortest edit from the differing bases i and j after which the versions
+   agree again, as its length in each, or 0 if there is none within DIFF_SHIFT */
+static int Edit(const char *wt, long la, long i, const char *mut, long lb, long j, long *di,
+                long *dj)
+{
+    long s, m;
+
+    for (s = 1; s <= DIFF_SHIFT; s++)
+    {
+        for (m = s; m >= 0; m--)
+        {
+            *di = s;
+            *dj = m;
+            if (Anchored(wt, la, i + s, mut, lb, j + m))
+                return(1);
+            *di = m;
+            *dj = s;
+            if ((m < s) && Anchored(wt, la, i + m, mut, lb, j + s))
+                return(1);
+        }
+    }
+    return(0);
+}
+
+/* the windows of change, one per edit, in order */
+static long Windows(const char *wt, long la, const char *mut, long lb, WINDOW **win)
+{
+    WINDOW *w = NULL, *p;
+    long i = 0, j = 0, n = 0, cap = 0, di, dj, suf;
+
+    while ((i < la) || (j < lb))
+    {
+        if ((i < la) && (j < lb) && (wt[i] == mut[j]))
+        {
+            i++;
+            j++;
+            continue;
+        }
+        if (n == cap)
+        {
+            if ((p = realloc(w, (2 * cap + 16) * sizeof(WINDOW))) == NULL)
+            {
+                free(w);
+                return(-1);
+            }
+            w = p;
+            cap = 2 * cap + 16;
+        }
+
+        /* the rest is one window if the versions do not come back in step */
+        if (!Edit(wt, la, i, mut, lb, j, &di, &dj))
+        {
+            for (suf = 0; (i + suf < la) && (j + suf < lb) &&
+                    (wt[la - 1 - suf] == mut[lb - 1 - suf]); suf++)
+                ;
+            di = la - suf - i;
+            dj = lb - suf - j;
+        }
+        w[n].a0 = i;
+        w[n].a1 = i + di;
+        w[n].b0 = j;
+        w[n++].b1 = j + dj;
+        i += di;
+        j += dj;
+    }
+    *win = w;
+    return(n);
+}
+
+/* drops the lost and gained sites of an enzyme that are at bases mapped onto
+   each other, as a window ending out of frame can give at its neighbour */
+static int Cancel(const WINDOW *w, long nw, DIFFS *d)
+{
+    DIFF *lost, key, *p;
+    long k, n = 0, m = 0;
+
+    if ((lost = malloc((d->n + 1) * sizeof(DIFF))) == NULL)
+        return(-1);
+    for (k = 0; k < d->n; k++)
+    {
+        if ((d->diff[k].change < 0) && ((key.pos = MapBase(w, nw, d->diff[k].pos)) >= 0))
+        {
+            lost[n] = d->diff[k];
+            lost[n].pos = key.pos;
+            lost[n++].change = (int)k;
+        }
+    }
+    if (n > 1)
+        qsort(lost, n, sizeof(DIFF), CompareSame);
+    for (k = 0; k < d->n; k++)
+    {
+        key = d->diff[k];
+        if ((key.change < 0) || (n == 0))
+            continue;
+        if ((p = bsearch(&key, lost, n, sizeof(DIFF), CompareSame)) != NULL)
+        {
+            d->diff[p->change].change = 0;
+            d->diff[k].change = 0;
+        }
+    }
+    for (k = 0; k < d->n; k++)
+    {
+        if (d->diff[k].change != 0)
+            d->diff[m++] = d->diff[k];
+    }
+    d->n = m;
+    free(lost);
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   DiffSites:      Finds the sites gained and lost between two versions of   *
+*                   a nucleic acid sequence.                                  *
+*                                                                             *
+*   Input:          t. from NewSiteTable.                                     *
+*                   wt, mut. the versions, as normalized by ValidateInput.    *
+*                   diff. set to the gains and losses, by position; the       *
+*                   caller frees it.                                          *
+*                                                                             *
+*   Output:         the number of gains and losses, or -1 if memory is        *
+*                   exhausted.                                                *
+*                                                                             *
+*   Notes:          A site of the first version is lost unless the second     *
+*                   has the same enzyme at the mapped base, and gained the    *
+*                   other way round.  Bases between windows of change are    *
+*                   moved by the changes of length before them; the bases     *
+*                   inside a window are changed, unless it keeps its length.  *
+*                   An insertion or deletion is placed as far right as the    *
+*                   bases allow.  Both versions are translated in the first   *
+*                   frame, so a change of length that is not a multiple of    *
+*                   three changes the silent sites up to the next window.     *
+*                                                                             *
+******************************************************************************/
+
+long DiffSites(const DATABASE *db, const SITE_TABLE *t, const char *wt, const char *mut,
+               DIFF **diff)
+{
+    long la = strlen(wt), lb = strlen(mut), nw, k, r0, r1, q0, q1;
+    char *aa_wt = Translate(db, wt, la), *aa_mut = Translate(db, mut, lb);
+    SITES a, b;
+    DIFFS d;
+    WINDOW *w = NULL;
+    int status = -1;
+
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    memset(&d, 0, sizeof(d));
+    if ((aa_wt != NULL) && (aa_mut != NULL) && ((nw = Windows(wt, la, mut, lb, &w)) >= 0))
+    {
+        for (k = 0, status = 0; (k < nw) && (status == 0); k++)
+        {
+            a.n = b.n = 0;
+            status = PresentSites(t, wt, la, w[k].a0 - SITE_LEN + 1, w[k].a1, &a) |
+                     PresentSites(t, mut, lb, w[k].b0 - SITE_LEN + 1, w[k].b1, &b);
+            if (status == 0)
+                status = Compare(w, nw, DIFF_SITE, &a, &b, &d);
+
+            /* the motifs reaching the changed residues, and those up to the
+               next window if the codons after this one are out of frame */
+            r0 = w[k].a0 / 3 - 2;
+            r1 = (w[k].a1 + 2) / 3;
+            q0 = w[k].b0 / 3 - 2;
+            q1 = (w[k].b1 + 2) / 3;
+            if ((w[k].b1 - w[k].a1) % 3 != 0)
+            {
+                r1 = (k + 1 < nw) ? w[k + 1].a0 / 3 - 2 : la / 3;
+                q1 = (k + 1 < nw) ? w[k + 1].b0 / 3 - 2 : lb / 3;
+            }
+            a.n = b.n = 0;
+            if (status == 0)
+                status = SilentSites(db, aa_wt, r0, r1, &a) |
+                         SilentSites(db, aa_mut, q0, q1, &b);
+            if (status == 0)
+                status = Compare(w, nw, DIFF_SILENT, &a, &b, &d);
+        }
+        if (status == 0)
+            status = Cancel(w, nw, &d);
+    }
+    free(aa_wt);
+    free(aa_mut);
+    free(w);
+    free(a.site);
+    free(b.site);
+    if (status < 0)
+    {
+        free(d.diff);
+        return(-1);
+    }
+    if (d.n > 1)
+        qsort(d.diff, d.n, sizeof(DIFF), CompareDiffs);
+    *diff = d.diff;
+    return(d.n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintDiff:      Writes the gains and losses of DiffSites as rows of a     *
+*                   tab separated table.                                      *
+*                                                                             *
+*   Output:         the number of characters written.                         *
+*                                                                             *
+*   Notes:          The position is counted from 1, in the first version for  *
+*                   a lost site and in the second for a gained one.           *
+*                                                                             *
+******************************************************************************/
+
+int PrintDiff(const DATABASE *db, const DIFF *diff, long n, const char *name, FILE *fp)
+{
+    long k;
+    int c = 0;
+
+    for (k = 0; k < n; k++)
+        c += fprintf(fp, "%s\t%s\t%s\t%ld\t%s\t%s\n", name,
+                     (diff[k].change > 0) ? "gained" : "lost",
+                     (diff[k].kind == DIFF_SITE) ? "site" : "silent", diff[k].pos + 1,
+                     EnzymeName(db, diff[k].re), EnzymeSite(db, diff[k].re));
+    return(c);
+}
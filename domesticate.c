@@ -0,0 +1,259 @@
+/****************************************************************************
+*                                                                           *
+*       domesticate: removes the recognition sequences a coding sequence    *
+*       already holds, on either strand, by synonymous codon changes, e.g.  *
+*       the BsaI and BsmBI sites of a part for Golden Gate assembly.        *
+*                                                                           *
+*       The sites are found with the six-mer table of sites.c and taken     *
+*       from left to right.  For each, every synonymous choice of the two   *
+*       or three codons it covers is tried, and the one with the fewest     *
+*       base changes that leaves no site at its place and gives no six-mer  *
+*       around the codons an enzyme it did not have is kept.  So a site     *
+*       costs at most 6 x 6 x 6 choices of a few table lookups each, and a  *
+*       whole pathway of genes takes milliseconds.                          *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+#define MAX_SYNONYMS    6       /* codons of one amino acid, at most    */
+#define SPAN_CODONS     3       /* codons a six base site can cover     */
+#define SPAN_BASES      (3 * SPAN_CODONS + 2 * (SITE_LEN - 1))
+
+static const char bases[5] = "ACGT";
+
+typedef struct
+{
+    const SITE_TABLE *t;
+    char syn[64][MAX_SYNONYMS][4];  /* synonymous codons of each codon  */
+    int nsyn[64];
+} SYNONYMS;
+
+/* 2-bit code of a codon, or -1 */
+static int CodonCode(const char *na)
+{
+    const char *p;
+    int i, code = 0;
+
+    for (i = 0; i < 3; i++)
+    {
+        if ((na[i] == '\0') || ((p = strchr(bases, na[i])) == NULL))
+            return(-1);
+        code = (code << 2) | (int)(p - bases);
+    }
+    return(code);
+}
+
+static void FindSynonyms(const DATABASE *db, SYNONYMS *s)
+{
+    int c, d, aa;
+
+    for (c = 0; c < 64; c++)
+    {
+        s->nsyn[c] = 0;
+        aa = CodonAminoAcid(db, c);
+        for (d = 0; (d < 64) && (s->nsyn[c] < MAX_SYNONYMS); d++)
+        {
+            if ((d != c) && (!aa || (CodonAminoAcid(db, d) != aa)))
+                continue;
+            s->syn[c][s->nsyn[c]][0] = bases[d >> 4];
+            s->syn[c][s->nsyn[c]][1] = bases[(d >> 2) & 3];
+            s->syn[c][s->nsyn[c]][2] = bases[d & 3];
+            s->syn[c][s->nsyn[c]++][3] = '\0';
+        }
+    }
+}
+
+/* 1 if the six-mer at na is the site of some enzyme */
+static int AnySite(const SITE_TABLE *t, const char *na)
+{
+    const uint64_t *bits = SiteBits(t, SiteCode(na));
+    int k;
+
+    for (k = 0; k < SiteWords(t); k++)
+        if (bits[k])
+            return(1);
+    return(0);
+}
+
+/* 1 if some six-mer starting in [from, to) of buf has an enzyme that the same
+   six-mer of old has not, or the one at target has any */
+static int Spoiled(const SYNONYMS *s, const char *old, const char *buf, int from, int to,
+                   int target)
+{
+    const uint64_t *before, *after;
+    int w, k, nwords = SiteWords(s->t);
+
+    for (w = from; w < to; w++)
+    {
+        after = SiteBits(s->t, SiteCode(&buf[w]));
+        before = SiteBits(s->t, SiteCode(&old[w]));
+        for (k = 0; k < nwords; k++)
+        {
+            if ((after[k] & ~before[k]) || ((w == target) && after[k]))
+                return(1);
+        }
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RemoveSite:     Changes the codons under the site at base s to the        *
+*                   synonymous ones with the fewest base changes that remove  *
+*                   it without creating another.                              *
+*                                                                             *
+*   Input:          c0, c1. the first and last whole codon under the site.    *
+*                                                                             *
+*   Output:         the number of base changes, or -1 if there is no such     *
+*                   choice and na is left as it was.                          *
+*                                                                             *
+******************************************************************************/
+
+static int RemoveSite(const SYNONYMS *s, char *na, long len, long s0, long c0, long c1)
+{
+    char old[SPAN_BASES + 1], buf[SPAN_BASES + 1], best[SPAN_BASES + 1];
+    int pick[SPAN_CODONS], code[SPAN_CODONS], n = (int)(c1 - c0 + 1);
+    int i, k, edits, min = -1, from, to;
+    long lo = 3 * c0 - (SITE_LEN - 1), hi = 3 * c1 + 3 + SITE_LEN - 1;
+
+    if (lo < 0)
+        lo = 0;
+    if (hi > len)
+        hi = len;
+    memcpy(old, &na[lo], hi - lo);
+    old[hi - lo] = '\0';
+    for (i = 0; i < n; i++)
+    {
+        pick[i] = 0;
+        code[i] = CodonCode(&na[3 * (c0 + i)]);
+    }
+
+    /* the six-mers holding a base of the codons */
+    from = (int)((3 * c0 - (SITE_LEN - 1) < lo) ? 0 : 3 * c0 - (SITE_LEN - 1) - lo);
+    to = (int)(hi - lo) - SITE_LEN + 1;
+
+    /* every synonymous choice, as a counter over the codons */
+    while (1)
+    {
+        memcpy(buf, old, hi - lo + 1);
+        for (i = 0, edits = 0; i < n; i++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                buf[3 * (c0 + i) - lo + k] = s->syn[code[i]][pick[i]][k];
+                edits += (buf[3 * (c0 + i) - lo + k] != old[3 * (c0 + i) - lo + k]);
+            }
+        }
+        if ((edits > 0) && ((min < 0) || (edits < min)) &&
+                !Spoiled(s, old, buf, from, to, (int)(s0 - lo)))
+        {
+            min = edits;
+            memcpy(best, buf, hi - lo + 1);
+        }
+        for (i = 0; (i < n) && (++pick[i] == s->nsyn[code[i]]); i++)
+            pick[i] = 0;
+        if (i == n)
+            break;
+    }
+    if (min > 0)
+        memcpy(&na[lo], best, hi - lo);
+    return(min);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Domesticate:    Removes the recognition sequences of a coding sequence    *
+*                   by synonymous codon changes.                              *
+*                                                                             *
+*   Input:          na. the sequence, as normalized by ValidateInput and read *
+*                   in the first reading frame; changed in place.             *
+*                   site. set to the sites na had, by position and enzyme;    *
+*                   the caller frees it.                                      *
+*                                                                             *
+*   Output:         the number of sites, or -1 if memory is exhausted.        *
+*                                                                             *
+*   Notes:          The sites are taken from left to right, so the edits for  *
+*                   one may remove the next as well.  A site is kept if its   *
+*                   codons have no synonymous choice that removes it without  *
+*                   creating another, e.g. under Met and Trp codons or the    *
+*                   partial last codon.  No edit ever creates a site, so the  *
+*                   sites of the result are some of those of na.              *
+*                                                                             *
+******************************************************************************/
+
+long Domesticate(const DATABASE *db, const SITE_TABLE *t, char *na, DOMESTIC **site)
+{
+    long len = strlen(na), s, c0, c1, n = 0, cap = 0, i, k, next;
+    const uint64_t *bits;
+    uint64_t w;
+    SYNONYMS *syn;
+    DOMESTIC *d = NULL, *p;
+    int b, edits;
+
+    if ((syn = malloc(sizeof(SYNONYMS))) == NULL)
+        return(-1);
+    syn->t = t;
+    FindSynonyms(db, syn);
+
+    /* the sites na has, before any edit */
+    for (s = 0; s + SITE_LEN <= len; s++)
+    {
+        bits = SiteBits(t, SiteCode(&na[s]));
+        for (k = 0; k < SiteWords(t); k++)
+        {
+            for (w = bits[k]; w; w &= w - 1)
+            {
+                for (b = 0; !((w >> b) & 1); b++)
+                    ;
+                if (n == cap)
+                {
+                    if ((p = realloc(d, (2 * cap + 16) * sizeof(DOMESTIC))) == NULL)
+                    {
+                        free(d);
+                        free(syn);
+                        return(-1);
+                    }
+                    d = p;
+                    cap = 2 * cap + 16;
+                }
+                d[n].pos = s;
+                d[n].re = (int)k * 64 + b;
+                d[n++].edits = -1;
+            }
+        }
+    }
+
+    /* remove them a position at a time, unless gone already */
+    for (k = 0; k < n; k = next)
+    {
+        s = d[k].pos;
+        for (next = k; (next < n) && (d[next].pos == s); next++)
+            ;
+        c0 = s / 3;
+        c1 = (s + SITE_LEN - 1) / 3;
+        if (c1 >= len / 3)
+            c1 = len / 3 - 1;
+        if ((c0 > c1) || !AnySite(t, &na[s]))
+            continue;
+        if ((edits = RemoveSite(syn, na, len, s, c0, c1)) > 0)
+        {
+            for (i = k; i < next; i++)
+                d[i].edits = edits;
+        }
+    }
+
+    /* a site removed by the edits for another needed none of its own */
+    for (k = 0; k < n; k++)
+    {
+        bits = SiteBits(t, SiteCode(&na[d[k].pos]));
+        if ((d[k].edits < 0) && !((bits[d[k].re / 64] >> (d[k].re % 64)) & 1))
+            d[k].edits = 0;
+    }
+    free(syn);
+    *site = d;
+    return(n);
+}
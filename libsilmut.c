@@ -0,0 +1,2430 @@
+/****************************************************************************
+*                                                                           *
+*       libsilmut: the SILMUT engine.  Reads the codon and Restriction      *
+*       Enzyme databases, translates nucleic acid sequences and scans       *
+*       amino acid sequences for the potential mutation sites.              *
+*       Author: K Vijayananda, Department of Computer Science,              *
+*       University of Maryland, College Park, MD 20740                      *
+****************************************************************************/
+#include <stdio.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "silmut.h"
+
+#define RE_CHUNK    100
+#define MAX_MS   200
+
+typedef struct
+{
+    char f_aa[20];
+    char s_aa[20];
+    char t_aa[20];
+} RF;
+
+typedef struct
+{
+    char name[45];
+    char na[7];
+} RE;
+
+typedef struct
+{
+    char nucleic_acid[4];
+    char aa;
+} AA;
+
+struct DATABASE
+{
+    RF *f_rf, *s_rf, *t_rf;
+    RE *res_enzyme;
+    int nre, max_re;
+    AA amino_acid[MAX_NO_AA];
+    int naa;
+    char valid_aa[MAX_NO_AA + 1];
+
+    /* Compiled tables: mask[frame][slot][c] is the set of Restriction
+       Enzymes whose motif in that reading frame allows amino acid c at
+       that slot, nwords 64-bit words per set.  codon_aa is indexed by
+       the 2-bit coded codon.  char_class holds the CL_ bits of every
+       input character and aa_letters the valid amino acids among A-Z. */
+    uint64_t *mask;
+    int nwords;
+    char codon_aa[64];
+    unsigned char char_class[256];
+    uint32_t aa_letters;
+    uint64_t fingerprint;   /* hash of the codons and enzymes        */
+
+    /* Codon usage, if loaded: USAGE(db, re, frame, slot, c) is -ln w of
+       the best adapted codon for amino acid c at that slot of the motif
+       of the enzyme, w being its usage relative to the most used
+       synonymous codon. */
+    float *usage;
+};
+
+#define CL_BASE     1       /* A, C, G or T in either case           */
+#define CL_AA       2       /* valid amino acid in either case       */
+#define CL_SKIP     4       /* white space and digits, dropped       */
+#define CL_LOWER    8
+
+#define MASK(db, frame, slot, c) \
+    ((db)->mask + ((((frame) - 1) * 3 + (slot)) * 256 + (c)) * (db)->nwords)
+
+#define USAGE(db, re, frame, slot, c) \
+    ((db)->usage[(((re) * 3 + (frame) - 1) * 3 + (slot)) * 26 + (c) - 'A'])
+
+#define MIN_ADAPTIVENESS    0.01    /* w of unused codons            */
+
+struct SCAN
+{
+    const DATABASE *db;
+    OUTPUT *out;
+    int nout, max_out;
+};
+
+static const char base[5] = { 'A', 'C', 'G', 'T', '\0' };
+
+/******************************************************************************
+*                                                                             *
+*   BaseCode:       2-bit code of a base (A 0, C 1, G 2, T 3), -1 otherwise.  *
+*                                                                             *
+******************************************************************************/
+
+static int BaseCode(int c)
+{
+    switch (c)
+    {
+    case 'A':
+        return(0);
+    case 'C':
+        return(1);
+    case 'G':
+        return(2);
+    case 'T':
+        return(3);
+    default:
+        return(-1);
+    }
+}
+
+#define HASH_K1     0x87c37b91114253d5ULL
+#define HASH_K2     0x4cf5ad432745937fULL
+
+static uint64_t RotL(uint64_t x, int r)
+{
+    return((x << r) | (x >> (64 - r)));
+}
+
+/* final mixing of a 64-bit hash, so that every input bit affects every bit */
+static uint64_t Mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return(h);
+}
+
+static uint64_t HashBytes(uint64_t h, const char *str, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        h = (h ^ (unsigned char)str[i]) * 0x100000001b3ULL;
+    return(h);
+}
+
+static int LowBit(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return(__builtin_ctzll(bits));
+#else
+    int n = 0;
+
+    while (!(bits & 1))
+    {
+        bits >>= 1;
+        n++;
+    }
+    return(n);
+#endif
+}
+
+static void First_Rf(DATABASE *db, char *str, int n);
+static void Second_Rf(DATABASE *db, char *str, int n);
+static void Third_Rf(DATABASE *db, char *str, int n);
+
+/******************************************************************************
+*                                                                             *
+*   GrowDataBase:       Makes room for RE_CHUNK more Restriction Enzymes.     *
+*                                                                             *
+*   Input:              db. database being read.                              *
+*                                                                             *
+*   Output:             0 on success, -1 if memory is exhausted.              *
+*                                                                             *
+******************************************************************************/
+
+static int GrowDataBase(DATABASE *db)
+{
+    int n = db->max_re + RE_CHUNK;
+    RF *f, *s, *t;
+    RE *re;
+
+    if ((f = realloc(db->f_rf, n * sizeof(RF))) == NULL)
+        return(-1);
+    db->f_rf = f;
+    if ((s = realloc(db->s_rf, n * sizeof(RF))) == NULL)
+        return(-1);
+    db->s_rf = s;
+    if ((t = realloc(db->t_rf, n * sizeof(RF))) == NULL)
+        return(-1);
+    db->t_rf = t;
+    if ((re = realloc(db->res_enzyme, n * sizeof(RE))) == NULL)
+        return(-1);
+    db->res_enzyme = re;
+
+    /* Initialize the reading frames */
+    memset(&db->f_rf[db->max_re], 0, RE_CHUNK * sizeof(RF));
+    memset(&db->s_rf[db->max_re], 0, RE_CHUNK * sizeof(RF));
+    memset(&db->t_rf[db->max_re], 0, RE_CHUNK * sizeof(RF));
+    memset(&db->res_enzyme[db->max_re], 0, RE_CHUNK * sizeof(RE));
+    db->max_re = n;
+
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadDataBase_RE:    Reads the nucleic acid recognition sequence for       *
+*                       the Restriction Enzymes from a file.                  *
+*                                                                             *
+*                                                                             *
+*   Input:              db. database whose codon table is already read.       *
+*                       fname. File containing the nucleic acid sequences     *
+*                       for the Restriction Enzymes.                          *
+*                                                                             *
+*   Output:             0 on success, -1 if the file cannot be read.          *
+*                                                                             *
+*   Notes:              This function reads the nucleic acid sequences for    *
+*                       for the restriction enzymes and generates the amino   *
+*                       acid motifs from each of the reading frame for each of*
+*                       the restriction enzymes. This information is used     *
+*                       later to determine potential sites for mutation in a  *
+*                       given or derived sequence of amino acids.             *
+*                                                                             *
+******************************************************************************/
+
+static int ReadDataBase_RE(DATABASE *db, const char *fname)
+{
+    int i, c;
+    FILE *fp;
+    char re[7];
+    char name[50];
+
+    /*  Open the file for reading the nucleic acid sequence of restriction enzymes */
+    if ((fp = fopen(fname, "r")) == (FILE *)NULL)
+        return(-1);
+
+    db->nre = 0;
+
+    /* read the nucleic acid sequence and name of each restriction enzyme */
+    c = fgetc(fp);
+    while (c != EOF)
+    {
+        i = 0;
+        while ((c != ' ') && (c != EOF))
+        {
+            if (i < 6)
+                re[i++] = c;
+            c = fgetc(fp);
+        }
+        re[i] = '\0';
+        for (; c == ' ';)
+            c = fgetc(fp);
+
+        i = 0;
+        while ((c != '\n') && (c != EOF))
+        {
+            if (i < 44)
+                name[i++] = c;
+            c = fgetc(fp);
+        }
+        name[i] = '\0';
+
+        for (; c == '\n';)
+            c = fgetc(fp);
+
+        if ((db->nre == db->max_re) && (GrowDataBase(db) < 0))
+        {
+            fclose(fp);
+            return(-1);
+        }
+
+        /* Generate the First reading frame */
+        First_Rf(db, re, db->nre);
+
+        /* Generate the Second reading frame */
+        Second_Rf(db, re, db->nre);
+
+        /* Generate the Third reading frame */
+        Third_Rf(db, re, db->nre);
+
+        /* Store the name and amino acid sequence of the RE */
+        strcpy(db->res_enzyme[db->nre].name, name);
+        strcpy(db->res_enzyme[db->nre].na, re);
+
+        db->nre++;
+    }
+    fclose(fp);
+    return(0);
+}
+
+
+/******************************************************************************
+*                                                                             *
+*   First_Rf:   Generates the amino acid motifs from the first reading frame  *
+*               for a Restriction Enzyme                                      *
+*                                                                             *
+*   Input:      nucleic acid sequence of a RE.                                *
+*                                                                             *
+*   Output:     None.                                                         *
+*                                                                             *
+*   Notes:      The first reading frame contains two amino acids for a        *
+*               six-base recognition sequence.  A single letter code          *
+*               corresponding to these amino acids are stored in              *
+*               the first reading frame.                                      *
+*                                                                             *
+******************************************************************************/
+
+static void First_Rf(DATABASE *db, char *str, int n)
+{
+    int i;
+    char str1[4], str2[4];
+    RF *f_rf = db->f_rf;
+    AA *amino_acid = db->amino_acid;
+
+    strncpy(str1, str, 3);
+    str1[3] = '\0';
+    strncpy(str2, &str[3], 3);
+    str2[3] = '\0';
+
+    /* Determine the first amino acid */
+
+    for (i = 0; i < MAX_NO_AA; i++)
+    {
+        if ((strcmp(amino_acid[i].nucleic_acid, str1)) == 0)
+        {
+            f_rf[n].f_aa[0] = amino_acid[i].aa;
+            f_rf[n].f_aa[1] = '\0';
+            break;
+        }
+    }
+
+    /* Determine the second amino acid */
+
+    for (i = 0; i < MAX_NO_AA; i++)
+    {
+        if ((strcmp(amino_acid[i].nucleic_acid, str2)) == 0)
+        {
+            f_rf[n].s_aa[0] = amino_acid[i].aa;
+            f_rf[n].s_aa[1] = '\0';
+            break;
+        }
+    }
+}
+
+/******************************************************************************
+*                                                                             *
+*   Second_Rf: Generates the amino acid motifs from the second reading frame  *
+*              for a Restriction Enzyme                                       *
+*   Input:     nucleic acid sequence of a RE.                                 *
+*                                                                             *
+*   Output:    None.                                                          *
+*                                                                             *
+*   Notes:     The second reading frame contains three amino acids for a      *
+*              six base recognition sequence. A single letter code            *
+*              corresponding to these amino acids are stored.                 *
+*                                                                             *
+******************************************************************************/
+
+static void Second_Rf(DATABASE *db, char *str, int n)
+{
+    int i, j;
+    char str1[4];
+    RF *s_rf = db->s_rf;
+    AA *amino_acid = db->amino_acid;
+
+    /* Determine the first amino acid */
+
+    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    {
+        if ((str[0] == amino_acid[i].nucleic_acid[1]) &&
+                (str[1] == amino_acid[i].nucleic_acid[2]))
+        {
+            if (!IsChIn(s_rf[n].f_aa, amino_acid[i].aa))
+                s_rf[n].f_aa[j++] = amino_acid[i].aa;
+        }
+    }
+    strncpy(str1, &str[2], 3);
+    str1[3] = '\0';
+
+    /* Determine the second amino acid */
+
+    for (i = 0; i < MAX_NO_AA; i++)
+    {
+        if ((strcmp(str1, amino_acid[i].nucleic_acid)) == 0)
+        {
+            s_rf[n].s_aa[0] = amino_acid[i].aa;
+            break;
+        }
+        s_rf[n].s_aa[1] = '\0';
+    }
+
+    /* Determine the third amino acid */
+
+    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    {
+        if (str[5] == amino_acid[i].nucleic_acid[0])
+        {
+            if (!IsChIn(s_rf[n].t_aa, amino_acid[i].aa))
+                s_rf[n].t_aa[j++] = amino_acid[i].aa;
+        }
+    }
+}
+
+/******************************************************************************
+*                                                                             *
+*   Third_Rf: Generates the amino acid motifs from the third reading frame    *
+*             for a Restriction Enzyme                                        *
+*   Input:    nucleic acid sequence of a RE.                                  *
+*                                                                             *
+*   Output:   None.                                                           *
+*                                                                             *
+*   Notes:    The third reading frame contains three amino acids for a        *
+*             six base recognition sequence. A single letter code             *
+*             corresponding to these amino acids are stored.                  *
+*                                                                             *
+******************************************************************************/
+
+
+static void Third_Rf(DATABASE *db, char *str, int n)
+{
+    int i, j;
+    char str1[4];
+    RF *t_rf = db->t_rf;
+    AA *amino_acid = db->amino_acid;
+
+    /* Determine the second amino acid */
+
+    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    {
+        if ((str[4] == amino_acid[i].nucleic_acid[0]) &&
+                (str[5] == amino_acid[i].nucleic_acid[1]))
+        {
+            if (!IsChIn(t_rf[n].t_aa, amino_acid[i].aa))
+                t_rf[n].t_aa[j++] = amino_acid[i].aa;
+        }
+    }
+
+    strncpy(str1, &str[1], 3);
+    str1[3] = '\0';
+
+    /* Determine the first  amino acid */
+
+    for (i = 0; i < MAX_NO_AA; i++)
+    {
+        if ((strcmp(str1, amino_acid[i].nucleic_acid)) == 0)
+        {
+            t_rf[n].s_aa[0] = amino_acid[i].aa;
+            break;
+        }
+        t_rf[n].s_aa[1] = '\0';
+    }
+
+    /* Determine the third  amino acid */
+
+    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    {
+        if (str[0] == amino_acid[i].nucleic_acid[2])
+        {
+            if (!IsChIn(t_rf[n].f_aa, amino_acid[i].aa))
+                t_rf[n].f_aa[j++] = amino_acid[i].aa;
+        }
+    }
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadDataBase_AA:    Reads the nucleic acid codons for all the amino       *
+*                       acids from a file.                                    *
+*                                                                             *
+*   Input:              db. database being read.                              *
+*                       fname. File containing the nucleic acid codons for    *
+*                       all amino acids.                                      *
+*                                                                             *
+*   Output:             0 on success, -1 if the file cannot be read.          *
+*                                                                             *
+*   Notes:              This function reads the nucleic acid codons and the   *
+*                       corresponding one letter code  all the amino acids.   *
+*                                                                             *
+******************************************************************************/
+
+static int ReadDataBase_AA(DATABASE *db, const char *fname)
+{
+    int i, j, c;
+    FILE *fp;
+    AA *amino_acid = db->amino_acid;
+
+    /*  Open the file for reading the nucleic acid codons and the corresponding
+    one letter code  for all amino acids */
+
+    if ((fp = fopen(fname, "r")) == (FILE *)NULL)
+        return(-1);
+
+    db->naa = 0;
+    j = 0;
+    db->valid_aa[0] = '\0';
+
+    c = fgetc(fp);
+    while ((c != EOF) && (db->naa < MAX_NO_AA))
+    {
+
+        i = 0;
+        while ((c != ' ') && (c != EOF))
+        {
+            if (i < 3)
+                amino_acid[db->naa].nucleic_acid[i++] = c;
+            c = fgetc(fp);
+        }
+        for (; c == ' ';)
+            c = fgetc(fp);
+
+        amino_acid[db->naa].aa = c;
+        if (!IsChIn(db->valid_aa, c))
+        {
+            db->valid_aa[j++] = c;
+            db->valid_aa[j] = '\0';
+        }
+
+        db->naa++;
+        c = fgetc(fp);
+        for (; c == '\n';)
+            c = fgetc(fp);
+    }
+    db->valid_aa[j] = '\0';
+    fclose(fp);
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CompileDataBase:    Builds the compiled scan tables from the amino acid   *
+*                       motifs and the codon table.                           *
+*                                                                             *
+*   Input:              db. database that has been read.                      *
+*                                                                             *
+*   Output:             0 on success, -1 if memory is exhausted.              *
+*                                                                             *
+*   Notes:              Scanning then tests all the Restriction Enzymes at a  *
+*                       position with a few word-wide ANDs instead of         *
+*                       searching the motif strings one enzyme at a time.     *
+*                                                                             *
+******************************************************************************/
+
+static int CompileDataBase(DATABASE *db)
+{
+    int i, j, frame, slot, code;
+    const char *set;
+
+    db->nwords = (db->nre + 63) / 64;
+    if (db->nwords == 0)
+        db->nwords = 1;
+
+    free(db->mask);
+    if ((db->mask = calloc((size_t)9 * 256 * db->nwords, sizeof(uint64_t))) == NULL)
+        return(-1);
+
+    for (j = 0; j < db->nre; j++)
+    {
+        for (frame = 1; frame <= 3; frame++)
+        {
+            for (slot = 0; slot < 3; slot++)
+            {
+                set = ReadingFrame(db, j, frame, slot);
+                for (i = 0; set[i]; i++)
+                    MASK(db, frame, slot, (unsigned char)set[i])[j / 64] |=
+                        (uint64_t)1 << (j % 64);
+            }
+        }
+    }
+
+    memset(db->codon_aa, 0, sizeof(db->codon_aa));
+    for (i = db->naa - 1; i >= 0; i--)
+    {
+        if ((BaseCode(db->amino_acid[i].nucleic_acid[0]) < 0) ||
+                (BaseCode(db->amino_acid[i].nucleic_acid[1]) < 0) ||
+                (BaseCode(db->amino_acid[i].nucleic_acid[2]) < 0))
+            continue;
+        code = BaseCode(db->amino_acid[i].nucleic_acid[0]) * 16 +
+               BaseCode(db->amino_acid[i].nucleic_acid[1]) * 4 +
+               BaseCode(db->amino_acid[i].nucleic_acid[2]);
+        db->codon_aa[code] = db->amino_acid[i].aa;
+    }
+
+    db->fingerprint = 0xcbf29ce484222325ULL;
+    for (i = 0; i < db->naa; i++)
+    {
+        db->fingerprint = HashBytes(db->fingerprint, db->amino_acid[i].nucleic_acid, 4);
+        db->fingerprint = HashBytes(db->fingerprint, &db->amino_acid[i].aa, 1);
+    }
+    for (j = 0; j < db->nre; j++)
+    {
+        db->fingerprint = HashBytes(db->fingerprint, db->res_enzyme[j].name,
+                                    strlen(db->res_enzyme[j].name) + 1);
+        db->fingerprint = HashBytes(db->fingerprint, db->res_enzyme[j].na,
+                                    strlen(db->res_enzyme[j].na) + 1);
+    }
+    db->fingerprint = Mix64(db->fingerprint);
+
+    db->aa_letters = 0;
+    for (i = 0; i < 256; i++)
+    {
+        code = toupper(i);
+        db->char_class[i] = 0;
+        if (isspace(i) || isdigit(i))
+            db->char_class[i] |= CL_SKIP;
+        if (islower(i))
+            db->char_class[i] |= CL_LOWER;
+        if (BaseCode(code) >= 0)
+            db->char_class[i] |= CL_BASE;
+        if ((code != 0) && IsChIn(db->valid_aa, code))
+        {
+            db->char_class[i] |= CL_AA;
+            if ((code >= 'A') && (code <= 'Z'))
+                db->aa_letters |= (uint32_t)1 << (code - 'A');
+        }
+    }
+
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadCodonUsage:     Reads the usage of each codon from a codon usage      *
+*                       table.                                                *
+*                                                                             *
+*   Input:              freq. set to the usage of each codon, by 2-bit code;  *
+*                       0 for a codon that is not in the table.               *
+*                                                                             *
+*   Output:             0 on success, -1 if the file cannot be read or lists  *
+*                       no codon.                                             *
+*                                                                             *
+*   Notes:              Each codon, in T or U, is followed by its usage,      *
+*                       maybe after its amino acid, so both one codon per     *
+*                       line and the four-column Kazusa tables can be read.   *
+*                       The usage may be a fraction, per thousand or a count. *
+*                                                                             *
+******************************************************************************/
+
+static int ReadCodonUsage(const char *fname, double freq[64])
+{
+    FILE *fp;
+    char word[64], *end;
+    int i, code, codon = -1, n = 0;
+    double f;
+
+    if ((fp = fopen(fname, "r")) == (FILE *)NULL)
+        return(-1);
+
+    memset(freq, 0, 64 * sizeof(double));
+    while (fscanf(fp, "%63s", word) == 1)
+    {
+        for (i = 0, code = 0; (i < 3) && (code >= 0); i++)
+        {
+            if (toupper((unsigned char)word[i]) == 'U')
+                code = code * 4 + 3;
+            else if (BaseCode(toupper((unsigned char)word[i])) >= 0)
+                code = code * 4 + BaseCode(toupper((unsigned char)word[i]));
+            else
+                code = -1;
+        }
+        if ((code >= 0) && (word[3] == '\0'))
+        {
+            codon = code;
+            continue;
+        }
+        f = strtod(word, &end);
+        if ((codon >= 0) && (end != word) && (f >= 0))
+        {
+            freq[codon] = f;
+            codon = -1;
+            n++;
+        }
+    }
+    fclose(fp);
+    return(n ? 0 : -1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   LoadCodonUsage:     Reads a codon usage table and compiles the cost of    *
+*                       the codons each site needs, for HitScore.             *
+*                                                                             *
+*   Input:              db. database from LoadDataBase, before the SCANs      *
+*                       that use it are made or it is shared between          *
+*                       threads.                                              *
+*                       fname. codon usage table of the host.                 *
+*                                                                             *
+*   Output:             0 on success, -1 if the file cannot be read or        *
+*                       memory is exhausted.                                  *
+*                                                                             *
+*   Notes:              The cost of a slot of a motif is that of the best     *
+*                       adapted codon that both codes for its amino acid and  *
+*                       agrees with the recognition sequence, so scoring a    *
+*                       site is a few table lookups.                          *
+*                                                                             *
+******************************************************************************/
+
+int LoadCodonUsage(DATABASE *db, const char *fname)
+{
+    double freq[64], best[256], cost[64];
+    int j, frame, slot, code, k, off, c;
+    float *usage;
+    const char *site;
+
+    if (ReadCodonUsage(fname, freq) < 0)
+        return(-1);
+
+    memset(best, 0, sizeof(best));
+    for (code = 0; code < 64; code++)
+    {
+        c = (unsigned char)db->codon_aa[code];
+        if (freq[code] > best[c])
+            best[c] = freq[code];
+    }
+    for (code = 0; code < 64; code++)
+    {
+        c = (unsigned char)db->codon_aa[code];
+        if (best[c] <= 0)
+            cost[code] = 0;
+        else if (freq[code] < MIN_ADAPTIVENESS * best[c])
+            cost[code] = -log(MIN_ADAPTIVENESS);
+        else
+            cost[code] = -log(freq[code] / best[c]);
+    }
+
+    if ((usage = malloc(((size_t)db->nre * 9 * 26 + 1) * sizeof(float))) == NULL)
+        return(-1);
+    free(db->usage);
+    db->usage = usage;
+    for (k = 0; k < db->nre * 9 * 26; k++)
+        usage[k] = -1;
+
+    for (j = 0; j < db->nre; j++)
+    {
+        site = db->res_enzyme[j].na;
+        for (frame = 1; frame <= 3; frame++)
+        {
+            for (slot = 0; slot < 3; slot++)
+            {
+                for (code = 0; code < 64; code++)
+                {
+                    c = db->codon_aa[code];
+                    if ((c < 'A') || (c > 'Z'))
+                        continue;
+                    for (k = 0; k < 3; k++)
+                    {
+                        off = 3 * slot + k - (frame - 1);
+                        if ((off >= 0) && (off < (int)strlen(site)) &&
+                                (base[(code >> (2 * (2 - k))) & 3] != site[off]))
+                            break;
+                    }
+                    if ((k == 3) && ((USAGE(db, j, frame, slot, c) < 0) ||
+                                     (cost[code] < USAGE(db, j, frame, slot, c))))
+                        USAGE(db, j, frame, slot, c) = cost[code];
+                }
+            }
+        }
+    }
+
+    /* the scores are part of a cached result */
+    db->fingerprint = Mix64(HashBytes(db->fingerprint, (const char *)cost, sizeof(cost)));
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   HitScore:           Scores a site by the codon usage of the host.         *
+*                                                                             *
+*   Input:              aa. amino acid sequence the site was found in.        *
+*                                                                             *
+*   Output:             the geometric mean of the relative adaptiveness of    *
+*                       the best codons that make the site, from 1 for the    *
+*                       most used codons down to MIN_ADAPTIVENESS; 1 if no    *
+*                       codon usage was loaded.                               *
+*                                                                             *
+******************************************************************************/
+
+double HitScore(const DATABASE *db, const char *aa, const OUTPUT *hit)
+{
+    double cost = 0;
+    int t, c;
+
+    if (db->usage == NULL)
+        return(1.0);
+    for (t = 0; t < hit->number; t++)
+    {
+        c = (unsigned char)aa[hit->pos + t];
+        if ((c >= 'A') && (c <= 'Z') && (USAGE(db, hit->re, hit->frame, t, c) > 0))
+            cost += USAGE(db, hit->re, hit->frame, t, c);
+    }
+    return(exp(-cost / hit->number));
+}
+
+/******************************************************************************
+*                                                                             *
+*   LoadDataBase:       Reads the codon table and the Restriction Enzyme      *
+*                       recognition sequences into a new database.            *
+*                                                                             *
+*   Input:              aa_fname. codon table (dbase1).                       *
+*                       re_fname. Restriction Enzyme sequences (dbase2).      *
+*                       bad_fname. set to the file that could not be read.    *
+*                                                                             *
+*   Output:             the database, or NULL on error.                       *
+*                                                                             *
+*   Notes:              The database is not modified after this function      *
+*                       returns, so it can be shared between threads.         *
+*                                                                             *
+******************************************************************************/
+
+DATABASE *LoadDataBase(const char *aa_fname, const char *re_fname,
+                       const char **bad_fname)
+{
+    DATABASE *db;
+
+    if ((db = calloc(1, sizeof(DATABASE))) == NULL)
+        return(NULL);
+
+    if (ReadDataBase_AA(db, aa_fname) < 0)
+    {
+        if (bad_fname)
+            *bad_fname = aa_fname;
+        FreeDataBase(db);
+        return(NULL);
+    }
+
+    if (ReadDataBase_RE(db, re_fname) < 0)
+    {
+        if (bad_fname)
+            *bad_fname = re_fname;
+        FreeDataBase(db);
+        return(NULL);
+    }
+
+    if (CompileDataBase(db) < 0)
+    {
+        FreeDataBase(db);
+        return(NULL);
+    }
+
+    return(db);
+}
+
+void FreeDataBase(DATABASE *db)
+{
+    if (db == NULL)
+        return;
+    free(db->f_rf);
+    free(db->s_rf);
+    free(db->t_rf);
+    free(db->res_enzyme);
+    free(db->mask);
+    free(db->usage);
+    free(db);
+}
+
+int NumEnzymes(const DATABASE *db)
+{
+    return(db->nre);
+}
+
+const char *EnzymeName(const DATABASE *db, int n)
+{
+    return(db->res_enzyme[n].name);
+}
+
+const char *EnzymeSite(const DATABASE *db, int n)
+{
+    return(db->res_enzyme[n].na);
+}
+
+/* compares n characters in either case */
+static int SameName(const char *a, const char *b, size_t n)
+{
+    for (; n > 0; n--, a++, b++)
+    {
+        if (toupper((unsigned char)*a) != toupper((unsigned char)*b))
+            return(0);
+    }
+    return(1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   FindEnzyme:     Looks up a Restriction Enzyme by name.                    *
+*                                                                             *
+*   Input:          name. the name in dbase2, or any one of the names it      *
+*                   lists separated by '/', in either case.                   *
+*                                                                             *
+*   Output:         index of the enzyme, -1 if there is none.                 *
+*                                                                             *
+******************************************************************************/
+
+int FindEnzyme(const DATABASE *db, const char *name)
+{
+    const char *p, *q;
+    size_t n = strlen(name);
+    int i;
+
+    for (i = 0; (n > 0) && (i < db->nre); i++)
+    {
+        p = db->res_enzyme[i].name;
+        if ((strlen(p) == n) && SameName(p, name, n))
+            return(i);
+        for (; *p; p = (*q ? q + 1 : q))
+        {
+            for (q = p; *q && (*q != '/'); q++)
+                ;
+            if (((size_t)(q - p) == n) && SameName(p, name, n))
+                return(i);
+        }
+    }
+    return(-1);
+}
+
+/* matches n characters against a pattern where '*' and '?' are wild, in either case */
+static int MatchName(const char *pattern, const char *name, size_t n)
+{
+    for (; *pattern; pattern++)
+    {
+        if (*pattern == '*')
+        {
+            for (; !MatchName(pattern + 1, name, n); name++, n--)
+            {
+                if (n == 0)
+                    return(0);
+            }
+            return(1);
+        }
+        if ((n == 0) || ((*pattern != '?') && !SameName(pattern, name, 1)))
+            return(0);
+        name++;
+        n--;
+    }
+    return(n == 0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   MatchEnzyme:    Tells whether a name or pattern stands for an enzyme.     *
+*                                                                             *
+*   Input:          n. index of the enzyme.                                   *
+*                   pattern. a name as for FindEnzyme, in which '*' stands    *
+*                   for any characters and '?' for any one.                   *
+*                                                                             *
+*   Output:         1 if the pattern matches the name of the enzyme or one    *
+*                   of the names it lists, 0 otherwise.                       *
+*                                                                             *
+******************************************************************************/
+
+int MatchEnzyme(const DATABASE *db, int n, const char *pattern)
+{
+    const char *p, *q;
+
+    p = db->res_enzyme[n].name;
+    if (MatchName(pattern, p, strlen(p)))
+        return(1);
+    for (; *p; p = (*q ? q + 1 : q))
+    {
+        for (q = p; *q && (*q != '/'); q++)
+            ;
+        if (MatchName(pattern, p, q - p))
+            return(1);
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SelectEnzymes:  Drops the Restriction Enzymes that are not wanted and     *
+*                   compiles the database again for the others, so that a     *
+*                   scan only tests those.                                    *
+*                                                                             *
+*   Input:          db. database from LoadDataBase, before the SCANs that     *
+*                   use it are made or it is shared between threads.          *
+*                   keep. nonzero for each enzyme to keep, by index.          *
+*                                                                             *
+*   Output:         the number of enzymes kept, -1 if memory is exhausted.    *
+*                                                                             *
+*   Notes:          The enzymes kept stay in database order but are given     *
+*                   new indexes, from 0; SCANs of the database must be made   *
+*                   afresh.  The codon usage, if loaded, is kept.             *
+*                                                                             *
+******************************************************************************/
+
+int SelectEnzymes(DATABASE *db, const char *keep)
+{
+    size_t row = 9 * 26;
+    int i, n = 0;
+
+    for (i = 0; i < db->nre; i++)
+    {
+        if (!keep[i])
+            continue;
+        db->f_rf[n] = db->f_rf[i];
+        db->s_rf[n] = db->s_rf[i];
+        db->t_rf[n] = db->t_rf[i];
+        db->res_enzyme[n] = db->res_enzyme[i];
+        if (db->usage)
+            memmove(&db->usage[n * row], &db->usage[i * row], row * sizeof(float));
+        n++;
+    }
+    db->nre = n;
+    if (CompileDataBase(db) < 0)
+        return(-1);
+    if (db->usage)
+        db->fingerprint = Mix64(HashBytes(db->fingerprint, (const char *)db->usage,
+                                          n * row * sizeof(float)));
+    return(n);
+}
+
+const char *ValidAminoAcids(const DATABASE *db)
+{
+    return(db->valid_aa);
+}
+
+/* amino acid of a codon given by its 2-bit code (A 0, C 1, G 2, T 3), 0 if none */
+int CodonAminoAcid(const DATABASE *db, int code)
+{
+    return(db->codon_aa[code & 63]);
+}
+
+/* hash of the codon table and the Restriction Enzymes, names included */
+uint64_t DataBaseFingerprint(const DATABASE *db)
+{
+    return(db->fingerprint);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadingFrame:       Returns one amino acid position of the motif of a     *
+*                       Restriction Enzyme in one reading frame.              *
+*                                                                             *
+*   Input:              n. index of the Restriction Enzyme.                   *
+*                       frame. reading frame (1, 2 or 3).                     *
+*                       slot. amino acid position in the motif (0, 1 or 2).   *
+*                                                                             *
+*   Output:             the set of amino acids allowed at that position.      *
+*                                                                             *
+******************************************************************************/
+
+const char *ReadingFrame(const DATABASE *db, int n, int frame, int slot)
+{
+    const RF *rf;
+
+    rf = (frame == 1) ? &db->f_rf[n] : (frame == 2) ? &db->s_rf[n] : &db->t_rf[n];
+
+    return((slot == 0) ? rf->f_aa : (slot == 1) ? rf->s_aa : rf->t_aa);
+}
+
+/*******************************************************************************
+*                                                                              *
+*   DisplayReTable:   Writes the amino acid motifs from each of the reading    *
+*                     frame corresponding to all the Restriction Enzymes       *
+*                     onto a file.                                             *
+*                                                                              *
+*   Input:            fp. file pointer for writing.                            *
+*                                                                              *
+*   Output:           None.                                                    *
+*                                                                              *
+*   Notes:            This function generates the table containing the amino   *
+*                     acid motifs for each of the reading frames corresponding *
+*                     to all the restriction enzymes.                          *
+*                                                                              *
+*******************************************************************************/
+
+void DisplayReTable(const DATABASE *db, FILE *fp)
+{
+    int i, j;
+    const RF *f_rf = db->f_rf, *s_rf = db->s_rf, *t_rf = db->t_rf;
+    const RE *res_enzyme = db->res_enzyme;
+
+
+    for (i = 0; i < db->nre; i++)
+    {
+        fprintf(fp, "%s", res_enzyme[i].name);
+        for (j = strlen(res_enzyme[i].name); j < 45; j++)
+            fprintf(fp, " ");
+        fprintf(fp, "%s", res_enzyme[i].na);
+        fprintf(fp, "  ");
+        fprintf(fp, "%c ", f_rf[i].f_aa[0]);
+        fprintf(fp, "%c  ", f_rf[i].s_aa[0]);
+
+        fprintf(fp, "%s", s_rf[i].f_aa);
+        for (j = strlen(s_rf[i].f_aa); j < 5; j++)
+            fprintf(fp, " ");
+        fprintf(fp, " %c ", s_rf[i].s_aa[0]);
+        fprintf(fp, "%s", s_rf[i].t_aa);
+        for (j = strlen(s_rf[i].t_aa); j < 8; j++)
+            fprintf(fp, " ");
+
+
+        fprintf(fp, "%s", t_rf[i].f_aa);
+        for (j = strlen(t_rf[i].f_aa); j < 15; j++)
+            fprintf(fp, " ");
+        fprintf(fp, " %c ", t_rf[i].s_aa[0]);
+        fprintf(fp, "%s", t_rf[i].t_aa);
+
+        fprintf(fp, "\n");
+    }
+
+}
+
+int IsChIn(const char *str, char c)
+{
+    int i;
+
+    for (i = 0; str[i]; i++)
+        if (str[i] == c)
+            return(1);
+
+    return(0);
+}
+
+/* na_code[c] is 1 + the 2-bit code of base c, in either case, 0 otherwise */
+static const unsigned char na_code[256] =
+{
+    ['A'] = 1, ['C'] = 2, ['G'] = 3, ['T'] = 4,
+    ['a'] = 1, ['c'] = 2, ['g'] = 3, ['t'] = 4
+};
+
+/******************************************************************************
+*                                                                             *
+*   TranslateCodons:    Translates the whole codons of a nucleic acid string  *
+*                       through the 2-bit coded codon table.                  *
+*                                                                             *
+*   Input:              str, len. nucleic acid sequence in upper case.        *
+*                       aa. room for len / 3 + 1 amino acids.                 *
+*                                                                             *
+*   Output:             the number of amino acids stored.                     *
+*                                                                             *
+*   Notes:              Codons that are not in the codon table are skipped,   *
+*                       as are codons with a character other than A, C, G     *
+*                       and T.                                                *
+*                                                                             *
+******************************************************************************/
+
+static int TranslateCodons(const DATABASE *db, const char *str, int len, char *aa)
+{
+    int i, k, a, b, c;
+
+    for (i = 0, k = 0; i + 3 <= len; i += 3)
+    {
+        if (((a = BaseCode(str[i])) < 0) || ((b = BaseCode(str[i + 1])) < 0) ||
+                ((c = BaseCode(str[i + 2])) < 0))
+            continue;
+        if ((aa[k] = db->codon_aa[a * 16 + b * 4 + c]) != '\0')
+            k++;
+    }
+    aa[k] = '\0';
+    return(k);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ExpandTail:     Makes the amino acid sequences for every choice of the    *
+*                   bases missing from the last codon.                        *
+*                                                                             *
+*   Input:          aa. aa[0] holds the translation of the whole codons.      *
+*                   tail, ntail. bases of the incomplete last codon.          *
+*                   extra. number of bases to append (0, 1 or 2).             *
+*                                                                             *
+*   Output:         the number of sequences (1, 4 or 16), or 0 if memory is   *
+*                   exhausted.                                                *
+*                                                                             *
+******************************************************************************/
+
+static int ExpandTail(const DATABASE *db, char **aa, const char *tail, int ntail,
+                      int extra)
+{
+    int n, i, k, count = 1 << (2 * extra);
+    char str[5], last[3];
+
+    k = strlen(aa[0]);
+    for (n = count - 1; n >= 0; n--)
+    {
+        if ((n > 0) && ((aa[n] = malloc(k + 2)) == NULL))
+        {
+            for (i = n + 1; i < count; i++)
+                free(aa[i]);
+            free(aa[0]);
+            return(0);
+        }
+        memcpy(str, tail, ntail);
+        for (i = 0; i < extra; i++)
+            str[ntail + i] = base[(n >> (2 * (extra - 1 - i))) & 3];
+        TranslateCodons(db, str, ntail + extra, last);
+        if (n > 0)
+            memcpy(aa[n], aa[0], k);
+        strcpy(&aa[n][k], last);
+    }
+    return(count);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ConverNAToAA:   converts a nucleic acid sequence into its corresponding   *
+*                   amino acid sequence.                                      *
+*                                                                             *
+*   Input: in_str:  nucleic acid sequence.                                    *
+*                   aa:  pointer to string for storing the amino acid         *
+*                   sequence.                                                 *
+*                   option:  method for conversion.                           *
+*                                                                             *
+*   Output:         returns the number of amino acid sequences generated.     *
+*                                                                             *
+*   Notes:          This function converts a nucleic acid sequence into       *
+*                   its corresponding amino acid sequence. If the input       *
+*                   sequence is not a multiple of 3, the option parameter     *
+*                   determines the recovery action. One recovery action       *
+*                   is to determine all possible amino acid sequence for      *
+*                   the given input. If the input sequence is one short,      *
+*                   4 nucleic acid sequences are generated. If it is 2 short, *
+*                   then 16 nucleic acid sequence are generated.              *
+*                   The caller frees the strings stored in aa.                *
+*                   The codons are looked up by their 2-bit code, so the      *
+*                   whole codons are translated once and only the last one    *
+*                   is redone for each choice of the missing bases.           *
+*                                                                             *
+******************************************************************************/
+
+int ConvertNAToAA(const DATABASE *db, char *in_str, char **aa, int option)
+{
+    int len, head, extra;
+
+    if ((option < 0) || (option > 2))
+        return(0);
+    extra = (option == 1) ? 2 : (option == 2) ? 1 : 0;
+
+    len = strlen(in_str);
+    head = len - len % 3;
+    if ((aa[0] = malloc(head / 3 + 2)) == NULL)
+        return(0);
+    TranslateCodons(db, in_str, head, aa[0]);
+
+    return(ExpandTail(db, aa, &in_str[head], len - head, extra));
+}
+
+/******************************************************************************
+*                                                                             *
+*   ConvertRawNAToAA:   Validates and translates a nucleic acid sequence as   *
+*                       it is in the input, e.g. a FASTA record in a mapped   *
+*                       file, without copying it first.                       *
+*                                                                             *
+*   Input:              raw, n. sequence; white space, line ends and digits   *
+*                       are skipped and lower case bases accepted.            *
+*                       aa. as for ConvertNAToAA.                             *
+*                       bad. set to the offset in raw of the first invalid    *
+*                       character.                                            *
+*                                                                             *
+*   Output:             the number of amino acid sequences generated, or -1   *
+*                       if the sequence is invalid or has no bases, or 0 if   *
+*                       memory is exhausted.                                  *
+*                                                                             *
+*   Notes:              The result is that of Check_Input followed by         *
+*                       ConvertNAToAA with the option nbases % 3.             *
+*                                                                             *
+******************************************************************************/
+
+int ConvertRawNAToAA(const DATABASE *db, const char *raw, size_t n, char **aa,
+                     size_t *bad)
+{
+    size_t i, nbases = 0;
+    unsigned int codon = 0;
+    int k = 0, code, r;
+    char *str, tail[2];
+
+    if ((str = malloc(n / 3 + 2)) == NULL)
+        return(0);
+
+    for (i = 0; i < n; i++)
+    {
+        if ((code = na_code[(unsigned char)raw[i]]) == 0)
+        {
+            if (db->char_class[(unsigned char)raw[i]] & CL_SKIP)
+                continue;
+            *bad = i;
+            free(str);
+            return(-1);
+        }
+        codon = ((codon << 2) | (code - 1)) & 63;
+        if ((++nbases % 3 == 0) && ((str[k] = db->codon_aa[codon]) != '\0'))
+            k++;
+    }
+    str[k] = '\0';
+
+    if (nbases == 0)
+    {
+        *bad = 0;
+        free(str);
+        return(-1);
+    }
+
+    r = nbases % 3;
+    if (r >= 1)
+        tail[r - 1] = base[codon & 3];
+    if (r == 2)
+        tail[0] = base[(codon >> 2) & 3];
+    aa[0] = str;
+    return(ExpandTail(db, aa, tail, r, (r == 1) ? 2 : (r == 2) ? 1 : 0));
+}
+
+/******************************************************************************
+*                                                                             *
+*   NewScan:        Creates an empty scan context on a database.              *
+*                                                                             *
+*   Input:          db. database shared by the scans.                         *
+*                                                                             *
+*   Output:         the scan context, or NULL if memory is exhausted.         *
+*                                                                             *
+******************************************************************************/
+
+SCAN *NewScan(const DATABASE *db)
+{
+    SCAN *scan;
+
+    if ((scan = calloc(1, sizeof(SCAN))) == NULL)
+        return(NULL);
+    scan->db = db;
+    return(scan);
+}
+
+void FreeScan(SCAN *scan)
+{
+    if (scan == NULL)
+        return;
+    free(scan->out);
+    free(scan);
+}
+
+int NumHits(const SCAN *scan)
+{
+    return(scan->nout);
+}
+
+const OUTPUT *GetHit(const SCAN *scan, int k)
+{
+    return(&scan->out[k]);
+}
+
+const DATABASE *ScanDataBase(const SCAN *scan)
+{
+    return(scan->db);
+}
+
+/******************************************************************************
+*                                                                             *
+*   AddHit:         Stores a potential mutation site in the scan context.     *
+*                                                                             *
+*   Output:         0 on success, -1 if memory is exhausted.                  *
+*                                                                             *
+******************************************************************************/
+
+static int ReserveHits(SCAN *scan, int n)
+{
+    OUTPUT *out;
+    int size = scan->max_out ? scan->max_out : MAX_MS;
+
+    if (scan->nout + n <= scan->max_out)
+        return(0);
+    while (size < scan->nout + n)
+        size *= 2;
+    if ((out = realloc(scan->out, size * sizeof(OUTPUT))) == NULL)
+        return(-1);
+    scan->out = out;
+    scan->max_out = size;
+    return(0);
+}
+
+static int AddHit(SCAN *scan, const OUTPUT *hit)
+{
+    if ((scan->nout == scan->max_out) && (ReserveHits(scan, 1) < 0))
+        return(-1);
+    scan->out[scan->nout++] = *hit;
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   OpenCursor:     Starts a lazy scan of a window of an amino acid string.   *
+*                                                                             *
+*   Input:          cur. cursor to initialize (may live on the stack).        *
+*                   str. string of amino acids; it must not change while      *
+*                   the cursor is in use.                                     *
+*                   start, end. window of motif positions [start, end); a     *
+*                   negative end means the end of the string.                 *
+*                                                                             *
+*   Output:         None.                                                     *
+*                                                                             *
+*   Notes:          NextHit then returns the sites one at a time in the same  *
+*                   order as ScanForRE stores them: by position, and within a *
+*                   position by reading frame and database order.  Nothing    *
+*                   beyond the last returned site is examined, so a caller    *
+*                   may stop at any point and continue later from where it    *
+*                   stopped.                                                  *
+*                                                                             *
+******************************************************************************/
+
+void OpenCursor(CURSOR *cur, const DATABASE *db, const char *str, int start, int end)
+{
+    cur->db = db;
+    cur->str = str;
+    cur->len = strlen(str);
+    cur->end = ((end < 0) || (end > cur->len)) ? cur->len : end;
+    SeekCursor(cur, start);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeekCursor:     Moves a cursor to the first site at or after a position.  *
+*                                                                             *
+******************************************************************************/
+
+void SeekCursor(CURSOR *cur, int pos)
+{
+    cur->pos = (pos < 0) ? 0 : pos;
+    cur->frame = 1;
+    cur->word = -1;
+    cur->bits = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*   FrameBits:      The Restriction Enzymes of one word of the compiled       *
+*                   tables whose motif in the cursor's reading frame matches  *
+*                   at the cursor's position.                                 *
+*                                                                             *
+******************************************************************************/
+
+static uint64_t FrameBits(const CURSOR *cur)
+{
+    const DATABASE *db = cur->db;
+    const unsigned char *s = (const unsigned char *)cur->str + cur->pos;
+    int w = cur->word;
+
+    if (cur->frame == 1)
+    {
+        if (cur->pos + 1 >= cur->len)
+            return(0);
+        return(MASK(db, 1, 0, s[0])[w] & MASK(db, 1, 1, s[1])[w]);
+    }
+
+    if (cur->pos + 2 >= cur->len)
+        return(0);
+    return(MASK(db, cur->frame, 0, s[0])[w] & MASK(db, cur->frame, 1, s[1])[w] &
+           MASK(db, cur->frame, 2, s[2])[w]);
+}
+
+/******************************************************************************
+*                                                                             *
+*   NextHit:        Returns the next potential mutation site of a cursor.     *
+*                                                                             *
+*   Input:          cur. cursor from OpenCursor.                              *
+*                   hit. where to store the site.                             *
+*                                                                             *
+*   Output:         1 if a site was stored, 0 at the end of the window.       *
+*                                                                             *
+******************************************************************************/
+
+int NextHit(CURSOR *cur, OUTPUT *hit)
+{
+    int b, nwords = cur->db->nwords;
+
+    while (cur->bits == 0)
+    {
+        if (++cur->word >= nwords)
+        {
+            cur->word = 0;
+            if (++cur->frame > 3)
+            {
+                cur->frame = 1;
+                cur->pos++;
+            }
+        }
+        if (cur->pos >= cur->end)
+        {
+            SeekCursor(cur, cur->end);
+            return(0);
+        }
+        cur->bits = FrameBits(cur);
+    }
+
+    b = LowBit(cur->bits);
+    cur->bits &= cur->bits - 1;
+
+    hit->pos = cur->pos;
+    hit->number = (cur->frame == 1) ? 2 : 3;
+    hit->frame = cur->frame;
+    hit->re = cur->word * 64 + b;
+    return(1);
+}
+
+/*******************************************************************************
+*                                                                              *
+*   ScanForRE:  For a given string of amino acids, it recognizes the potential *
+*               sites for mutation and the restriction enzymes that can be     *
+*               introduced at this particular site.                            *
+*                                                                              *
+*   Input:      scan context and string of amino acids.                        *
+*                                                                              *
+*   Output:     the number of sites found, or -1 if memory is exhausted.       *
+*                                                                              *
+*   Notes:      This function scans the amino acid sequence and checks for the *
+*               existence of amino acid motifs obtained from each of the       *
+*               reading frames (first, second and third) of all the            *
+*               Restriction enzymes in the input amino acid sequence.          *
+*               The restriction enzyme and the location of the site in input   *
+*               sequence are stored in the scan context.  Callers that do not  *
+*               need every site should use a CURSOR instead.                   *
+*                                                                              *
+*******************************************************************************/
+int ScanForRE(SCAN *scan, char *str)
+{
+    CURSOR cur;
+    OUTPUT hit;
+
+    scan->nout = 0;
+    OpenCursor(&cur, scan->db, str, 0, -1);
+    while (NextHit(&cur, &hit))
+    {
+        if (AddHit(scan, &hit) < 0)
+            return(-1);
+    }
+    return(scan->nout);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SharedResidues: The number of leading amino acids that the translations   *
+*                   of one nucleic acid sequence have in common.              *
+*                                                                             *
+*   Input:          str, n. the translations from ConvertNAToAA.              *
+*                                                                             *
+*   Notes:          When the last codon is partial, the 4 or 16 translations  *
+*                   differ only in the amino acid it gives, so they share all *
+*                   the others.                                               *
+*                                                                             *
+******************************************************************************/
+
+int SharedResidues(char *str[], int n)
+{
+    int i, k, shared = strlen(str[0]);
+
+    for (i = 1; i < n; i++)
+    {
+        for (k = 0; (k < shared) && (str[i][k] == str[0][k]); k++)
+            ;
+        shared = k;
+    }
+    return(shared);
+}
+
+/* 1 if the scan has a site at the position, frame and enzyme of hit, looking
+   back only as far as the sites reaching past the first shared residues */
+static int HasHit(const SCAN *scan, const OUTPUT *hit, int shared)
+{
+    int k;
+
+    for (k = scan->nout - 1; (k >= 0) && (scan->out[k].pos + 3 > shared); k--)
+    {
+        if ((scan->out[k].pos == hit->pos) && (scan->out[k].frame == hit->frame) &&
+                (scan->out[k].re == hit->re))
+            return(1);
+    }
+    return(0);
+}
+
+/* in the order of ScanForRE: by position, frame and database order */
+static int CompareHits(const void *a, const void *b)
+{
+    const OUTPUT *x = a, *y = b;
+
+    if (x->pos != y->pos)
+        return(x->pos - y->pos);
+    if (x->frame != y->frame)
+        return(x->frame - y->frame);
+    return(x->re - y->re);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ScanVariants:   Finds the potential mutation sites of all the             *
+*                   translations of one nucleic acid sequence, each site      *
+*                   once.                                                     *
+*                                                                             *
+*   Input:          scan context and the translations from ConvertNAToAA.     *
+*                                                                             *
+*   Output:         the number of sites found, or -1 if memory is exhausted.  *
+*                                                                             *
+*   Notes:          The sites of the first translation are all kept.  Those   *
+*                   of the others are kept only if they reach past the        *
+*                   residues all share, i.e. into the partial last codon,     *
+*                   and no site of the same position, frame and enzyme is     *
+*                   kept already.  The sites are in the order of ScanForRE.   *
+*                                                                             *
+******************************************************************************/
+
+int ScanVariants(SCAN *scan, char *str[], int n)
+{
+    CURSOR cur;
+    OUTPUT hit;
+    int i, shared = SharedResidues(str, n), nout;
+
+    if ((nout = ScanForRE(scan, str[0])) < 0)
+        return(-1);
+    for (i = 1; i < n; i++)
+    {
+        if (Duplicate(str, i))
+            continue;
+        OpenCursor(&cur, scan->db, str[i], (shared > 2) ? shared - 2 : 0, -1);
+        while (NextHit(&cur, &hit))
+        {
+            if ((hit.pos + hit.number > shared) && !HasHit(scan, &hit, shared) &&
+                    (AddHit(scan, &hit) < 0))
+                return(-1);
+        }
+    }
+    if (scan->nout > nout)
+        qsort(scan->out, scan->nout, sizeof(OUTPUT), CompareHits);
+    return(scan->nout);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Edit sessions: a sequence that is edited a little at a time, with its     *
+*   potential mutation sites kept up to date.                                 *
+*                                                                             *
+*   A nucleic acid session keeps the translation and the sites of all three   *
+*   reading frames.  The bases after an edit are unchanged, so whatever the   *
+*   length of the edit, the codons after it are those of one of the old       *
+*   frames; they are copied from there with their sites and only the codons   *
+*   around the edit are translated and scanned again.                         *
+*                                                                             *
+******************************************************************************/
+
+typedef struct
+{
+    char *aa;
+    int len, cap;
+    SCAN *scan;
+} FRAME;
+
+struct EDIT
+{
+    const DATABASE *db;
+    int opt;                /* 1 for amino acids, 2 for nucleic acids   */
+    int nframes;
+    char *text;             /* the bases of a nucleic acid session      */
+    int len, cap;
+    char *ins, *mid;        /* normalized insertion, middle codons      */
+    int ins_cap, mid_cap;
+    FRAME frame[3], spare[3];
+};
+
+static int GrowText(char **str, int *cap, int n)
+{
+    char *p;
+    int size = *cap ? *cap : 256;
+
+    if (n < *cap)
+        return(0);
+    while (size <= n)
+        size *= 2;
+    if ((p = realloc(*str, size)) == NULL)
+        return(-1);
+    *str = p;
+    *cap = size;
+    return(0);
+}
+
+/* index of the first site at or after a position */
+static int FirstHitAt(const SCAN *scan, int pos)
+{
+    int lo = 0, hi = scan->nout, k;
+
+    while (lo < hi)
+    {
+        k = (lo + hi) / 2;
+        if (scan->out[k].pos < pos)
+            lo = k + 1;
+        else
+            hi = k;
+    }
+    return(lo);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SpliceFrame:    Builds the amino acids and sites of one frame from a      *
+*                   kept prefix, new middle amino acids and a kept suffix.    *
+*                                                                             *
+*   Input:          to. frame to build.                                       *
+*                   pre, npre. frame and number of amino acids kept before.   *
+*                   mid, nmid. the new amino acids.                           *
+*                   suf, ksuf. frame and first amino acid kept after.         *
+*                                                                             *
+*   Output:         0 on success, -1 if memory is exhausted.                  *
+*                                                                             *
+*   Notes:          Sites of the prefix starting two or more positions        *
+*                   before its end, and all the sites of the suffix, lie      *
+*                   wholly in unchanged amino acids and are copied; the       *
+*                   positions in between are scanned again.                   *
+*                                                                             *
+******************************************************************************/
+
+static int SpliceFrame(FRAME *to, const FRAME *pre, int npre, const char *mid, int nmid,
+                       const FRAME *suf, int ksuf)
+{
+    int n, k, end, shift;
+    CURSOR cur;
+    OUTPUT hit;
+
+    n = npre + nmid + (suf->len - ksuf);
+    if (GrowText(&to->aa, &to->cap, n) < 0)
+        return(-1);
+    memcpy(to->aa, pre->aa, npre);
+    memcpy(&to->aa[npre], mid, nmid);
+    memcpy(&to->aa[npre + nmid], &suf->aa[ksuf], suf->len - ksuf);
+    to->aa[n] = '\0';
+    to->len = n;
+
+    to->scan->nout = 0;
+    end = FirstHitAt(pre->scan, npre - 2);
+    if (ReserveHits(to->scan, end) < 0)
+        return(-1);
+    if (end > 0)
+        memcpy(to->scan->out, pre->scan->out, end * sizeof(OUTPUT));
+    to->scan->nout = end;
+
+    OpenCursor(&cur, to->scan->db, to->aa, npre - 2, npre + nmid);
+    while (NextHit(&cur, &hit))
+    {
+        if (AddHit(to->scan, &hit) < 0)
+            return(-1);
+    }
+
+    shift = npre + nmid - ksuf;
+    k = FirstHitAt(suf->scan, ksuf);
+    n = suf->scan->nout - k;
+    if (ReserveHits(to->scan, n) < 0)
+        return(-1);
+    if (n > 0)
+        memcpy(&to->scan->out[to->scan->nout], &suf->scan->out[k], n * sizeof(OUTPUT));
+    for (end = to->scan->nout + n; to->scan->nout < end; to->scan->nout++)
+        to->scan->out[to->scan->nout].pos += shift;
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   EditReplace:    Replaces part of the sequence of an edit session and      *
+*                   updates its sites.                                        *
+*                                                                             *
+*   Input:          pos. position of the first character replaced.            *
+*                   ndel. number of characters removed.                       *
+*                   ins. characters put in their place; it is normalized as   *
+*                   by Check_Input.                                           *
+*                                                                             *
+*   Output:         the number of sites, or -1 if the position or the         *
+*                   inserted characters are invalid or memory is exhausted    *
+*                   (the session can then only be freed).                     *
+*                                                                             *
+******************************************************************************/
+
+int EditReplace(EDIT *ed, int pos, int ndel, const char *ins)
+{
+    int g, h, m, delta, npre, nmid, nsuf, ncodons, s, ksuf, old_len;
+    FRAME tmp;
+
+    if ((pos < 0) || (ndel < 0) || (pos + ndel > EditLength(ed)))
+        return(-1);
+
+    m = strlen(ins);
+    if (GrowText(&ed->ins, &ed->ins_cap, m) < 0)
+        return(-1);
+    strcpy(ed->ins, ins);
+    if ((m > 0) && !ValidateInput(ed->db, ed->ins, ed->opt, NULL))
+        return(-1);
+    m = strlen(ed->ins);
+
+    if (ed->opt == 1)
+    {
+        if (SpliceFrame(&ed->spare[0], &ed->frame[0], pos, ed->ins, m,
+                        &ed->frame[0], pos + ndel) < 0)
+            return(-1);
+    }
+    else
+    {
+        old_len = ed->len;
+        delta = m - ndel;
+        if (GrowText(&ed->text, &ed->cap, old_len + delta) < 0)
+            return(-1);
+        memmove(&ed->text[pos + m], &ed->text[pos + ndel], old_len - pos - ndel + 1);
+        memcpy(&ed->text[pos], ed->ins, m);
+        ed->len += delta;
+        if (GrowText(&ed->mid, &ed->mid_cap, m / 3 + 2) < 0)
+            return(-1);
+
+        for (g = 0; g < 3; g++)
+        {
+            /* codons wholly before the edit, wholly after it, and in all */
+            npre = (pos >= g) ? (pos - g) / 3 : 0;
+            nsuf = (pos + m >= g) ? (pos + m - g + 2) / 3 : 0;
+            ncodons = (ed->len >= g) ? (ed->len - g) / 3 : 0;
+            if (nsuf > ncodons)
+                nsuf = ncodons;
+
+            nmid = TranslateCodons(ed->db, &ed->text[3 * npre + g], 3 * (nsuf - npre),
+                                   ed->mid);
+
+            /* the same bases were at s - delta, in frame h */
+            s = 3 * nsuf + g;
+            h = (((s - delta) % 3) + 3) % 3;
+            ksuf = (s - delta - h) / 3;
+            if (nsuf == ncodons)
+                ksuf = ed->frame[h].len;
+
+            if (SpliceFrame(&ed->spare[g], &ed->frame[g], npre, ed->mid, nmid,
+                            &ed->frame[h], ksuf) < 0)
+                return(-1);
+        }
+    }
+
+    for (g = 0; g < ed->nframes; g++)
+    {
+        tmp = ed->frame[g];
+        ed->frame[g] = ed->spare[g];
+        ed->spare[g] = tmp;
+    }
+    return(ed->frame[0].scan->nout);
+}
+
+int EditInsert(EDIT *ed, int pos, const char *ins)
+{
+    return(EditReplace(ed, pos, 0, ins));
+}
+
+int EditDelete(EDIT *ed, int pos, int ndel)
+{
+    return(EditReplace(ed, pos, ndel, ""));
+}
+
+int EditSubstitute(EDIT *ed, int pos, const char *ins)
+{
+    return(EditReplace(ed, pos, strlen(ins), ins));
+}
+
+/******************************************************************************
+*                                                                             *
+*   NewEdit:        Starts an edit session on a sequence.                     *
+*                                                                             *
+*   Input:          db. database shared by the sessions and scans.            *
+*                   str. initial sequence, checked as by Check_Input.         *
+*                   opt. 1 for amino acids, 2 for nucleic acids.              *
+*                                                                             *
+*   Output:         the session, or NULL if the sequence is invalid or        *
+*                   memory is exhausted.                                      *
+*                                                                             *
+*   Notes:          The sites are those of the translation of the whole       *
+*                   codons in the first reading frame; the bases of an        *
+*                   incomplete last codon are not translated.  A nucleic      *
+*                   acid session needs a codon table with all 64 codons.      *
+*                                                                             *
+******************************************************************************/
+
+EDIT *NewEdit(const DATABASE *db, const char *str, int opt)
+{
+    EDIT *ed;
+    int g;
+
+    if ((opt != 1) && (opt != 2))
+        return(NULL);
+    for (g = 0; (opt == 2) && (g < 64); g++)
+    {
+        if (db->codon_aa[g] == '\0')
+            return(NULL);
+    }
+
+    if ((ed = calloc(1, sizeof(EDIT))) == NULL)
+        return(NULL);
+    ed->db = db;
+    ed->opt = opt;
+    ed->nframes = (opt == 2) ? 3 : 1;
+    for (g = 0; g < ed->nframes; g++)
+    {
+        if ((GrowText(&ed->frame[g].aa, &ed->frame[g].cap, 0) < 0) ||
+                ((ed->frame[g].scan = NewScan(db)) == NULL) ||
+                ((ed->spare[g].scan = NewScan(db)) == NULL))
+        {
+            FreeEdit(ed);
+            return(NULL);
+        }
+        ed->frame[g].aa[0] = '\0';
+    }
+    if (GrowText(&ed->text, &ed->cap, 0) < 0)
+    {
+        FreeEdit(ed);
+        return(NULL);
+    }
+    ed->text[0] = '\0';
+    if (EditReplace(ed, 0, 0, str) < 0)
+    {
+        FreeEdit(ed);
+        return(NULL);
+    }
+    return(ed);
+}
+
+void FreeEdit(EDIT *ed)
+{
+    int g;
+
+    if (ed == NULL)
+        return;
+    for (g = 0; g < 3; g++)
+    {
+        free(ed->frame[g].aa);
+        FreeScan(ed->frame[g].scan);
+        free(ed->spare[g].aa);
+        FreeScan(ed->spare[g].scan);
+    }
+    free(ed->text);
+    free(ed->ins);
+    free(ed->mid);
+    free(ed);
+}
+
+/* the sequence as edited: bases, or amino acids for an amino acid session */
+const char *EditText(const EDIT *ed)
+{
+    return((ed->opt == 2) ? ed->text : ed->frame[0].aa);
+}
+
+int EditLength(const EDIT *ed)
+{
+    return((ed->opt == 2) ? ed->len : ed->frame[0].len);
+}
+
+const char *EditAminoAcids(const EDIT *ed)
+{
+    return(ed->frame[0].aa);
+}
+
+/* the sites, for NumHits, GetHit and PrintResult */
+const SCAN *EditScan(const EDIT *ed)
+{
+    return(ed->frame[0].scan);
+}
+
+/******************************************************************************
+*                                                                             *
+*   HitEdits:       Counts the base changes needed to introduce the           *
+*                   recognition sequence of a site by silent mutations.       *
+*                                                                             *
+*   Input:          na. nucleic acid sequence that was translated.            *
+*                   aa. its amino acid sequence.                              *
+*                   hit. site found in aa.                                    *
+*                                                                             *
+*   Output:         the smallest number of bases of na to change, 0 if the    *
+*                   site is already present.                                  *
+*                                                                             *
+*   Notes:          The bases of a codon outside the recognition sequence     *
+*                   are chosen so that the codon still codes for the same     *
+*                   amino acid with as few changes as possible.  Bases past   *
+*                   the end of na (the padding of ConvertNAToAA) are free.    *
+*                                                                             *
+******************************************************************************/
+
+int HitEdits(const DATABASE *db, const char *na, const char *aa, const OUTPUT *hit)
+{
+    int t, k, code, best, diff, npos, start, len, total = 0;
+    const char *site = db->res_enzyme[hit->re].na;
+    int slen = strlen(site);
+
+    len = strlen(na);
+    start = 3 * hit->pos + hit->frame - 1;
+
+    for (t = 0; t < hit->number; t++)
+    {
+        best = -1;
+        for (code = 0; code < 64; code++)
+        {
+            if (db->codon_aa[code] != aa[hit->pos + t])
+                continue;
+
+            for (k = 0, diff = 0; k < 3; k++)
+            {
+                char b = base[(code >> (2 * (2 - k))) & 3];
+
+                npos = 3 * (hit->pos + t) + k;
+                if ((npos >= start) && (npos < start + slen) && (b != site[npos - start]))
+                    break;
+                if ((npos < len) && (b != na[npos]))
+                    diff++;
+            }
+            if ((k == 3) && ((best < 0) || (diff < best)))
+                best = diff;
+        }
+        if (best < 0)
+            return(-1);
+        total += best;
+    }
+    return(total);
+}
+
+#if defined(__SSE2__)
+
+/******************************************************************************
+*                                                                             *
+*   CleanChunk:     Tells whether 16 input characters are already normalized  *
+*                   and valid, so that they can be kept as they are.          *
+*                                                                             *
+******************************************************************************/
+
+static int CleanChunk(const DATABASE *db, const char *str, int opt)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)str);
+    __m128i m;
+    uint32_t letters = 0;
+    int i;
+
+    if (opt == 2)
+    {
+        m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('A')),
+                                      _mm_cmpeq_epi8(v, _mm_set1_epi8('C'))),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('G')),
+                                      _mm_cmpeq_epi8(v, _mm_set1_epi8('T'))));
+        return(_mm_movemask_epi8(m) == 0xffff);
+    }
+
+    /* upper case letters only, then all of them valid amino acids */
+    m = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    if (_mm_movemask_epi8(m) != 0xffff)
+        return(0);
+    if (opt != 1)
+        return(1);
+    for (i = 0; i < 16; i++)
+        letters |= (uint32_t)1 << (str[i] - 'A');
+    return((letters & ~db->aa_letters) == 0);
+}
+
+#endif
+
+/******************************************************************************
+*                                                                             *
+*   ValidateInput:      Normalizes and validates an input sequence in one     *
+*                       pass.                                                 *
+*                                                                             *
+*   Input:              str. sequence; white space, line ends and digits are  *
+*                       removed and the letters converted to upper case in    *
+*                       place, so it may hold several lines of a file.        *
+*                       opt. 1 for amino acids, 2 for nucleic acids.          *
+*                       bad. if not NULL, set to the offset in the original   *
+*                       str of the first invalid character.                   *
+*                                                                             *
+*   Output:             1 if the sequence is valid, 0 otherwise.  An empty    *
+*                       string is not valid.                                  *
+*                                                                             *
+*   Notes:              Each character is classified by one lookup in         *
+*                       char_class.  With SSE2, runs of 16 characters that    *
+*                       are already clean are tested at once and only moved   *
+*                       if something before them was removed.                 *
+*                                                                             *
+******************************************************************************/
+
+int ValidateInput(const DATABASE *db, char *str, int opt, size_t *bad)
+{
+    size_t i, j, k, end, len;
+    unsigned char c, cl, want;
+    int valid = 1;
+
+    if (bad)
+        *bad = 0;
+    len = strlen(str);
+    if (len == 0)
+        return(0);
+
+    want = (opt == 1) ? CL_AA : (opt == 2) ? CL_BASE : 0;
+    for (i = 0, j = 0; i < len; i = end)
+    {
+        end = (len - i < 16) ? len : i + 16;
+#if defined(__SSE2__)
+        if ((end - i == 16) && CleanChunk(db, &str[i], opt))
+        {
+            if (j != i)
+                memmove(&str[j], &str[i], 16);
+            j += 16;
+            continue;
+        }
+#endif
+        for (k = i; k < end; k++)
+        {
+            c = str[k];
+            cl = db->char_class[c];
+            if (cl & CL_SKIP)
+                continue;
+            if (want && !(cl & want) && valid)
+            {
+                valid = 0;
+                if (bad)
+                    *bad = k;
+            }
+            str[j++] = (cl & CL_LOWER) ? toupper(c) : c;
+        }
+    }
+    str[j] = '\0';
+
+    return(valid);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Check_Input:        Normalizes and validates an input sequence.           *
+*                                                                             *
+*   Input:              str. sequence; white space and digits are removed     *
+*                       and the letters converted to upper case in place.     *
+*                       opt. 1 for amino acids, 2 for nucleic acids.          *
+*                                                                             *
+*   Output:             1 if the sequence is valid, 0 otherwise.              *
+*                                                                             *
+******************************************************************************/
+
+int Check_Input(const DATABASE *db, char *str, int opt)
+{
+    return(ValidateInput(db, str, opt, NULL));
+}
+
+/******************************************************************************
+*                                                                             *
+*   SequenceHash:       128-bit hash of a sequence as Check_Input would       *
+*                       normalize it, of the database and of a seed.          *
+*                                                                             *
+*   Input:              str, n. sequence, e.g. the lines of a FASTA record.   *
+*                       seed. e.g. the options the result depends on.         *
+*                       hash. where to store the two halves of the hash.      *
+*                                                                             *
+*   Notes:              The sequence is normalized on the fly, eight          *
+*                       characters to a word, so the same sequence typed in   *
+*                       lower case or split into lines hashes the same.       *
+*                                                                             *
+******************************************************************************/
+
+void SequenceHash(const DATABASE *db, const char *str, size_t n, uint64_t seed,
+                  uint64_t hash[2])
+{
+    uint64_t h1, h2, w = 0, len = 0;
+    unsigned char c, cl;
+    size_t i;
+
+    h1 = db->fingerprint ^ Mix64(seed);
+    h2 = ~h1;
+    for (i = 0; i < n; i++)
+    {
+        c = str[i];
+        cl = db->char_class[c];
+        if (cl & CL_SKIP)
+            continue;
+        w = (w << 8) | ((cl & CL_LOWER) ? toupper(c) : c);
+        if ((++len & 7) == 0)
+        {
+            h1 = RotL(h1 ^ (RotL(w * HASH_K1, 31) * HASH_K2), 27) * 5 + 0x52dce729;
+            h2 = RotL(h2 ^ (RotL(w * HASH_K2, 33) * HASH_K1), 31) * 5 + 0x38495ab5;
+            w = 0;
+        }
+    }
+
+    h1 ^= RotL(w * HASH_K1, 31) * HASH_K2 ^ len;
+    h2 ^= RotL(w * HASH_K2, 33) * HASH_K1 ^ len;
+    h1 += h2;
+    h2 += h1;
+    hash[0] = Mix64(h1);
+    hash[1] = Mix64(h2);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintResult:        print the result indicating the mutation site and the *
+*                       name of the restriction enzyme that can be introduced *
+*                       at this site                                          *
+*                                                                             *
+*   Input:              scan context, string of amino acids and the file for  *
+*                       output.                                               *
+*                                                                             *
+*   Output:             the number of bytes written.                          *
+*                                                                             *
+*   Notes:              This function prints out the amino acid sequence and  *
+*                       the position in the string and the name of the        *
+*                       restriction enzyme/s that match with the amino acid   *
+*                       motif in the string.                                  *
+*                                                                             *
+*                                                                             *
+******************************************************************************/
+int PrintResult(const SCAN *scan, char *str, FILE *fp)
+{
+    int i, j, k, l, len, pos, n = 0;
+    const OUTPUT *out = scan->out;
+    const RE *res_enzyme = scan->db->res_enzyme;
+    int nout = scan->nout;
+
+    len = strlen(str);
+    n += fprintf(fp, "\n\n-----------------------------------------------------------------------\n");
+
+    if (nout <= 0)
+    {
+        for (i = 0; i < len; i++)
+            n += fprintf(fp, "%c", str[i]);
+        n += fprintf(fp, "\n");
+
+        n += fprintf(fp, "No site in the input string can be replaced with Restriction Enzymes\n");
+        return(n);
+    }
+
+    pos = 0;
+    i = 0;
+
+    while (i < nout)
+    {
+        j = i;
+        while (j < nout)
+        {
+            len = out[j].pos - pos + strlen(res_enzyme[out[j].re].name);
+            if (len > LINELEN)
+                break;
+            else
+                j++;
+        }
+
+        l = i;
+        if (i == j)
+        {
+            len = out[i].pos;
+            for (k = pos; k < len; k++)
+                n += fprintf(fp, "%c", str[k]);
+
+            pos += len;
+        }
+        else
+        {
+            if (j == nout)
+                len = strlen(str) + 1;
+            else
+                len = out[j - 1].pos + out[j - 1].number;
+
+            for (k = pos; k < len; k++)
+                n += fprintf(fp, "%c", str[k]);
+            n += fprintf(fp, "\n");
+
+            k = pos;
+            for (; i < j; i++)
+            {
+                for (; k < out[i].pos; k++)
+                    n += fprintf(fp, " ");
+                n += fprintf(fp, "%s", res_enzyme[out[i].re].name);
+                k += strlen(res_enzyme[out[i].re].name);
+
+                if ((i + 1 < j) && (k >= out[i + 1].pos))
+                {
+                    k = pos;
+                    n += fprintf(fp, "\n");
+                }
+            }
+
+            n += fprintf(fp, "\n\n");
+            for (k = l; k < j; k++)
+            {
+                n += fprintf(fp, "Position in the input string: %d\n", out[k].pos - pos + 1);
+                n += fprintf(fp, "Amino acid string at this position: ");
+                if (out[k].number == 2)
+                {
+                    n += fprintf(fp, "%c", str[out[k].pos]);
+                    n += fprintf(fp, "%c", str[out[k].pos + 1]);
+                }
+                else if (out[k].number == 3)
+                {
+                    n += fprintf(fp, "%c", str[out[k].pos]);
+                    n += fprintf(fp, "%c", str[out[k].pos + 1]);
+                    n += fprintf(fp, "%c", str[out[k].pos + 2]);
+                }
+                n += fprintf(fp, "\n");
+                n += fprintf(fp, "Restriction Enzyme site/s that can be introduced at this position: ");
+                n += fprintf(fp, "%s (%s)", res_enzyme[out[k].re].name, res_enzyme[out[k].re].na);
+                n += fprintf(fp, "\n\n");
+            }
+
+            if (i < nout)
+            {
+                if ((out[i - 1].pos + out[i - 1].number) < out[i].pos)
+                    pos += out[i - 1].pos + out[i - 1].number;
+                else
+                    pos += out[i - 1].pos;
+            }
+
+            if (j == nout)
+                pos = strlen(str) - 1;
+        }
+
+        n += fprintf(fp, "\n");
+    }
+
+    len = strlen(str);
+    if (pos < len - 1)
+    {
+        for (; pos < len; pos++)
+            n += fprintf(fp, "%c", str[pos]);
+    }
+    n += fprintf(fp, "\n");
+
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Duplicate:      checks for a duplicate amino acid sequence.               *
+*                                                                             *
+*   Input:          string of amino acids and the file for output.            *
+*                                                                             *
+*   Output:   1:    if there is a duplicate                                   *
+*             0:    otherwise                                                 *
+*                                                                             *
+*   Notes:          When the input nucleic acid sequence is not a multiple of *
+*                   3, duplicate amino acid sequences might be generated.     *
+*                   This function eliminates the analysis of duplicate        *
+*                   amino acid sequences.                                     *
+*                                                                             *
+******************************************************************************/
+
+
+int Duplicate(char *str[], int n)
+{
+    int i, res = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        if (!strcmp(str[i], str[n]))
+            res = 1;
+    }
+    return(res);
+}
+
+typedef struct
+{
+    double score;
+    int k;
+} RANKED;
+
+/* higher score first, then in the order of the scan */
+static int CompareRanked(const void *a, const void *b)
+{
+    const RANKED *x = a, *y = b;
+
+    if (x->score != y->score)
+        return((x->score > y->score) ? -1 : 1);
+    return(x->k - y->k);
+}
+
+/* the first of the translations that has a site of ScanVariants */
+static const char *VariantOf(const DATABASE *db, char *str[], int n, int shared,
+                             const OUTPUT *hit)
+{
+    CURSOR cur;
+    OUTPUT other;
+    int i;
+
+    for (i = 0; (i < n) && (hit->pos + hit->number > shared); i++)
+    {
+        OpenCursor(&cur, db, str[i], hit->pos, hit->pos + 1);
+        while (NextHit(&cur, &other))
+        {
+            if ((other.frame == hit->frame) && (other.re == hit->re))
+                return(str[i]);
+        }
+    }
+    return(str[0]);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintTable:         Prints the sites as tab separated values, one line    *
+*                       per site: sequence name, position, reading frame,     *
+*                       amino acids, enzyme, recognition sequence and the     *
+*                       HitScore of the site.                                 *
+*                                                                             *
+*   Input:              scan. the sites of str, from ScanForRE when n is 1    *
+*                       or from ScanVariants.                                 *
+*                       name. first column; "-" if NULL.                      *
+*                       start. -1 to give the position of the amino acids;    *
+*                       if str was translated from a region of a genome, the  *
+*                       offset of the region there, from 0, to give instead   *
+*                       the position of the first base of the site in the     *
+*                       genome, from 1.                                       *
+*                       min_score. sites scoring less are left out.           *
+*                       by_score. nonzero to print the best scoring first.    *
+*                                                                             *
+*   Output:             the number of bytes written, or -1 if memory is       *
+*                       exhausted.                                            *
+*                                                                             *
+******************************************************************************/
+
+int PrintTable(const SCAN *scan, char *str[], int nstr, const char *name,
+               long long start, double min_score, int by_score, FILE *fp)
+{
+    RANKED *rank;
+    const OUTPUT *out;
+    const RE *res_enzyme = scan->db->res_enzyme;
+    const char *s;
+    int i, k, nrank = 0, n = 0, shared = SharedResidues(str, nstr);
+
+    if ((rank = malloc((scan->nout + 1) * sizeof(RANKED))) == NULL)
+        return(-1);
+    for (k = 0; k < scan->nout; k++)
+    {
+        s = VariantOf(scan->db, str, nstr, shared, &scan->out[k]);
+        rank[nrank].score = HitScore(scan->db, s, &scan->out[k]);
+        rank[nrank].k = k;
+        if (rank[nrank].score >= min_score)
+            nrank++;
+    }
+    if (by_score)
+        qsort(rank, nrank, sizeof(RANKED), CompareRanked);
+
+    for (i = 0; i < nrank; i++)
+    {
+        out = &scan->out[rank[i].k];
+        s = VariantOf(scan->db, str, nstr, shared, out);
+        n += fprintf(fp, "%s\t%lld\t%d\t%.*s\t%s\t%s\t%.4f\n", name ? name : "-",
+                     (start < 0) ? out->pos + 1LL : start + 3LL * out->pos + out->frame,
+                     out->frame, out->number, &s[out->pos],
+                     res_enzyme[out->re].name, res_enzyme[out->re].na, rank[i].score);
+    }
+    free(rank);
+    return(n);
+}
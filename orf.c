@@ -0,0 +1,175 @@
+/****************************************************************************
+*                                                                           *
+*       orf: the open reading frames of a nucleic acid sequence, such as    *
+*       a plasmid or a stretch of genome, so that only the coding regions   *
+*       are translated and scanned.                                         *
+*                                                                           *
+*       Both strands are read in all three frames without copying the       *
+*       sequence: a codon of the reverse strand is read backwards from the  *
+*       forward one and complemented.  Start and stop codons come from the  *
+*       codon table of dbase1, so another genetic code is a matter of       *
+*       another dbase1.  The sites of an ORF are reported in the            *
+*       coordinates of the sequence it came from, on its forward strand.    *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+static const char bases[5] = "ACGT";
+
+/* 2-bit code of a base; ValidateInput leaves only A, C, G and T */
+static int Base(char c)
+{
+    return((int)(strchr(bases, c) - bases));
+}
+
+/* amino acid of the codon at base j of a strand, counted along that strand */
+static int CodonAt(const DATABASE *db, const char *na, long len, int strand, long j)
+{
+    if (strand > 0)
+        return(CodonAminoAcid(db, (Base(na[j]) << 4) | (Base(na[j + 1]) << 2) |
+                                  Base(na[j + 2])));
+    return(CodonAminoAcid(db, ((3 - Base(na[len - 1 - j])) << 4) |
+                              ((3 - Base(na[len - 2 - j])) << 2) |
+                              (3 - Base(na[len - 3 - j]))));
+}
+
+static int CompareOrfs(const void *a, const void *b)
+{
+    const ORF *x = a, *y = b;
+
+    if (x->start != y->start)
+        return(x->start < y->start ? -1 : 1);
+    return(y->strand - x->strand);
+}
+
+/******************************************************************************
+*                                                                             *
+*   FindOrfs:       Finds the open reading frames of a nucleic acid           *
+*                   sequence on both strands.                                 *
+*                                                                             *
+*   Input:          na. the sequence, as normalized by ValidateInput.         *
+*                   min_codons. the fewest codons of an ORF, its start codon  *
+*                   included and its stop codon not.                          *
+*                   orf. set to the ORFs, by start and then strand; the       *
+*                   caller frees it.                                          *
+*                                                                             *
+*   Output:         the number of ORFs, or -1 if memory is exhausted.         *
+*                                                                             *
+*   Notes:          An ORF runs from the first start codon (ORF_START) after  *
+*                   a stop codon (ORF_STOP, or one without an amino acid) in  *
+*                   its frame to the next stop codon, which it includes.  A   *
+*                   frame that is still open at the end of the sequence gives *
+*                   no ORF.                                                   *
+*                                                                             *
+******************************************************************************/
+
+long FindOrfs(const DATABASE *db, const char *na, int min_codons, ORF **orf)
+{
+    long len = strlen(na), j, open, n = 0, cap = 0;
+    int strand, frame, aa;
+    ORF *o = NULL, *p;
+
+    for (strand = 1; strand >= -1; strand -= 2)
+    {
+        for (frame = 0; frame < 3; frame++)
+        {
+            for (j = frame, open = -1; j + 3 <= len; j += 3)
+            {
+                aa = CodonAt(db, na, len, strand, j);
+                if ((aa == ORF_START) && (open < 0))
+                    open = j;
+                if ((aa != ORF_STOP) && (aa != 0))
+                    continue;
+                if ((open >= 0) && ((j - open) / 3 >= min_codons))
+                {
+                    if (n == cap)
+                    {
+                        if ((p = realloc(o, (2 * cap + 16) * sizeof(ORF))) == NULL)
+                        {
+                            free(o);
+                            return(-1);
+                        }
+                        o = p;
+                        cap = 2 * cap + 16;
+                    }
+                    o[n].start = (strand > 0) ? open : len - j - 3;
+                    o[n].end = (strand > 0) ? j + 3 : len - open;
+                    o[n++].strand = strand;
+                }
+                open = -1;
+            }
+        }
+    }
+    if (n > 1)
+        qsort(o, n, sizeof(ORF), CompareOrfs);
+    *orf = o;
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   OrfProtein:     Translates an ORF of FindOrfs, without its stop codon.    *
+*                                                                             *
+*   Input:          aa. room for (orf->end - orf->start) / 3 amino acids.     *
+*                                                                             *
+*   Output:         the number of amino acids.                                *
+*                                                                             *
+******************************************************************************/
+
+int OrfProtein(const DATABASE *db, const char *na, const ORF *orf, char *aa)
+{
+    long len = strlen(na), first = (orf->strand > 0) ? orf->start : len - orf->end;
+    int k, n = (int)((orf->end - orf->start) / 3) - 1;
+
+    for (k = 0; k < n; k++)
+        aa[k] = CodonAt(db, na, len, orf->strand, first + 3L * k);
+    aa[n] = '\0';
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintOrfSites:  Prints the sites of the protein of an ORF as tab          *
+*                   separated values: sequence name, ORF, strand, position,   *
+*                   reading frame, amino acids, enzyme, recognition sequence  *
+*                   and HitScore.                                             *
+*                                                                             *
+*   Input:          scan. the sites of aa, the protein of orf.                *
+*                   name. the record, up to the first white space.            *
+*                                                                             *
+*   Output:         the number of bytes written.                              *
+*                                                                             *
+*   Notes:          The ORF and the position are counted from 1 on the        *
+*                   forward strand.  The position is that of the first base   *
+*                   of the site there, which for an ORF on the reverse        *
+*                   strand is the last base of the site as read along the     *
+*                   ORF.  The frame is that of the motif along the ORF.       *
+*                                                                             *
+******************************************************************************/
+
+int PrintOrfSites(const DATABASE *db, const SCAN *scan, const char *aa, const ORF *orf,
+                  const char *name, FILE *fp)
+{
+    const OUTPUT *hit;
+    long x;
+    int k, c = 0, n = strcspn(name, " \t");
+
+    for (k = 0; k < NumHits(scan); k++)
+    {
+        hit = GetHit(scan, k);
+        x = 3L * hit->pos + hit->frame - 1;
+        if (orf->strand > 0)
+            x += orf->start;
+        else
+            x = orf->end - x - (long)strlen(EnzymeSite(db, hit->re));
+        c += fprintf(fp, "%.*s\t%ld-%ld\t%c\t%ld\t%d\t%.*s\t%s\t%s\t%.4f\n", n, name,
+                     orf->start + 1, orf->end, (orf->strand > 0) ? '+' : '-', x + 1,
+                     hit->frame, hit->number, &aa[hit->pos], EnzymeName(db, hit->re),
+                     EnzymeSite(db, hit->re), HitScore(db, aa, hit));
+    }
+    return(c);
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+*                                                                           *
+*       queue: bounded single producer, single consumer queue of            *
+*       pointers, used to connect the stages of a pipeline.                 *
+*                                                                           *
+*       Exactly one thread pushes and one thread pops.  The ring is         *
+*       indexed by two C11 atomic counters, so neither side takes a lock;   *
+*       a side that finds the ring full or empty spins briefly, then        *
+*       yields, then sleeps until the other side catches up, which gives    *
+*       the stages back pressure without a mutex or condition variable.     *
+*                                                                           *
+****************************************************************************/
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <time.h>
+
+#include "silmut.h"
+
+#define QUEUE_SPIN      64      /* polls before yielding                */
+#define QUEUE_YIELD     128     /* polls before sleeping                */
+#define QUEUE_SLEEP_NS  20000
+
+struct QUEUE
+{
+    void **item;
+    size_t mask;                /* capacity - 1, a power of 2 minus 1   */
+    _Atomic size_t head;        /* next item to pop, moved by consumer  */
+    _Atomic size_t tail;        /* next free place, moved by producer   */
+};
+
+/******************************************************************************
+*                                                                             *
+*   NewQueue:       Creates an empty queue.                                   *
+*                                                                             *
+*   Input:          capacity. the most items it holds, rounded up to a        *
+*                   power of 2.                                               *
+*                                                                             *
+*   Output:         the queue, or NULL if memory is exhausted.                *
+*                                                                             *
+******************************************************************************/
+
+QUEUE *NewQueue(int capacity)
+{
+    QUEUE *q;
+    size_t n = 1;
+
+    while ((int)n < capacity)
+        n *= 2;
+    if ((q = malloc(sizeof(QUEUE))) == NULL)
+        return(NULL);
+    if ((q->item = malloc(n * sizeof(void *))) == NULL)
+    {
+        free(q);
+        return(NULL);
+    }
+    q->mask = n - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    return(q);
+}
+
+void FreeQueue(QUEUE *q)
+{
+    if (q == NULL)
+        return;
+    free(q->item);
+    free(q);
+}
+
+/* waits a little longer each time the other side is found behind */
+static void Backoff(int *polls)
+{
+    struct timespec ts;
+
+    if (++*polls < QUEUE_SPIN)
+        return;
+    if (*polls < QUEUE_YIELD)
+    {
+        sched_yield();
+        return;
+    }
+    ts.tv_sec = 0;
+    ts.tv_nsec = QUEUE_SLEEP_NS;
+    nanosleep(&ts, NULL);
+}
+
+/******************************************************************************
+*                                                                             *
+*   QueuePush:      Adds an item at the tail, waiting while the queue is      *
+*                   full.  Only the producer thread may call it.              *
+*                                                                             *
+*   QueuePop:       Takes the item at the head, waiting while the queue is    *
+*                   empty.  Only the consumer thread may call it.             *
+*                                                                             *
+******************************************************************************/
+
+void QueuePush(QUEUE *q, void *item)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    int polls = 0;
+
+    while (tail - atomic_load_explicit(&q->head, memory_order_acquire) > q->mask)
+        Backoff(&polls);
+    q->item[tail & q->mask] = item;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+}
+
+void *QueuePop(QUEUE *q)
+{
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    void *item;
+    int polls = 0;
+
+    while (atomic_load_explicit(&q->tail, memory_order_acquire) == head)
+        Backoff(&polls);
+    item = q->item[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return(item);
+}
@@ -0,0 +1,195 @@
+/****************************************************************************
+*                                                                           *
+*       saturation: the recognition sequences created and destroyed by      *
+*       every single base substitution of a nucleic acid sequence.          *
+*                                                                           *
+*       A substitution only changes the six-mers that hold its base, so     *
+*       each one is judged from the 2-bit codes of the five bases on        *
+*       either side, kept in one 22-bit context that moves a base at a      *
+*       time.  The six-mers before and after are looked up in the table     *
+*       of sites.c and compared 64 enzymes to a word, so the 3 x length     *
+*       variants cost a few lookups each and the sequence is never          *
+*       copied or scanned again.                                            *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+#define CONTEXT_MASK    0x3fffff        /* 11 bases, 2 bits each        */
+
+static const char bases[5] = "ACGT";
+
+/* 2-bit code of a base; ValidateInput leaves only A, C, G and T */
+static int Base(char c)
+{
+    return((int)(strchr(bases, c) - bases));
+}
+
+/******************************************************************************
+*                                                                             *
+*   Effects:        Compares the six-mers holding the middle base of a        *
+*                   context before and after it is changed.                   *
+*                                                                             *
+*   Input:          ctx. bases pos - 5 to pos + 5, the first in the top bits. *
+*                   k0, k1. the six-mers starting at pos - 5 + k0 to          *
+*                   pos - 5 + k1 lie within the sequence.                     *
+*                   delta. the code of the new base XOR that of the old one.  *
+*                   created, destroyed. SiteWords(t) words each, set to the   *
+*                   enzymes recognizing a changed six-mer only after or only  *
+*                   before the change.                                        *
+*                                                                             *
+******************************************************************************/
+
+static void Effects(const SITE_TABLE *t, long ctx, int k0, int k1, int delta,
+                    uint64_t *created, uint64_t *destroyed)
+{
+    const uint64_t *before, *after;
+    long mut = ctx ^ ((long)delta << (2 * SITE_LEN - 2));
+    int k, w, nwords = SiteWords(t);
+
+    memset(created, 0, nwords * sizeof(uint64_t));
+    memset(destroyed, 0, nwords * sizeof(uint64_t));
+    for (k = k0; k <= k1; k++)
+    {
+        before = SiteBits(t, (int)(ctx >> (2 * (SITE_LEN - 1 - k))) & (SITE_CODES - 1));
+        after = SiteBits(t, (int)(mut >> (2 * (SITE_LEN - 1 - k))) & (SITE_CODES - 1));
+        for (w = 0; w < nwords; w++)
+        {
+            created[w] |= after[w] & ~before[w];
+            destroyed[w] |= before[w] & ~after[w];
+        }
+    }
+}
+
+/* the context of base pos, with the bases beyond the ends as A */
+static long Context(const char *na, long len, long pos)
+{
+    long ctx = 0, i;
+
+    for (i = pos - SITE_LEN + 1; i < pos + SITE_LEN; i++)
+        ctx = (ctx << 2) | (((i >= 0) && (i < len)) ? Base(na[i]) : 0);
+    return(ctx);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SnvSites:       The enzymes whose recognition sequence, on either         *
+*                   strand, is created or destroyed by changing one base.     *
+*                                                                             *
+*   Input:          na, len. the sequence, as normalized by ValidateInput.    *
+*                   pos. the base, counted from 0.                            *
+*                   alt. the new base.                                        *
+*                   created, destroyed. SiteWords(t) words each, set to the   *
+*                   enzymes as bits re % 64 of words re / 64.                 *
+*                                                                             *
+*   Notes:          An enzyme can be both, if the change destroys one of its  *
+*                   sites and creates another.                                *
+*                                                                             *
+******************************************************************************/
+
+void SnvSites(const SITE_TABLE *t, const char *na, long len, long pos, char alt,
+              uint64_t *created, uint64_t *destroyed)
+{
+    int k0 = (pos < SITE_LEN - 1) ? (int)(SITE_LEN - 1 - pos) : 0;
+    int k1 = (len - 1 - pos < SITE_LEN - 1) ? (int)(len - 1 - pos) : SITE_LEN - 1;
+
+    Effects(t, Context(na, len, pos), k0, k1, Base(na[pos]) ^ Base(alt), created,
+            destroyed);
+}
+
+/* writes the names of the enzymes of a bitset, comma separated, or '-' */
+static int PrintEnzymes(const DATABASE *db, const uint64_t *bits, int nwords, FILE *fp)
+{
+    uint64_t w;
+    int k, b, c = 0, first = 1;
+
+    for (k = 0; k < nwords; k++)
+    {
+        for (w = bits[k]; w; w &= w - 1)
+        {
+            for (b = 0; !((w >> b) & 1); b++)
+                ;
+            c += fprintf(fp, "%s%s", first ? "" : ",", EnzymeName(db, k * 64 + b));
+            first = 0;
+        }
+    }
+    if (first)
+        c += fprintf(fp, "-");
+    return(c);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintSaturation: Writes, for every substitution of every base that        *
+*                   creates or destroys a recognition sequence, a row of a    *
+*                   tab separated table with the enzymes affected.            *
+*                                                                             *
+*   Input:          na. the sequence, as normalized by ValidateInput.         *
+*                   name. the record, up to the first white space.            *
+*                                                                             *
+*   Output:         the number of rows written, or -1 if memory is            *
+*                   exhausted.                                                *
+*                                                                             *
+*   Notes:          The position is counted from 1.  The amino acids are      *
+*                   those of the codon in the first reading frame before and  *
+*                   after the change, '-' for a base of a partial last codon  *
+*                   or a codon without an amino acid.                         *
+*                                                                             *
+******************************************************************************/
+
+long PrintSaturation(const DATABASE *db, const SITE_TABLE *t, const char *na,
+                     const char *name, FILE *fp)
+{
+    long len = strlen(na), ctx, pos, rows = 0;
+    int nwords = SiteWords(t), n = strcspn(name, " \t"), k0, k1, alt, ref, codon, shift;
+    int w, aa, mut_aa;
+    uint64_t *created, *destroyed, any;
+
+    if ((created = malloc(2 * (nwords + 1) * sizeof(uint64_t))) == NULL)
+        return(-1);
+    destroyed = created + nwords + 1;
+
+    ctx = Context(na, len, 0);
+    for (pos = 0; pos < len; pos++)
+    {
+        k0 = (pos < SITE_LEN - 1) ? (int)(SITE_LEN - 1 - pos) : 0;
+        k1 = (len - 1 - pos < SITE_LEN - 1) ? (int)(len - 1 - pos) : SITE_LEN - 1;
+        ref = Base(na[pos]);
+        codon = -1;
+        shift = 2 * (2 - pos % 3);
+        if (pos - pos % 3 + 3 <= len)
+            codon = (Base(na[pos - pos % 3]) << 4) | (Base(na[pos - pos % 3 + 1]) << 2) |
+                    Base(na[pos - pos % 3 + 2]);
+
+        for (alt = 0; alt < 4; alt++)
+        {
+            if (alt == ref)
+                continue;
+            Effects(t, ctx, k0, k1, ref ^ alt, created, destroyed);
+            for (w = 0, any = 0; w < nwords; w++)
+                any |= created[w] | destroyed[w];
+            if (!any)
+                continue;
+
+            aa = (codon < 0) ? 0 : CodonAminoAcid(db, codon);
+            mut_aa = (codon < 0) ? 0 : CodonAminoAcid(db, codon ^ ((ref ^ alt) << shift));
+            fprintf(fp, "%.*s\t%ld\t%c\t%c\t%c\t%c\t%s\t", n, name, pos + 1, bases[ref],
+                    bases[alt], aa ? aa : '-', mut_aa ? mut_aa : '-',
+                    (!aa || !mut_aa) ? "-" : (aa == mut_aa) ? "yes" : "no");
+            PrintEnzymes(db, created, nwords, fp);
+            fputc('\t', fp);
+            PrintEnzymes(db, destroyed, nwords, fp);
+            fputc('\n', fp);
+            rows++;
+        }
+
+        /* move the context on by a base */
+        ctx = ((ctx << 2) | ((pos + SITE_LEN < len) ? Base(na[pos + SITE_LEN]) : 0)) &
+              CONTEXT_MASK;
+    }
+    free(created);
+    return(rows);
+}
@@ -0,0 +1,1112 @@
+/****************************************************************************
+*                                                                           *
+*       seqfile: sequence input for SILMUT.                                 *
+*                                                                           *
+*       A SEQFILE reads plain text, gzip or BGZF (bgzip) input; the kind    *
+*       is found from the first bytes, not from the file name.  BGZF        *
+*       blocks are independent, so with more than one thread they are       *
+*       inflated by a pool of workers several blocks ahead of the reader.   *
+*       Compressed input needs zlib (build with -DHAVE_ZLIB -lz -pthread).  *
+*       Uncompressed files are mapped, and ReadRecord then returns the      *
+*       sequence lines in place instead of copying them.  An uncompressed   *
+*       file can also be indexed, as by samtools faidx, so that one region  *
+*       of it is read without the rest.                                     *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#include <pthread.h>
+#endif
+
+#if !defined(HAVE_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define HAVE_MMAP
+#endif
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "silmut.h"
+
+#define SEQ_PLAIN   0
+#define SEQ_GZIP    1
+#define SEQ_BGZF    2
+#define SEQ_MMAP    3
+
+#define BGZF_MAX_BLOCK  65536
+#define BGZF_SLOTS_PER_THREAD   4
+
+#ifdef HAVE_ZLIB
+
+#define SLOT_EMPTY  0
+#define SLOT_READY  1       /* compressed block waiting for a worker   */
+#define SLOT_BUSY   2
+#define SLOT_DONE   3
+#define SLOT_ERROR  4
+
+typedef struct
+{
+    unsigned char cdata[BGZF_MAX_BLOCK];
+    unsigned char udata[BGZF_MAX_BLOCK];
+    int clen, ulen;
+    int state;
+} BGZF_SLOT;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+    pthread_t *threads;
+    int nthreads;
+    BGZF_SLOT *slot;
+    int nslots;
+    long next_read;         /* next block to read from the file         */
+    long next_use;          /* next block to hand to the parser         */
+    int eof, quit;
+    int closed;             /* the last block read was the EOF block    */
+} BGZF_POOL;
+
+/* the empty block that ends every BGZF file */
+static const unsigned char bgzf_eof[28] =
+{
+    0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0, 3, 0,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#endif
+
+struct SEQFILE
+{
+    int kind;
+    FILE *fp;
+    int own_fp;
+#ifdef HAVE_ZLIB
+    gzFile gz;
+    BGZF_POOL *pool;
+#endif
+    unsigned char *buf;     /* the whole file when mapped               */
+    size_t pos, len;        /* len is the end of the shard if mapped    */
+    size_t map_len;
+    int error;
+    int bgzf;               /* BGZF read as gzip, see SeqFill           */
+    int peeked, peek;       /* bytes kept back by SeqPeek               */
+    long long offset;       /* uncompressed bytes consumed              */
+};
+
+#ifdef HAVE_ZLIB
+
+/******************************************************************************
+*                                                                             *
+*   BgzfBlockSize:  Size of a BGZF block from its gzip header.                *
+*                                                                             *
+*   Input:          hdr. the first 18 bytes of the block.                     *
+*                                                                             *
+*   Output:         total size of the block, -1 if it is not a BGZF block.    *
+*                                                                             *
+******************************************************************************/
+
+static int BgzfBlockSize(const unsigned char *hdr)
+{
+    if ((hdr[0] != 0x1f) || (hdr[1] != 0x8b) || (hdr[2] != 8) || !(hdr[3] & 4))
+        return(-1);
+    if ((hdr[10] | (hdr[11] << 8)) != 6)
+        return(-1);
+    if ((hdr[12] != 'B') || (hdr[13] != 'C') || ((hdr[14] | (hdr[15] << 8)) != 2))
+        return(-1);
+    return((hdr[16] | (hdr[17] << 8)) + 1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   InflateBlock:   Inflates one BGZF block into its slot.                    *
+*                                                                             *
+*   Output:         0 on success, -1 if the block is corrupt.                 *
+*                                                                             *
+******************************************************************************/
+
+static int InflateBlock(BGZF_SLOT *s)
+{
+    z_stream z;
+    unsigned long isize, crc;
+    int ret;
+
+    if (s->clen < 26)
+        return(-1);
+    isize = s->cdata[s->clen - 4] | (s->cdata[s->clen - 3] << 8) |
+            ((unsigned long)s->cdata[s->clen - 2] << 16) |
+            ((unsigned long)s->cdata[s->clen - 1] << 24);
+    crc = s->cdata[s->clen - 8] | (s->cdata[s->clen - 7] << 8) |
+          ((unsigned long)s->cdata[s->clen - 6] << 16) |
+          ((unsigned long)s->cdata[s->clen - 5] << 24);
+    if (isize > BGZF_MAX_BLOCK)
+        return(-1);
+
+    memset(&z, 0, sizeof(z));
+    if (inflateInit2(&z, -15) != Z_OK)
+        return(-1);
+    z.next_in = s->cdata + 18;
+    z.avail_in = s->clen - 18 - 8;
+    z.next_out = s->udata;
+    z.avail_out = BGZF_MAX_BLOCK;
+    ret = inflate(&z, Z_FINISH);
+    inflateEnd(&z);
+    if ((ret != Z_STREAM_END) || (z.total_out != isize))
+        return(-1);
+    if (crc32(crc32(0L, Z_NULL, 0), s->udata, isize) != crc)
+        return(-1);
+    s->ulen = isize;
+    return(0);
+}
+
+static void *BgzfWorker(void *arg)
+{
+    BGZF_POOL *pool = arg;
+    BGZF_SLOT *s;
+    long k;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        s = NULL;
+        for (k = pool->next_use; k < pool->next_read; k++)
+        {
+            if (pool->slot[k % pool->nslots].state == SLOT_READY)
+            {
+                s = &pool->slot[k % pool->nslots];
+                break;
+            }
+        }
+        if (s == NULL)
+        {
+            if (pool->quit)
+                break;
+            pthread_cond_wait(&pool->work, &pool->lock);
+            continue;
+        }
+
+        s->state = SLOT_BUSY;
+        pthread_mutex_unlock(&pool->lock);
+        k = InflateBlock(s);
+        pthread_mutex_lock(&pool->lock);
+        s->state = (k < 0) ? SLOT_ERROR : SLOT_DONE;
+        pthread_cond_broadcast(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return(NULL);
+}
+
+/******************************************************************************
+*                                                                             *
+*   BgzfFill:       Reads compressed blocks into every free slot, then waits  *
+*                   for the next block in file order to be inflated.          *
+*                                                                             *
+*   Output:         1 with the block in sf->buf, 0 at the end of the file,    *
+*                   -1 on a corrupt or truncated block.                       *
+*                                                                             *
+*   Notes:          A file that ends without the EOF block was cut short      *
+*                   between two blocks, which counts as a truncated block.    *
+*                                                                             *
+******************************************************************************/
+
+static int BgzfFill(SEQFILE *sf)
+{
+    BGZF_POOL *pool = sf->pool;
+    BGZF_SLOT *s;
+    unsigned char hdr[18];
+    int size, state;
+
+    pthread_mutex_lock(&pool->lock);
+
+    /* The slot handed out last time is free again */
+    if (pool->next_use > 0)
+        pool->slot[(pool->next_use - 1) % pool->nslots].state = SLOT_EMPTY;
+
+    while (!pool->eof && (pool->next_read - pool->next_use < pool->nslots))
+    {
+        s = &pool->slot[pool->next_read % pool->nslots];
+        pthread_mutex_unlock(&pool->lock);
+
+        size = fread(hdr, 1, 18, sf->fp);
+        if ((size == 0) && pool->closed)
+            state = -1;
+        else if ((size < 18) || ((size = BgzfBlockSize(hdr)) < 26) ||
+                 (size > BGZF_MAX_BLOCK) ||
+                 (fread(s->cdata + 18, 1, size - 18, sf->fp) != (size_t)(size - 18)))
+            state = SLOT_ERROR;
+        else
+        {
+            memcpy(s->cdata, hdr, 18);
+            s->clen = size;
+            state = SLOT_READY;
+            pool->closed = (size == 28) && !memcmp(s->cdata, bgzf_eof, 28);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (state < 0)
+        {
+            pool->eof = 1;
+            break;
+        }
+        s->state = state;
+        pool->next_read++;
+        if (state == SLOT_ERROR)
+            pool->eof = 1;
+        pthread_cond_signal(&pool->work);
+    }
+
+    if (pool->next_use == pool->next_read)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return(0);
+    }
+
+    s = &pool->slot[pool->next_use % pool->nslots];
+    while ((s->state == SLOT_READY) || (s->state == SLOT_BUSY))
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pool->next_use++;
+    state = s->state;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (state != SLOT_DONE)
+        return(-1);
+    sf->buf = s->udata;
+    sf->pos = 0;
+    sf->len = s->ulen;
+    return(1);
+}
+
+/* 1 if a file ends with the EOF block of BGZF */
+static int BgzfClosed(FILE *fp)
+{
+    unsigned char tail[28];
+
+    return((fseek(fp, -28, SEEK_END) == 0) && (fread(tail, 1, 28, fp) == 28) &&
+           !memcmp(tail, bgzf_eof, 28));
+}
+
+static BGZF_POOL *NewBgzfPool(int nthreads)
+{
+    BGZF_POOL *pool;
+    int i;
+
+    if ((pool = calloc(1, sizeof(BGZF_POOL))) == NULL)
+        return(NULL);
+    pool->nslots = nthreads * BGZF_SLOTS_PER_THREAD;
+    pool->slot = calloc(pool->nslots, sizeof(BGZF_SLOT));
+    pool->threads = calloc(nthreads, sizeof(pthread_t));
+    if ((pool->slot == NULL) || (pool->threads == NULL))
+    {
+        free(pool->slot);
+        free(pool->threads);
+        free(pool);
+        return(NULL);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < nthreads; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, BgzfWorker, pool) != 0)
+            break;
+    }
+    pool->nthreads = i;
+    if (i == 0)
+    {
+        /* No worker: inflate in the reader instead */
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->work);
+        pthread_cond_destroy(&pool->done);
+        free(pool->slot);
+        free(pool->threads);
+        free(pool);
+        return(NULL);
+    }
+    return(pool);
+}
+
+static void FreeBgzfPool(BGZF_POOL *pool)
+{
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->nthreads; i++)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    free(pool->slot);
+    free(pool->threads);
+    free(pool);
+}
+
+#endif
+
+/******************************************************************************
+*                                                                             *
+*   OpenSeqFile:    Opens a sequence file.                                    *
+*                                                                             *
+*   Input:          fname. file name, or NULL for the standard input.         *
+*                   nthreads. threads for inflating BGZF input; 1 or less     *
+*                   inflates in the calling thread.                           *
+*                                                                             *
+*   Output:         the SEQFILE, or NULL if the file cannot be opened or is   *
+*                   compressed and zlib support is not built in.              *
+*                                                                             *
+******************************************************************************/
+
+SEQFILE *OpenSeqFile(const char *fname, int nthreads)
+{
+    SEQFILE *sf;
+    int c1, c2;
+
+    if ((sf = calloc(1, sizeof(SEQFILE))) == NULL)
+        return(NULL);
+
+    if (fname == NULL)
+        sf->fp = stdin;
+    else if ((sf->fp = fopen(fname, "rb")) == NULL)
+    {
+        free(sf);
+        return(NULL);
+    }
+    sf->own_fp = (fname != NULL);
+    sf->kind = SEQ_PLAIN;
+
+    /* Only regular files are sniffed, so that an interactive standard
+       input is never read ahead of the prompts. */
+    if (fname == NULL)
+        return(sf);
+
+    c1 = getc(sf->fp);
+    c2 = (c1 == EOF) ? EOF : getc(sf->fp);
+    if ((c1 != 0x1f) || (c2 != 0x8b))
+    {
+        rewind(sf->fp);
+#ifdef HAVE_MMAP
+        {
+            struct stat st;
+            void *map;
+
+            if ((fstat(fileno(sf->fp), &st) == 0) && S_ISREG(st.st_mode) &&
+                    (st.st_size > 0) && ((map = mmap(NULL, st.st_size, PROT_READ,
+                                           MAP_PRIVATE, fileno(sf->fp), 0)) != MAP_FAILED))
+            {
+                posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+                sf->buf = map;
+                sf->len = sf->map_len = st.st_size;
+                sf->kind = SEQ_MMAP;
+            }
+        }
+#endif
+        return(sf);
+    }
+
+#ifdef HAVE_ZLIB
+    {
+        unsigned char hdr[18];
+
+        rewind(sf->fp);
+        sf->bgzf = (fread(hdr, 1, 18, sf->fp) == 18) && (BgzfBlockSize(hdr) > 0);
+        if (sf->bgzf && (nthreads > 1) && ((sf->pool = NewBgzfPool(nthreads)) != NULL))
+        {
+            rewind(sf->fp);
+            sf->kind = SEQ_BGZF;
+            return(sf);
+        }
+        if ((sf->gz = gzopen(fname, "rb")) != NULL)
+        {
+            if ((sf->buf = malloc(BGZF_MAX_BLOCK)) != NULL)
+            {
+                sf->kind = SEQ_GZIP;
+                return(sf);
+            }
+            gzclose(sf->gz);
+        }
+    }
+#else
+    (void)nthreads;
+#endif
+
+    fclose(sf->fp);
+    free(sf);
+    return(NULL);
+}
+
+void CloseSeqFile(SEQFILE *sf)
+{
+    if (sf == NULL)
+        return;
+#ifdef HAVE_ZLIB
+    if (sf->kind == SEQ_GZIP)
+    {
+        gzclose(sf->gz);
+        free(sf->buf);
+    }
+    if (sf->kind == SEQ_BGZF)
+        FreeBgzfPool(sf->pool);
+#endif
+#ifdef HAVE_MMAP
+    if (sf->kind == SEQ_MMAP)
+        munmap(sf->buf, sf->map_len);
+#endif
+    if (sf->own_fp)
+        fclose(sf->fp);
+    free(sf);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqFill:        Refills the buffer of a compressed SEQFILE; a mapped      *
+*                   file is all in the buffer already.                        *
+*                                                                             *
+*   Output:         1 if there is more input, 0 at the end, -1 on an error.   *
+*                                                                             *
+*   Notes:          gzread ends quietly at a cut in the data, so its error    *
+*                   state is checked there.  A BGZF file read through it      *
+*                   must also end with the EOF block, or it was cut between   *
+*                   two blocks.                                               *
+*                                                                             *
+******************************************************************************/
+
+static int SeqFill(SEQFILE *sf)
+{
+#ifdef HAVE_ZLIB
+    int n, err;
+
+    if (sf->kind == SEQ_BGZF)
+    {
+        while ((n = BgzfFill(sf)) > 0)
+        {
+            if (sf->len > 0)
+                return(1);
+        }
+        if (n < 0)
+            sf->error = 1;
+        return(n);
+    }
+    if (sf->kind == SEQ_GZIP)
+    {
+        n = gzread(sf->gz, sf->buf, BGZF_MAX_BLOCK);
+        if (n == 0)
+        {
+            gzerror(sf->gz, &err);
+            if ((err != Z_OK) || (sf->bgzf && !BgzfClosed(sf->fp)))
+                n = -1;
+        }
+        if (n < 0)
+        {
+            sf->error = 1;
+            return(-1);
+        }
+        sf->pos = 0;
+        sf->len = n;
+        return(n > 0);
+    }
+#endif
+    (void)sf;
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqGetc:        Reads the next uncompressed character, like fgetc.        *
+*                                                                             *
+******************************************************************************/
+
+int SeqGetc(SEQFILE *sf)
+{
+    if (sf->peeked)
+    {
+        sf->peeked = 0;
+        sf->offset++;
+        return(sf->peek);
+    }
+    if (sf->kind == SEQ_PLAIN)
+    {
+        int c = getc(sf->fp);
+
+        if (c != EOF)
+            sf->offset++;
+        return(c);
+    }
+    if ((sf->pos >= sf->len) && (SeqFill(sf) <= 0))
+        return(EOF);
+    sf->offset++;
+    return(sf->buf[sf->pos++]);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqPeek:        Returns the next character without consuming it.          *
+*                                                                             *
+******************************************************************************/
+
+int SeqPeek(SEQFILE *sf)
+{
+    int c;
+
+    if (sf->peeked)
+        return(sf->peek);
+    if ((c = SeqGetc(sf)) == EOF)
+        return(EOF);
+    sf->offset--;
+    sf->peeked = 1;
+    sf->peek = c;
+    return(c);
+}
+
+int SeqError(const SEQFILE *sf)
+{
+    return(sf->error || ((sf->kind == SEQ_PLAIN) && ferror(sf->fp)));
+}
+
+long long SeqOffset(const SEQFILE *sf)
+{
+    return(sf->offset);
+}
+
+int SeqInteractive(const SEQFILE *sf)
+{
+    return(sf->fp == stdin);
+}
+
+/******************************************************************************
+*                                                                             *
+*   GrowString:     Makes room for at least n + 1 characters in a string.     *
+*                                                                             *
+******************************************************************************/
+
+static int GrowString(char **str, size_t *cap, size_t n)
+{
+    char *p;
+    size_t size = *cap ? *cap : 256;
+
+    if (n < *cap)
+        return(0);
+    while (size <= n)
+        size *= 2;
+    if ((p = realloc(*str, size)) == NULL)
+        return(-1);
+    *str = p;
+    *cap = size;
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqGetLine:     Reads one line without its end of line (LF or CR LF).     *
+*                                                                             *
+*   Input:          line, cap. buffer grown as needed.                        *
+*                                                                             *
+*   Output:         the length of the line, -1 at the end of the input or if  *
+*                   memory is exhausted.                                      *
+*                                                                             *
+******************************************************************************/
+
+long SeqGetLine(SEQFILE *sf, char **line, size_t *cap)
+{
+    long n = 0;
+    int c;
+    const char *p, *eol;
+
+    if ((sf->kind == SEQ_MMAP) && !sf->peeked)
+    {
+        if (sf->pos >= sf->len)
+            return(-1);
+        p = (const char *)&sf->buf[sf->pos];
+        eol = memchr(p, '\n', sf->len - sf->pos);
+        n = eol ? eol - p : (long)(sf->len - sf->pos);
+        sf->pos += n + (eol != NULL);
+        sf->offset = sf->pos;
+        if ((n > 0) && (p[n - 1] == '\r'))
+            n--;
+        if (GrowString(line, cap, n) < 0)
+            return(-1);
+        memcpy(*line, p, n);
+        (*line)[n] = '\0';
+        return(n);
+    }
+
+    if ((c = SeqGetc(sf)) == EOF)
+        return(-1);
+    while ((c != '\n') && (c != EOF))
+    {
+        if (GrowString(line, cap, n + 1) < 0)
+            return(-1);
+        (*line)[n++] = c;
+        c = SeqGetc(sf);
+    }
+    if ((n > 0) && ((*line)[n - 1] == '\r'))
+        n--;
+    if (GrowString(line, cap, n) < 0)
+        return(-1);
+    (*line)[n] = '\0';
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   MapRecord:      ReadRecord on a mapped file.  Record boundaries are       *
+*                   found with memchr and the sequence is left in place.      *
+*                                                                             *
+******************************************************************************/
+
+static int MapRecord(SEQFILE *sf, RECORD *rec)
+{
+    const char *buf = (const char *)sf->buf, *end = buf + sf->len, *p, *q;
+
+    if (sf->peeked)
+    {
+        /* the peeked byte is still in the mapping */
+        sf->peeked = 0;
+        sf->pos--;
+    }
+
+    for (p = buf + sf->pos; (p < end) && (*p != '>'); p = q ? q + 1 : end)
+        q = memchr(p, '\n', end - p);
+    sf->pos = p - buf;
+    sf->offset = sf->pos;
+    if (p == end)
+        return(0);
+
+    rec->offset = sf->offset;
+    sf->pos++;
+    if (SeqGetLine(sf, &rec->name, &rec->name_cap) < 0)
+    {
+        if (GrowString(&rec->name, &rec->name_cap, 0) < 0)
+            return(-1);
+        rec->name[0] = '\0';
+    }
+
+    /* the sequence runs up to the next line starting with '>' */
+    p = buf + sf->pos;
+    for (q = p; (q = memchr(q, '>', end - q)) != NULL; q++)
+    {
+        if (q[-1] == '\n')
+            break;
+    }
+    if (q == NULL)
+        q = end;
+
+    rec->raw = p;
+    rec->raw_len = q - p;
+    rec->len = 0;
+    sf->pos = q - buf;
+    sf->offset = sf->pos;
+    return(1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ReadRecord:     Reads the next FASTA record.                              *
+*                                                                             *
+*   Input:          rec. record whose buffers are reused and grown.           *
+*                                                                             *
+*   Output:         1 if a record was read, 0 at the end of the input, -1 if  *
+*                   memory is exhausted.                                      *
+*                                                                             *
+*   Notes:          Text before the first '>' is skipped.  The record ends    *
+*                   at the next line starting with '>'.  rec->raw is the      *
+*                   sequence lines as they are in the input, line ends        *
+*                   included; a mapped file is not copied at all.  The line   *
+*                   ends, spaces and digits are left for Check_Input.         *
+*                                                                             *
+******************************************************************************/
+
+int ReadRecord(SEQFILE *sf, RECORD *rec)
+{
+    int c, last;
+
+    if (sf->kind == SEQ_MMAP)
+        return(MapRecord(sf, rec));
+
+    while (((c = SeqPeek(sf)) != '>') && (c != EOF))
+        SeqGetLine(sf, &rec->seq, &rec->seq_cap);
+    if (c == EOF)
+        return(0);
+
+    rec->offset = SeqOffset(sf);
+    SeqGetc(sf);
+    if (SeqGetLine(sf, &rec->name, &rec->name_cap) < 0)
+    {
+        if (GrowString(&rec->name, &rec->name_cap, 0) < 0)
+            return(-1);
+        rec->name[0] = '\0';
+    }
+
+    rec->len = 0;
+    if (GrowString(&rec->seq, &rec->seq_cap, 0) < 0)
+        return(-1);
+    last = '\n';
+    while ((c = SeqPeek(sf)) != EOF)
+    {
+        if ((c == '>') && (last == '\n'))
+            break;
+        last = c = SeqGetc(sf);
+        if (GrowString(&rec->seq, &rec->seq_cap, rec->len + 1) < 0)
+            return(-1);
+        rec->seq[rec->len++] = c;
+    }
+    rec->seq[rec->len] = '\0';
+    rec->raw = rec->seq;
+    rec->raw_len = rec->len;
+    return(1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RecordSequence: Returns the sequence lines of a record as a string that   *
+*                   Check_Input may normalize in place, copying them out of   *
+*                   the mapping if the file is mapped.                        *
+*                                                                             *
+*   Output:         rec->seq, or NULL if memory is exhausted.                 *
+*                                                                             *
+******************************************************************************/
+
+char *RecordSequence(RECORD *rec)
+{
+    if (rec->raw == rec->seq)
+        return(rec->seq);
+    if (GrowString(&rec->seq, &rec->seq_cap, rec->raw_len) < 0)
+        return(NULL);
+    memcpy(rec->seq, rec->raw, rec->raw_len);
+    rec->seq[rec->raw_len] = '\0';
+    rec->len = rec->raw_len;
+    rec->raw = rec->seq;
+    return(rec->seq);
+}
+
+void FreeRecord(RECORD *rec)
+{
+    free(rec->name);
+    free(rec->seq);
+    memset(rec, 0, sizeof(RECORD));
+}
+
+/* the first offset from off on where a record starts, or the end of the file */
+static size_t RecordStart(const SEQFILE *sf, size_t off)
+{
+    const char *buf = (const char *)sf->buf, *p;
+
+    if (off == 0)
+        return(0);
+    for (p = buf + off - 1; (p = memchr(p, '\n', sf->map_len - (p - buf))) != NULL; p++)
+    {
+        if ((p + 1 < buf + sf->map_len) && (p[1] == '>'))
+            return(p + 1 - buf);
+    }
+    return(sf->map_len);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqShard:       Limits a FASTA file to one of a number of shards, so      *
+*                   that ReadRecord only returns the records of that shard.   *
+*                                                                             *
+*   Input:          shard. the shard, from 0 to nshards - 1.                  *
+*                                                                             *
+*   Output:         0 on success, -1 if the file is not mapped (compressed    *
+*                   or not a regular file) or has been read from already.     *
+*                                                                             *
+*   Notes:          Shard i holds the records whose '>' is in the i-th of     *
+*                   nshards equal byte ranges of the file, so the shards      *
+*                   depend on the file alone and together hold every record   *
+*                   once, in order.  Text before the first record belongs to  *
+*                   shard 0.                                                  *
+*                                                                             *
+******************************************************************************/
+
+int SeqShard(SEQFILE *sf, int shard, int nshards)
+{
+    unsigned long long size = sf->map_len;
+
+    if ((sf->kind != SEQ_MMAP) || sf->peeked || (sf->pos != 0) || (shard < 0) ||
+            (shard >= nshards))
+        return(-1);
+    sf->pos = RecordStart(sf, (size_t)(size * shard / nshards));
+    sf->len = RecordStart(sf, (size_t)(size * (shard + 1) / nshards));
+    sf->offset = sf->pos;
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqSeek:        Moves on to an offset of the uncompressed input, e.g.     *
+*                   that of a record found in an earlier run.                 *
+*                                                                             *
+*   Output:         0 on success, -1 if the offset is behind the current one  *
+*                   or past the end of the input (or of the shard).           *
+*                                                                             *
+*   Notes:          A mapped file is moved in at once; compressed input is    *
+*                   inflated and thrown away up to the offset.                *
+*                                                                             *
+******************************************************************************/
+
+int SeqSeek(SEQFILE *sf, long long offset)
+{
+    size_t n;
+
+    if (offset < sf->offset)
+        return(-1);
+
+    /* a peeked character is the one at the current offset */
+    if (sf->peeked && (offset > sf->offset))
+        SeqGetc(sf);
+    if (sf->peeked)
+        return(0);
+    if (sf->kind == SEQ_MMAP)
+    {
+        if (offset > (long long)sf->len)
+            return(-1);
+        sf->pos = offset;
+        sf->offset = offset;
+        return(0);
+    }
+    while (sf->offset < offset)
+    {
+        if (sf->kind == SEQ_PLAIN)
+        {
+            if (SeqGetc(sf) == EOF)
+                return(-1);
+            continue;
+        }
+        if ((sf->pos >= sf->len) && (SeqFill(sf) <= 0))
+            return(-1);
+        n = sf->len - sf->pos;
+        if ((long long)n > offset - sf->offset)
+            n = offset - sf->offset;
+        sf->pos += n;
+        sf->offset += n;
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   IndexFasta:     Writes the index of a FASTA file, in the .fai format of   *
+*                   samtools faidx, to the file name followed by ".fai".      *
+*                                                                             *
+*   Output:         0 on success, -1 if the file cannot be read or written,   *
+*                   is compressed, or a record has lines of uneven length.    *
+*                                                                             *
+*   Notes:          Each line of the index gives the name of a record (up to  *
+*                   the first white space), its length in bases, the offset   *
+*                   of its first base, and the bases and bytes in each line.  *
+*                                                                             *
+******************************************************************************/
+
+int IndexFasta(const char *fname)
+{
+    SEQFILE *sf;
+    FILE *fp = NULL;
+    char *line = NULL, *fai;
+    size_t cap = 0;
+    long long offset = 0, length = 0, prev;
+    long n, bases = 0, width = 0, named = 0, ended = 0, status = 0;
+
+    if ((sf = OpenSeqFile(fname, 1)) == NULL)
+        return(-1);
+    if (((sf->kind != SEQ_MMAP) && (sf->kind != SEQ_PLAIN)) ||
+            ((fai = malloc(strlen(fname) + 5)) == NULL))
+    {
+        CloseSeqFile(sf);
+        return(-1);
+    }
+    sprintf(fai, "%s.fai", fname);
+    if ((fp = fopen(fai, "w")) == NULL)
+        status = -1;
+
+    for (prev = 0; (status == 0) && ((n = SeqGetLine(sf, &line, &cap)) >= 0);
+            prev = SeqOffset(sf))
+    {
+        if (line[0] == '>')
+        {
+            if (named)
+                fprintf(fp, "\t%lld\t%lld\t%ld\t%ld\n", length, offset, bases, width);
+            fprintf(fp, "%.*s", (int)strcspn(&line[1], " \t"), &line[1]);
+            named = 1;
+            offset = SeqOffset(sf);
+            length = bases = width = ended = 0;
+        }
+        else if (!named || (n == 0))
+            ended = named;
+        else if (ended || ((bases > 0) && (n > bases)))
+            status = -1;
+        else
+        {
+            if (bases == 0)
+            {
+                bases = n;
+                width = SeqOffset(sf) - prev;
+            }
+            else if ((n != bases) || (SeqOffset(sf) - prev != width))
+                ended = 1;
+            length += n;
+        }
+    }
+    if (named && (status == 0))
+        fprintf(fp, "\t%lld\t%lld\t%ld\t%ld\n", length, offset, bases, width);
+
+    if ((fp != NULL) && (fclose(fp) != 0))
+        status = -1;
+    if ((status < 0) || SeqError(sf))
+    {
+        remove(fai);
+        status = -1;
+    }
+    free(line);
+    free(fai);
+    CloseSeqFile(sf);
+    return(status);
+}
+
+/* splits chr:start-end, 1-based and inclusive, the numbers maybe with commas */
+static int ParseRegion(const char *region, char *name, long long *start, long long *end)
+{
+    const char *colon = strrchr(region, ':'), *p;
+    long long *x = start;
+
+    strcpy(name, region);
+    *start = 1;
+    *end = -1;
+    if ((colon == NULL) || (colon[1] == '\0') || (strspn(colon + 1, "0123456789,-") <
+            strlen(colon + 1)))
+        return(0);
+
+    name[colon - region] = '\0';
+    for (*start = 0, p = colon + 1; *p; p++)
+    {
+        if (*p == '-')
+        {
+            if ((x == end) || (p[1] == '\0'))
+                return(-1);
+            x = end;
+            *end = 0;
+        }
+        else if (*p != ',')
+            *x = *x * 10 + (*p - '0');
+    }
+    return(((*start < 1) || ((*end >= 0) && (*end < *start))) ? -1 : 0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   FetchRegion:    Reads one region of a FASTA file through its index, from  *
+*                   IndexFasta, without reading the rest of the file.         *
+*                                                                             *
+*   Input:          region. name of a record, alone or as name:start or       *
+*                   name:start-end, the bases counted from 1.                 *
+*                   start. set to the offset in the record of the first base  *
+*                   of the region, from 0.                                    *
+*                                                                             *
+*   Output:         the bases of the region as a new string, or NULL if the   *
+*                   index cannot be read, the region is not in it or does     *
+*                   not agree with the file, or memory is exhausted.          *
+*                                                                             *
+*   Notes:          An end past the end of the record is taken as the end of  *
+*                   the record.  Only the bytes of the region are mapped.     *
+*                                                                             *
+******************************************************************************/
+
+char *FetchRegion(const char *fname, const char *region, long long *start)
+{
+    SEQFILE *sf;
+    char *line = NULL, *name, *seq = NULL;
+    size_t cap = 0;
+    long long first, last, length = -1, offset = 0, from, to, i;
+    long bases = 0, width = 0, n;
+    FILE *fp;
+
+    if ((name = malloc(strlen(fname) + strlen(region) + 5)) == NULL)
+        return(NULL);
+    sprintf(name, "%s.fai", fname);
+    sf = OpenSeqFile(name, 1);
+    if ((sf == NULL) || (ParseRegion(region, name, &first, &last) < 0))
+    {
+        CloseSeqFile(sf);
+        free(name);
+        return(NULL);
+    }
+    while ((length < 0) && ((n = SeqGetLine(sf, &line, &cap)) >= 0))
+    {
+        n = strcspn(line, "\t");
+        if ((strlen(name) == (size_t)n) && !strncmp(line, name, n) &&
+                (sscanf(&line[n], "%lld %lld %ld %ld", &length, &offset, &bases,
+                        &width) != 4))
+            length = -1;
+    }
+    free(line);
+    free(name);
+    CloseSeqFile(sf);
+
+    if ((last < 0) || (last > length))
+        last = length;
+    if ((length < 0) || (first > last) || (bases <= 0) || (width < bases) ||
+            ((seq = malloc(last - first + 2)) == NULL) || ((fp = fopen(fname, "rb")) == NULL))
+    {
+        free(seq);
+        return(NULL);
+    }
+
+    /* the bytes from the first base to the last, line ends included */
+    first--;
+    from = offset + first / bases * width + first % bases;
+    to = offset + (last - 1) / bases * width + (last - 1) % bases + 1;
+    n = 0;
+#ifdef HAVE_MMAP
+    {
+        long long page = sysconf(_SC_PAGESIZE), base = from / page * page;
+        const char *bytes;
+        void *map;
+
+        if ((map = mmap(NULL, to - base, PROT_READ, MAP_PRIVATE, fileno(fp), base)) !=
+                MAP_FAILED)
+        {
+            bytes = (const char *)map + (from - base);
+            for (i = 0; (i < to - from) && (n < last - first); i++)
+            {
+                if ((bytes[i] != '\n') && (bytes[i] != '\r'))
+                    seq[n++] = bytes[i];
+            }
+            munmap(map, to - base);
+        }
+    }
+#else
+    {
+        char buf[4096];
+        size_t k, got;
+
+        if (fseek(fp, (long)from, SEEK_SET) == 0)
+        {
+            for (i = from; (i < to) && ((got = fread(buf, 1, sizeof(buf), fp)) > 0); i += got)
+            {
+                for (k = 0; (k < got) && (n < last - first); k++)
+                {
+                    if ((buf[k] != '\n') && (buf[k] != '\r'))
+                        seq[n++] = buf[k];
+                }
+            }
+        }
+    }
+#endif
+    fclose(fp);
+
+    /* a stale index points at the wrong bytes */
+    if (n != last - first)
+    {
+        free(seq);
+        return(NULL);
+    }
+    seq[n] = '\0';
+    *start = first;
+    return(seq);
+}
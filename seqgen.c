@@ -0,0 +1,100 @@
+/****************************************************************************
+*                                                                           *
+*       seqgen: deterministic generator of random sequences.                *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "seqgen.h"
+
+void SeedSeqGen(SEQGEN *g, uint64_t seed)
+{
+    g->s = seed ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+/******************************************************************************
+*                                                                             *
+*   SeqGenNext:     Returns the next 64-bit number of the generator.          *
+*                                                                             *
+*   Notes:          xorshift64* generator; it is fast enough to produce a     *
+*                   gigabase sequence in a few seconds.                       *
+*                                                                             *
+******************************************************************************/
+
+uint64_t SeqGenNext(SEQGEN *g)
+{
+    g->s ^= g->s >> 12;
+    g->s ^= g->s << 25;
+    g->s ^= g->s >> 27;
+    return(g->s * 0x2545F4914F6CDD1DULL);
+}
+
+double SeqGenUniform(SEQGEN *g)
+{
+    return((SeqGenNext(g) >> 11) * (1.0 / 9007199254740992.0));
+}
+
+/******************************************************************************
+*                                                                             *
+*   RandomNA:       Fills a string with random bases.                         *
+*                                                                             *
+*   Input:          str. string of at least len + 1 characters.               *
+*                   gc. fraction of G and C bases.                            *
+*                                                                             *
+******************************************************************************/
+
+void RandomNA(SEQGEN *g, char *str, size_t len, double gc)
+{
+    size_t i;
+    uint64_t r, limit = (uint64_t)(gc * 4294967296.0);
+
+    for (i = 0; i < len; i++)
+    {
+        r = SeqGenNext(g);
+        if ((r >> 32) < limit)
+            str[i] = (r & 1) ? 'G' : 'C';
+        else
+            str[i] = (r & 1) ? 'T' : 'A';
+    }
+    str[len] = '\0';
+}
+
+/******************************************************************************
+*                                                                             *
+*   RandomAA:       Fills a string with amino acids drawn uniformly from an   *
+*                   alphabet.                                                 *
+*                                                                             *
+******************************************************************************/
+
+void RandomAA(SEQGEN *g, char *str, size_t len, const char *alphabet)
+{
+    size_t i, n = strlen(alphabet);
+
+    for (i = 0; i < len; i++)
+        str[i] = alphabet[(SeqGenNext(g) >> 33) % n];
+    str[len] = '\0';
+}
+
+/******************************************************************************
+*                                                                             *
+*   WriteRandomDataBase_RE: Writes n random six-base recognition sequences in *
+*                       the format of dbase2.                                 *
+*                                                                             *
+*   Output:             0 on success, -1 on a write error.                    *
+*                                                                             *
+******************************************************************************/
+
+int WriteRandomDataBase_RE(SEQGEN *g, FILE *fp, int n, double gc)
+{
+    int i;
+    char site[7];
+
+    for (i = 0; i < n; i++)
+    {
+        RandomNA(g, site, 6, gc);
+        fprintf(fp, "%s Rnd%d\n", site, i + 1);
+    }
+    return(ferror(fp) ? -1 : 0);
+}
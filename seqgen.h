@@ -0,0 +1,28 @@
+/****************************************************************************
+*                                                                           *
+*       seqgen: deterministic generator of random nucleic acid and amino    *
+*       acid sequences and Restriction Enzyme databases, for measuring      *
+*       and checking the SILMUT engine.  The same seed always gives the     *
+*       same sequences on every platform.                                   *
+*                                                                           *
+****************************************************************************/
+#ifndef SEQGEN_H
+#define SEQGEN_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint64_t s;
+} SEQGEN;
+
+void SeedSeqGen(SEQGEN *g, uint64_t seed);
+uint64_t SeqGenNext(SEQGEN *g);
+double SeqGenUniform(SEQGEN *g);
+void RandomNA(SEQGEN *g, char *str, size_t len, double gc);
+void RandomAA(SEQGEN *g, char *str, size_t len, const char *alphabet);
+int WriteRandomDataBase_RE(SEQGEN *g, FILE *fp, int n, double gc);
+
+#endif
@@ -1,4 +1,3 @@
-
 /****************************************************************************
 *                                                                           *
 *       Program (SILMUT) for recognizing the potential mutation sites       *
@@ -10,1029 +9,2089 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "silmut.h"
 
-#define MAX_NO_RE   100
-#define MAX_NO_AA   64
-#define MAX_NO_NA   4
-#define MAX_MS   200
 #define FILE_NAME_SIZE 12
-#define MAX_INPUT_LEN  256
-#define AA_PER_LINE  35
-#define LINELEN 80
+#define DESIGN_TOP     10
+#define MAX_MOTIF      8
+#define CHECKPOINT_SECS 10
+#define TSV_HEADER      "#sequence\tposition\tframe\tamino_acids\tenzyme\tsite\tscore\n"
+
+/* output modes, see modes[] */
+#define MODE_SITES          0
+#define MODE_SUMMARY        1
+#define MODE_DENSITY        2
+#define MODE_CONSERVED      3
+#define MODE_DIFF           4
+#define MODE_SATURATION     5
+#define MODE_DOMESTICATE    6
+#define MODE_ORFS           7
+#define MODE_DESIGN         8
+#define MODE_ATLAS          9
+#define MODE_REGION         10
+
 typedef struct
 {
-    char f_aa[20];
-    char s_aa[20];
-    char t_aa[20];
-} RF;
+    DATABASE *db;
+    SCAN *scan;
+    STATS *stats;
+    FILE *res;
+    CACHE *cache;
+    FILE *out;              /* output while res collects a result    */
+    char *buf;
+    size_t nbuf;
+    DESIGN_SITE site[MAX_DESIGN];   /* --design: the enzymes wanted     */
+    int nsites, max_edits, top;
+    int tsv, by_score;              /* -f tsv, --sort score             */
+    double min_score;
+    const char *name;               /* FASTA record being analyzed      */
+    ATLAS *atlas;                   /* --atlas, to look for --motif     */
+    const char *motifs;
+    SUMMARY *summary;               /* --summary: counts only           */
+    CONSERVED *conserved;           /* --conserved: sites of alignment  */
+    SITE_TABLE *sites;              /* --diff, --saturation and         */
+                                    /* --domesticate: six-mers          */
+    long long start;                /* -r: offset of the region, or -1  */
+    long long first;                /* offset the input is read from    */
+    int window, step, wig;          /* --density track, -f wig          */
+    int min_orf;                    /* --orfs: fewest codons, or 0      */
+    const char *checkpoint;         /* --checkpoint file, or NULL       */
+    time_t checkpoint_due;
+} RUN;
+
+int GetNum(SEQFILE *fp)
+{
+    int i, j, c, opt;
+    char str[20];
 
-typedef struct
+    c = SeqGetc(fp);
+    i = 0;
+    while ((c != '\n') && (c != EOF))
+    {
+        if ((i < 19) && (c != '\r'))
+            str[i++] = c;
+        c = SeqGetc(fp);
+    }
+    str[i] = '\0';
+
+    if (c == EOF)
+        return(EOF);
+
+    if (i == 0)
+        return(0);
+
+    j = 0;
+    opt = 0;
+    while (j < i)
+    {
+        if (isdigit((unsigned char)str[j]))
+        {
+            opt = opt * 10 + (str[j] - '0');
+            j++;
+        }
+        else if (str[j] == ' ')
+        {
+            while (str[j] == ' ')
+                j++;
+        }
+        else
+            return(0);
+    }
+
+    return(opt);
+
+}
+
+/* copies the --motif k-mer at p, returning its length */
+static int NextMotif(const char *p, char *motif)
 {
-    char name[45];
-    char na[7];
-} RE;
+    int k = strcspn(p, ",");
 
-typedef struct
+    if (k > MAX_MOTIF)
+        k = MAX_MOTIF + 1;
+    memcpy(motif, p, k);
+    motif[k] = '\0';
+    return(k);
+}
+
+/* 0 if every --motif is a k-mer of the atlas, -1 otherwise */
+static int CheckMotifs(RUN *run)
 {
-    char nucleic_acid[4];
-    char aa;
-} AA;
+    char motif[MAX_MOTIF + 2];
+    const char *p;
+    int k;
 
-typedef struct
+    for (p = run->motifs; ; p += k + 1)
+    {
+        k = NextMotif(p, motif);
+        if (AtlasScan(run->atlas, motif, "", NULL, 0) < 0)
+            return(-1);
+        if (p[k] != ',')
+            return(0);
+    }
+}
+
+/* Prints where the --motif k-mers of the atlas can be introduced */
+static int PrintMotifs(RUN *run, const char *str)
 {
-    int pos;
-    int number;
-    char name[45];
-    char na[7];
-}  OUTPUT;
-
-RF f_rf[MAX_NO_RE], s_rf[MAX_NO_RE], t_rf[MAX_NO_RE];
-RE res_enzyme[MAX_NO_RE];
-AA amino_acid[MAX_NO_AA];
-OUTPUT out[MAX_MS];
-char base[5] = { 'A', 'C', 'G', 'T', '\0' };
-char valid_aa[MAX_NO_AA + 1];
-int nre, naa, nout;
-
-int IsChIn(char *str, char c);
-int ConvertNAToAA(char *in_str, char **aa, int option);
-int Duplicate(char *str[], int n);
-void  main(int argc, char *argv[]);
+    char motif[MAX_MOTIF + 2];
+    const char *p;
+    OUTPUT *out;
+    int i, k, n, c = 0;
+
+    if ((out = malloc((3 * strlen(str) + 1) * sizeof(OUTPUT))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    for (p = run->motifs; *p; p += k + (p[k] == ','))
+    {
+        k = NextMotif(p, motif);
+        n = AtlasScan(run->atlas, motif, str, out, 3 * strlen(str) + 1);
+        for (i = 0; i < n; i++)
+            c += fprintf(run->res, "%s\t%d\t%d\t%.*s\t%s\n", run->name ? run->name : "-",
+                         out[i].pos + 1, out[i].frame, out[i].number, &str[out[i].pos],
+                         motif);
+    }
+    free(out);
+    return(c);
+}
 
 /******************************************************************************
 *                                                                             *
-*   ReadDataBase_RE:    Reads the nucleic acid recognition sequence for       *
-*                       the Restriction Enzymes from a file.                  *
-*                                                                             *
+*   ScanSites:  Scans one amino acid sequence and prints its sites in the     *
+*               chosen format, or where the --motif k-mers fit, or only       *
+*               counts them for --summary.                                    *
 *                                                                             *
-*   Input:              fname. File containing the nucleic acid sequences     *
-*                       for the Restriction Enzymes.                          *
-*                                                                             *
-*   Output:             None.                                                 *
-*                                                                             *
-*   Notes:              This function reads the nucleic acid sequences for    *
-*                       for the restriction enzymes and generates the amino   *
-*                       acid motifs from each of the reading frame for each of*
-*                       the restriction enzymes. This information is used     *
-*                       later to determine potential sites for mutation in a  *
-*                       given or derived sequence of amino acids.             *
+*   Input:      str, n. the sequence; for a table or a summary, n may be      *
+*               more than 1 for all the translations from ConvertNAToAA,      *
+*               whose sites are then listed or counted once.                  *
 *                                                                             *
 ******************************************************************************/
 
-ReadDataBase_RE(char *fname)
+static void ScanSites(RUN *run, char **str, int n)
 {
-    int i, j;
-    FILE *fp;
-    char c, re[7];
-    char name[50];
+    int c;
+    long nhits;
 
-    /*  Open the file for reading the nucleic acid sequence of restriction enzymes */
-    if ((fp = fopen(fname, "r")) == (FILE *)NULL)
+    if (run->summary)
     {
-        printf("Error opening DataBase file %s\n", fname);
-        exit(-1);
+        StartPhase(run->stats, PHASE_SCAN);
+        nhits = SummarizeVariants(run->summary, str, n);
+        CountHits(run->stats, run->db, strlen(str[0]), nhits);
+        return;
     }
-
-    /* Initialize the reading frames */
-
-    for (i = 0; i < MAX_NO_RE; i++)
+    if (run->atlas)
     {
-        for (j = 1; j < 20; j++)
-        {
-            f_rf[i].f_aa[j] = '\0';
-            f_rf[i].s_aa[j] = '\0';
-            f_rf[i].t_aa[j] = '\0';
-            s_rf[i].f_aa[j] = '\0';
-            s_rf[i].s_aa[j] = '\0';
-            s_rf[i].t_aa[j] = '\0';
-            t_rf[i].f_aa[j] = '\0';
-            t_rf[i].s_aa[j] = '\0';
-            t_rf[i].t_aa[j] = '\0';
-        }
+        StartPhase(run->stats, PHASE_SCAN);
+        c = PrintMotifs(run, str[0]);
     }
-
-    nre = 0;
-
-    /* read the nucleic acid sequence and name of each restriction enzyme */
-    c = fgetc(fp);
-    while (!feof(fp))
+    else
     {
-        i = 0;
-        while (c != ' ')
+        StartPhase(run->stats, PHASE_SCAN);
+        if (ScanVariants(run->scan, str, n) < 0)
         {
-            re[i++] = c;
-            c = fgetc(fp);
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
-        re[i] = '\0';
-        for (; c == ' ';)
-            c = fgetc(fp);
-
-        i = 0;
-        while ((c != '\n') && (c != -1))
+        CountScan(run->stats, run->scan, strlen(str[0]));
+        StartPhase(run->stats, PHASE_OUTPUT);
+        if (!run->tsv)
+            c = PrintResult(run->scan, str[0], run->res);
+        else if ((c = PrintTable(run->scan, str, n, run->name, run->start, run->min_score,
+                                 run->by_score, run->res)) < 0)
         {
-            name[i++] = c;
-            c = fgetc(fp);
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
-        name[i] = '\0';
-
-        for (; c == '\n';)
-            c = fgetc(fp);
-
-        /* Generate the First reading frame */
-        First_Rf(re, nre);
-
-        /* Generate the Second reading frame */
-        Second_Rf(re, nre);
-
-        /* Generate the Third reading frame */
-        Third_Rf(re, nre);
-
-        /* Store the name and amino acid sequence of the RE */
-        strcpy(res_enzyme[nre].name, name);
-        strcpy(res_enzyme[nre].na, re);
-
-        nre++;
     }
-    fclose(fp);
+    if (run->stats)
+        run->stats->bytes_written += c;
 }
 
-
 /******************************************************************************
 *                                                                             *
-*   First_Rf:   Generates the amino acid motifs from the first reading frame  *
-*               for a Restriction Enzyme                                      *
+*   Report:     Scans the amino acid sequences of one input and prints the    *
+*               potential mutation sites, then frees the sequences.           *
 *                                                                             *
-*   Input:      nucleic acid sequence of a RE.                                *
+*   Input:      aa_str, n. the sequences from ConvertNAToAA.                  *
 *                                                                             *
-*   Output:     None.                                                         *
-*                                                                             *
-*   Notes:      The first reading frame contains two amino acids for a        *
-*               six-base recognition sequence.  A single letter code          *
-*               corresponding to these amino acids are stored in              *
-*               the first reading frame.                                      *
+*   Notes:      A table or a summary takes the sites of all the sequences     *
+*               together, so a site that does not reach the partial last      *
+*               codon is listed or counted once rather than once per          *
+*               sequence, and the input counts as one sequence.               *
 *                                                                             *
 ******************************************************************************/
 
-First_Rf(char *str, int n)
+static void Report(RUN *run, char **aa_str, int n)
 {
     int i;
-    char str1[4], str2[4];
-
-    strncpy(str1, str, 3);
-    str1[3] = '\0';
-    strncpy(str2, &str[3], 3);
-    str2[3] = '\0';
+    STATS *stats = run->stats;
 
-    /* Determine the first amino acid */
-
-    for (i = 0; i < MAX_NO_AA; i++)
+    if (run->summary || (run->tsv && !run->atlas))
     {
-        if ((strcmp(amino_acid[i].nucleic_acid, str1)) == 0)
-        {
-            f_rf[n].f_aa[0] = amino_acid[i].aa;
-            f_rf[n].f_aa[1] = '\0';
-            break;
-        }
+        if (stats)
+            stats->codons += strlen(aa_str[0]);
+        ScanSites(run, aa_str, n);
     }
-
-    /* Determine the second amino acid */
-
-    for (i = 0; i < MAX_NO_AA; i++)
+    else
     {
-        if ((strcmp(amino_acid[i].nucleic_acid, str2)) == 0)
+        for (i = 0; i < n; i++)
         {
-            f_rf[n].s_aa[0] = amino_acid[i].aa;
-            f_rf[n].s_aa[1] = '\0';
-            break;
+            /* Avoids analysis of duplicate amino acid sequences. */
+
+            if (!Duplicate(aa_str, i))
+            {
+                if (stats)
+                    stats->codons += strlen(aa_str[i]);
+                ScanSites(run, &aa_str[i], 1);
+            }
         }
     }
+    for (i = 0; i < n; i++)
+        free(aa_str[i]);
 }
 
 /******************************************************************************
 *                                                                             *
-*   Second_Rf: Generates the amino acid motifs from the second reading frame  *
-*              for a Restriction Enzyme                                       *
-*   Input:     nucleic acid sequence of a RE.                                 *
-*                                                                             *
-*   Output:    None.                                                          *
+*   Density:    Prints the --density track of a nucleic acid sequence from    *
+*               its translations, then frees them.                            *
 *                                                                             *
-*   Notes:     The second reading frame contains three amino acids for a      *
-*              six base recognition sequence. A single letter code            *
-*              corresponding to these amino acids are stored.                 *
+*   Input:      aa_str, n. the sequences from ConvertNAToAA; when there are   *
+*               4 or 16 the last codon is partial and is left out.            *
 *                                                                             *
 ******************************************************************************/
 
-Second_Rf(char *str, int n)
+static void Density(RUN *run, char **aa_str, int n)
 {
-    int i, j;
-    char str1[4];
+    long long len = (n > 0) ? (long long)strlen(aa_str[0]) : 0, nbases = 3 * len;
+    int i, c;
 
-    /* Determine the first amino acid */
-
-    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    if (n > 1)
     {
-        if ((str[0] == amino_acid[i].nucleic_acid[1]) &&
-                (str[1] == amino_acid[i].nucleic_acid[2]))
-        {
-            if (!IsChIn(s_rf[n].f_aa, amino_acid[i].aa))
-                s_rf[n].f_aa[j++] = amino_acid[i].aa;
-        }
+        nbases = 3 * (len - 1) + ((n == 4) ? 2 : 1);
+        aa_str[0][len - 1] = '\0';
     }
-    strncpy(str1, &str[2], 3);
-    str1[3] = '\0';
-
-    /* Determine the second amino acid */
-
-    for (i = 0; i < MAX_NO_AA; i++)
+    if (n > 0)
     {
-        if ((strcmp(str1, amino_acid[i].nucleic_acid)) == 0)
+        StartPhase(run->stats, PHASE_SCAN);
+        if (run->stats)
+            run->stats->codons += nbases / 3;
+        if ((c = PrintDensity(run->db, aa_str[0], nbases, run->name ? run->name : "sequence",
+                              run->window, run->step, run->wig, run->res)) < 0)
         {
-            s_rf[n].s_aa[0] = amino_acid[i].aa;
-            break;
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
-        s_rf[n].s_aa[1] = '\0';
+        if (run->stats)
+            run->stats->bytes_written += c;
     }
+    for (i = 0; i < n; i++)
+        free(aa_str[i]);
+}
 
-    /* Determine the third amino acid */
+/******************************************************************************
+*                                                                             *
+*   Orfs:       Scans the open reading frames of a nucleic acid sequence of   *
+*               at least run->min_orf codons, on both strands, and prints     *
+*               their sites in the coordinates of the sequence.               *
+*                                                                             *
+******************************************************************************/
 
-    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+static void Orfs(RUN *run, const char *na)
+{
+    ORF *orf;
+    char *aa;
+    long n, k;
+    int len, c;
+
+    StartPhase(run->stats, PHASE_TRANSLATE);
+    if (((n = FindOrfs(run->db, na, run->min_orf, &orf)) < 0) ||
+            ((aa = malloc(strlen(na) / 3 + 1)) == NULL))
     {
-        if (str[5] == amino_acid[i].nucleic_acid[0])
-        {
-            if (!IsChIn(s_rf[n].t_aa, amino_acid[i].aa))
-                s_rf[n].t_aa[j++] = amino_acid[i].aa;
-        }
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    for (k = 0; k < n; k++)
+    {
+        StartPhase(run->stats, PHASE_TRANSLATE);
+        len = OrfProtein(run->db, na, &orf[k], aa);
+        if (run->stats)
+            run->stats->codons += len;
+        StartPhase(run->stats, PHASE_SCAN);
+        ScanForRE(run->scan, aa);
+        CountScan(run->stats, run->scan, len);
+        StartPhase(run->stats, PHASE_OUTPUT);
+        c = PrintOrfSites(run->db, run->scan, aa, &orf[k], run->name ? run->name : "-",
+                          run->res);
+        if (run->stats)
+            run->stats->bytes_written += c;
     }
+    free(aa);
+    free(orf);
 }
 
 /******************************************************************************
 *                                                                             *
-*   Third_Rf: Generates the amino acid motifs from the third reading frame    *
-*             for a Restriction Enzyme                                        *
-*   Input:    nucleic acid sequence of a RE.                                  *
+*   Analyze:    Checks one input sequence, translates it if it is a nucleic   *
+*               acid sequence and prints the potential mutation sites.        *
 *                                                                             *
-*   Output:   None.                                                           *
+*   Input:      run. database, scan context, statistics and output.           *
+*               input_str. sequence; it is normalized in place.               *
+*               option. 1 for amino acids, 2 for nucleic acids.               *
+*               name. name of the FASTA record, NULL for a typed sequence.    *
 *                                                                             *
-*   Notes:    The third reading frame contains three amino acids for a        *
-*             six base recognition sequence. A single letter code             *
-*             corresponding to these amino acids are stored.                  *
+*   Output:     1 if the sequence was valid, 0 otherwise.                     *
 *                                                                             *
 ******************************************************************************/
 
-
-Third_Rf(char *str, int n)
+static int Analyze(RUN *run, char *input_str, int option, const char *name)
 {
-    int i, j;
-    char str1[4];
+    char *aa_str[16];
+    int n, len;
+    size_t bad;
+    STATS *stats = run->stats;
 
-    /* Determine the second amino acid */
+    StartPhase(stats, PHASE_CHECK);
 
-    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    if (ValidateInput(run->db, input_str, option, &bad))
     {
-        if ((str[4] == amino_acid[i].nucleic_acid[0]) &&
-                (str[5] == amino_acid[i].nucleic_acid[1]))
+        len = strlen(input_str);
+
+        if ((option == 2) && run->min_orf)
+            Orfs(run, input_str);
+        else if (option == 2)
         {
-            if (!IsChIn(t_rf[n].t_aa, amino_acid[i].aa))
-                t_rf[n].t_aa[j++] = amino_acid[i].aa;
+            StartPhase(stats, PHASE_TRANSLATE);
+            n = ConvertNAToAA(run->db, input_str, aa_str, (len % 3));
+            if (run->window)
+                Density(run, aa_str, n);
+            else
+                Report(run, aa_str, n);
         }
+        else if (run->window || run->min_orf)
+            fprintf(stderr, "%s needs nucleic acid sequences\n",
+                    run->window ? "--density" : "--orfs");
+        else
+            ScanSites(run, &input_str, 1);
+        return(1);
     }
-
-    strncpy(str1, &str[1], 3);
-    str1[3] = '\0';
-
-    /* Determine the first  amino acid */
-
-    for (i = 0; i < MAX_NO_AA; i++)
+    if (name)
     {
-        if ((strcmp(str1, amino_acid[i].nucleic_acid)) == 0)
-        {
-            t_rf[n].s_aa[0] = amino_acid[i].aa;
-            break;
-        }
-        t_rf[n].s_aa[1] = '\0';
+        fprintf(stderr, "Input sequence %s contains invalid entries at byte %lu of its"
+                " sequence lines\n", name, (unsigned long)bad + 1);
     }
-
-    /* Determine the third  amino acid */
-
-    for (i = 0, j = 0; i < MAX_NO_AA; i++)
+    else
     {
-        if (str[0] == amino_acid[i].nucleic_acid[2])
-        {
-            if (!IsChIn(t_rf[n].f_aa, amino_acid[i].aa))
-                t_rf[n].f_aa[j++] = amino_acid[i].aa;
-        }
+        fprintf(stderr, "Input sequence contains invalid entries: %s\n", input_str);
+        if (input_str[0])
+            fprintf(stderr, "The first one is at character %lu\n", (unsigned long)bad + 1);
+        fprintf(stderr, "Please check the sequence and try again \n");
     }
+    return(0);
 }
 
 /******************************************************************************
 *                                                                             *
-*   ReadDataBase_AA:    Reads the nucleic acid codons for all the amino       *
-*                       acids from a file.                                    *
+*   AnalyzeRecord:  Analyze for a FASTA record.  A nucleic acid sequence is   *
+*                   checked and translated straight from the input, without   *
+*                   joining its lines first.                                  *
 *                                                                             *
-*   Input:              fname. File containing the nucleic acid codons for    *
-*                       all amino acids.                                      *
+*   Input:          type. 1 for amino acids, 2 for nucleic acids, 0 to take   *
+*                   the record as nucleic acid if it holds only bases.        *
 *                                                                             *
-*   Output:             None.                                                 *
-*                                                                             *
-*   Notes:              This function reads the nucleic acid codons and the   *
-*                       corresponding one letter code  all the amino acids.   *
+*   Output:         1 if the sequence was valid, 0 otherwise.                 *
 *                                                                             *
 ******************************************************************************/
 
-ReadDataBase_AA(char *fname)
+static int AnalyzeRecord(RUN *run, RECORD *rec, int type)
 {
-    int i, j;
-    FILE *fp;
-    char c;
+    char *aa_str[16], *seq;
+    size_t bad;
+    int n;
 
-    /*  Open the file for reading the nucleic acid codons and the corresponding
-    one letter code  for all amino acids */
-
-    if ((fp = fopen(fname, "r")) == (FILE *)NULL)
+    if ((type != 1) && run->min_orf)
     {
-        printf("Error opening DataBase file %s\n", fname);
-        exit(-1);
+        if ((seq = RecordSequence(rec)) == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
+        }
+        return(Analyze(run, seq, 2, rec->name));
     }
-
-    naa = 0;
-    j = 0;
-    valid_aa[0] = '\0';
-
-    c = fgetc(fp);
-    while (!feof(fp))
+    if (type != 1)
     {
-
-        i = 0;
-        while (c != ' ')
+        StartPhase(run->stats, PHASE_TRANSLATE);
+        n = ConvertRawNAToAA(run->db, rec->raw, rec->raw_len, aa_str, &bad);
+        if (n >= 0)
         {
-            amino_acid[naa].nucleic_acid[i++] = c;
-            c = fgetc(fp);
+            if (run->window)
+                Density(run, aa_str, n);
+            else
+                Report(run, aa_str, n);
+            return(1);
         }
-        for (; c == ' ';)
-            c = fgetc(fp);
-
-        amino_acid[naa].aa = c;
-        if (!IsChIn(valid_aa, c))
-            valid_aa[j++] = c;
+        if (type == 2)
+        {
+            fprintf(stderr, "Input sequence %s contains invalid entries at byte %lu of its"
+                    " sequence lines\n", rec->name, (unsigned long)bad + 1);
+            return(0);
+        }
+    }
 
-        naa++;
-        c = fgetc(fp);
-        for (; c == '\n';)
-            c = fgetc(fp);
+    if ((seq = RecordSequence(rec)) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
     }
-    valid_aa[j] = '\0';
-    fclose(fp);
+    return(Analyze(run, seq, 1, rec->name));
 }
 
-/*******************************************************************************
-*                                                                              *
-*   DisplayReTable:   Writes the amino acid motifs from each of the reading    *
-*                     frame corresponding to all the Restriction Enzymes       *
-*                     onto a file.                                             *
-*                                                                              *
-*   Input:            fp. file pointer for writing.                            *
-*                                                                              *
-*   Output:           None.                                                    *
-*                                                                              *
-*   Notes:            This function generates the table containing the amino   *
-*                     acid motifs for each of the reading frames corresponding *
-*                     to all the restriction enzymes.                          *
-*                                                                              *
-*******************************************************************************/
-
-DisplayReTable(FILE *fp)
+/* One thread of --summary, with its own counts; the reader is shared */
+typedef struct
 {
-    int i, j;
-
+    RUN run;
+    SEQFILE *in;
+    pthread_mutex_t *lock;
+    pthread_t thread;
+    int type;
+} SUMMARY_WORKER;
+
+static void *SummaryWorker(void *arg)
+{
+    SUMMARY_WORKER *w = (SUMMARY_WORKER *)arg;
+    RECORD rec;
 
-    for (i = 0; i < nre; i++)
+    memset(&rec, 0, sizeof(rec));
+    while (1)
     {
-        fprintf(fp, "%s", res_enzyme[i].name);
-        for (j = strlen(res_enzyme[i].name); j < 45; j++)
-            fprintf(fp, " ");
-        fprintf(fp, "%s", res_enzyme[i].na);
-        fprintf(fp, "  ");
-        fprintf(fp, "%c ", f_rf[i].f_aa[0]);
-        fprintf(fp, "%c  ", f_rf[i].s_aa[0]);
-
-        fprintf(fp, "%s", s_rf[i].f_aa);
-        for (j = strlen(s_rf[i].f_aa); j < 5; j++)
-            fprintf(fp, " ");
-        fprintf(fp, " %c ", s_rf[i].s_aa[0]);
-        fprintf(fp, "%s", s_rf[i].t_aa);
-        for (j = strlen(s_rf[i].t_aa); j < 8; j++)
-            fprintf(fp, " ");
-
-
-        fprintf(fp, "%s", t_rf[i].f_aa);
-        for (j = strlen(t_rf[i].f_aa); j < 15; j++)
-            fprintf(fp, " ");
-        fprintf(fp, " %c ", t_rf[i].s_aa[0]);
-        fprintf(fp, "%s", t_rf[i].t_aa);
-
-        fprintf(fp, "\n");
+        StartPhase(w->run.stats, PHASE_INPUT);
+        pthread_mutex_lock(w->lock);
+        if (ReadRecord(w->in, &rec) <= 0)
+        {
+            pthread_mutex_unlock(w->lock);
+            break;
+        }
+        pthread_mutex_unlock(w->lock);
+        if (w->run.stats)
+            w->run.stats->records++;
+        w->run.name = rec.name;
+        AnalyzeRecord(&w->run, &rec, w->type);
     }
-
+    StopPhase(w->run.stats);
+    FreeRecord(&rec);
+    return(NULL);
 }
 
-int IsChIn(char *str, char c)
+/******************************************************************************
+*                                                                             *
+*   SummarizeRecords:   Counts the sites of every record of a FASTA file on   *
+*                       a number of threads, then adds the counts of all of   *
+*                       them to run->summary and run->stats.                  *
+*                                                                             *
+*   Input:              type. as for AnalyzeRecord.                           *
+*                                                                             *
+******************************************************************************/
+
+static void SummarizeRecords(RUN *run, SEQFILE *in, int type, int nthreads)
 {
-    int i;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    SUMMARY_WORKER *w;
+    int i, n;
+
+    StopPhase(run->stats);
+    if (nthreads < 1)
+        nthreads = 1;
+    if ((w = calloc(nthreads, sizeof(SUMMARY_WORKER))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    for (i = 0; i < nthreads; i++)
+    {
+        w[i].run = *run;
+        w[i].in = in;
+        w[i].lock = &lock;
+        w[i].type = type;
+        w[i].run.summary = NewSummary(run->db);
+        w[i].run.stats = run->stats ? NewStats() : NULL;
+        if ((w[i].run.summary == NULL) || (run->stats && (w[i].run.stats == NULL)))
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
+        }
+    }
 
-    for (i = 0; str[i]; i++)
-        if (str[i] == c)
-            return(1);
+    /* the calling thread is the first worker */
+    for (n = 1; n < nthreads; n++)
+    {
+        if (pthread_create(&w[n].thread, NULL, SummaryWorker, &w[n]) != 0)
+            break;
+    }
+    SummaryWorker(&w[0]);
+    for (i = 1; i < n; i++)
+        pthread_join(w[i].thread, NULL);
 
-    return(0);
+    for (i = 0; i < nthreads; i++)
+    {
+        MergeSummary(run->summary, w[i].run.summary);
+        MergeStats(run->stats, w[i].run.stats);
+        FreeSummary(w[i].run.summary);
+        FreeStats(w[i].run.stats);
+    }
+    if (run->stats)
+        run->stats->bytes_read = SeqOffset(in) - run->first;
+    free(w);
 }
 
 /******************************************************************************
 *                                                                             *
-*   ConverNAToAA:   converts a nucleic acid sequence into its corresponding   *
-*                   amino acid sequence.                                      *
+*   AlignRecords:   Adds the sites of every record of an aligned FASTA file   *
+*                   to run->conserved.                                        *
 *                                                                             *
-*   Input: in_str:  nucleic acid sequence.                                    *
-*                   aa:  pointer to string for storing the amino acid         *
-*                   sequence.                                                 *
-*                   option:  method for conversion.                           *
-*                                                                             *
-*   Output:         returns the number of amino acid sequences generated.     *
-*                                                                             *
-*   Notes:          This function converts a nucleic acid sequence into       *
-*                   its corresponding amino acid sequence. If the input       *
-*                   sequence is not a multiple of 3, the option parameter     *
-*                   determines the recovery action. One recovery action       *
-*                   is to determine all possible amino acid sequence for      *
-*                   the given input. If the input sequence is one short,      *
-*                   4 nucleic acid sequences are generated. If it is 2 short, *
-*                   then 16 nucleic acid sequence are generated.              *
+*   Output:         0, or -1 with a message if a record is not as long as     *
+*                   the first.                                                *
 *                                                                             *
 ******************************************************************************/
 
-int ConvertNAToAA(char *in_str, char **aa, int option)
+static int AlignRecords(RUN *run, SEQFILE *in, int type)
 {
-    int i, j, k, n, m, len, count;
-    char temp[4], *str;
-
-    len = strlen(in_str);
-    str = (char *)calloc(len + 4, sizeof(char));
-    strcpy(str, in_str);
-
-    switch (option)
+    RECORD rec;
+    char *seq;
+    size_t bad;
+    int status = 0, r;
+
+    memset(&rec, 0, sizeof(rec));
+    StartPhase(run->stats, PHASE_INPUT);
+    while ((status == 0) && (ReadRecord(in, &rec) > 0))
     {
-    case 0:
-
-        aa[0] = (char *)calloc(len + 1, sizeof(char));
-
-        for (i = 0, k = 0; i < len; i += 3)
+        if (run->stats)
         {
-            temp[0] = str[i];
-            temp[1] = str[i + 1];
-            temp[2] = str[i + 2];
-            temp[3] = '\0';
-
-            for (j = 0; j < naa; j++)
-            {
-                if (!strcmp(amino_acid[j].nucleic_acid, temp))
-                {
-                    aa[0][k++] = amino_acid[j].aa;
-                    break;
-                }
-            }
+            run->stats->records++;
+            run->stats->bytes_read = SeqOffset(in) - run->first;
         }
-        aa[0][k] = '\0';
-        count = 1;
-        break;
-
-    case 2:
-
-        str[len + 1] = '\0';
-        for (n = 0; n < 4; n++)
+        StartPhase(run->stats, PHASE_SCAN);
+        if (((seq = RecordSequence(&rec)) == NULL) ||
+                ((r = AddAligned(run->conserved, seq, type, &bad)) == -2))
         {
-            str[len] = base[n];
-            aa[n] = (char *)calloc(len + 4, sizeof(char));
-
-            for (i = 0, k = 0; i < len + 1; i += 3)
-            {
-                temp[0] = str[i];
-                temp[1] = str[i + 1];
-                temp[2] = str[i + 2];
-                temp[3] = '\0';
-
-                for (j = 0; j < naa; j++)
-                {
-                    if (!strcmp(amino_acid[j].nucleic_acid, temp))
-                    {
-                        aa[n][k++] = amino_acid[j].aa;
-                        break;
-                    }
-                }
-            }
-            aa[n][k] = '\0';
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
-        count = 4;
-        break;
-
-
-    case 1:
-
-        str[len + 2] = '\0';
-        for (n = 0; n < 4; n++)
+        if (r == 0)
+            fprintf(stderr, "Input sequence %s contains invalid entries at column %lu\n",
+                    rec.name, (unsigned long)bad + 1);
+        else if (r < 0)
         {
-            str[len] = base[n];
-            for (m = 0; m < 4; m++)
-            {
-                str[len + 1] = base[m];
-                aa[n * 4 + m] = (char *)calloc(len + 4, sizeof(char));
-
-                for (i = 0, k = 0; i < len + 2; i += 3)
-                {
-                    temp[0] = str[i];
-                    temp[1] = str[i + 1];
-                    temp[2] = str[i + 2];
-                    temp[3] = '\0';
-
-                    for (j = 0; j < naa; j++)
-                    {
-                        if (!strcmp(amino_acid[j].nucleic_acid, temp))
-                        {
-                            aa[n * 4 + m][k++] = amino_acid[j].aa;
-                            break;
-                        }
-                    }
-                }
-                aa[n * 4 + m][k] = '\0';
-            }
+            fprintf(stderr, "Input sequence %s is not as long as the alignment\n", rec.name);
+            status = -1;
         }
-        count = 16;
-        break;
-
-    default:
-        count = 0;
-
+        StartPhase(run->stats, PHASE_INPUT);
     }
-    return(count);
-
+    FreeRecord(&rec);
+    return(status);
 }
 
-/*******************************************************************************
-*                                                                              *
-*   ScanForRE:  For a given string of amino acids, it recognizes the potential *
-*               sites for mutation and the restriction enzymes that can be     *
-*               introduced at this particular site.                            *
-*                                                                              *
-*   Input:      string of amino acids.                                         *
-*                                                                              *
-*   Output:     None.                                                          *
-*                                                                              *
-*   Notes:      This function scans the amino acid sequence and checks for the *
-*               existence of amino acid motifs obtained from each of the       *
-*               reading frames (first, second and third) of all the            *
-*               Restriction enzymes in the input amino acid sequence.          *
-*               The name of the restriction enzyme and the location of the     *
-*               site in input sequence are stored in anarray.                  *
-*                                                                              *
-*******************************************************************************/
-ScanForRE(char *str)
-{
-
-    int i, j, k, len;
-
-    len = strlen(str);
+/******************************************************************************
+*                                                                             *
+*   DiffRecords:    Prints the sites gained and lost from each record of in   *
+*                   to the record in the same place of the mutant file.       *
+*                                                                             *
+*   Output:         0, or -1 with a message if a record has no mutant or is   *
+*                   not a nucleic acid sequence.                              *
+*                                                                             *
+******************************************************************************/
 
-    for (i = 0, k = 0; i < len - 2; i++)
+static int DiffRecords(RUN *run, SEQFILE *in, SEQFILE *mutant)
+{
+    RECORD wt, mut;
+    DIFF *diff;
+    char *a, *b;
+    size_t bad;
+    long n;
+    int status = 0, i;
+
+    memset(&wt, 0, sizeof(wt));
+    memset(&mut, 0, sizeof(mut));
+    StartPhase(run->stats, PHASE_INPUT);
+    while ((status == 0) && (ReadRecord(in, &wt) > 0))
     {
-        /* Check for first  reading frame */
-        for (j = 0; j < nre; j++)
+        if (ReadRecord(mutant, &mut) <= 0)
         {
-            if ((IsChIn(f_rf[j].f_aa, str[i])) && (IsChIn(f_rf[j].s_aa, str[i + 1])))
-            {
-                out[k].pos = i;
-                out[k].number = 2;
-                strcpy(out[k].name, res_enzyme[j].name);
-                strcpy(out[k].na, res_enzyme[j].na);
-                k++;
-            }
+            fprintf(stderr, "Input sequence %s has no mutant\n", wt.name);
+            status = -1;
+            break;
         }
-
-        /* Check for second reading frame */
-        for (j = 0; j < nre; j++)
+        if (run->stats)
         {
-            if ((IsChIn(s_rf[j].f_aa, str[i])) && (IsChIn(s_rf[j].s_aa, str[i + 1]))
-                    && (IsChIn(s_rf[j].t_aa, str[i + 2])))
-            {
-                out[k].pos = i;
-                out[k].number = 3;
-                strcpy(out[k].name, res_enzyme[j].name);
-                strcpy(out[k].na, res_enzyme[j].na);
-                k++;
-            }
+            run->stats->records++;
+            run->stats->bytes_read = SeqOffset(in) - run->first;
         }
-        /* Check for third  reading frame */
-
-        for (j = 0; j < nre; j++)
+        StartPhase(run->stats, PHASE_CHECK);
+        if (((a = RecordSequence(&wt)) == NULL) || ((b = RecordSequence(&mut)) == NULL))
         {
-            if ((IsChIn(t_rf[j].f_aa, str[i])) && (IsChIn(t_rf[j].s_aa, str[i + 1]))
-                    && (IsChIn(t_rf[j].t_aa, str[i + 2])))
-            {
-                out[k].pos = i;
-                out[k].number = 3;
-                strcpy(out[k].name, res_enzyme[j].name);
-                strcpy(out[k].na, res_enzyme[j].na);
-                k++;
-            }
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
-
-    }
-    for (j = 0; j < nre; j++)
-    {
-        if ((IsChIn(f_rf[j].f_aa, str[i])) && (IsChIn(f_rf[j].s_aa, str[i + 1])))
+        if (!ValidateInput(run->db, a, 2, &bad) || !ValidateInput(run->db, b, 2, &bad))
+        {
+            fprintf(stderr, "Input sequence %s or its mutant %s is not a nucleic acid"
+                    " sequence\n", wt.name, mut.name);
+            status = -1;
+            break;
+        }
+        StartPhase(run->stats, PHASE_SCAN);
+        if ((n = DiffSites(run->db, run->sites, a, b, &diff)) < 0)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
+        }
+        StartPhase(run->stats, PHASE_OUTPUT);
+        i = strcspn(wt.name, " \t");
+        wt.name[i] = '\0';
+        i = PrintDiff(run->db, diff, n, wt.name, run->res);
+        if (run->stats)
         {
-            out[k].pos = i;
-            out[k].number = 2;
-            strcpy(out[k].name, res_enzyme[j].name);
-            strcpy(out[k].na, res_enzyme[j].na);
-            k++;
+            run->stats->hits += n;
+            run->stats->bytes_written += i;
         }
+        free(diff);
+        StartPhase(run->stats, PHASE_INPUT);
     }
-    nout = k;
+    FreeRecord(&wt);
+    FreeRecord(&mut);
+    return(status);
 }
 
-/*******************************************************************************
-*                                                                              *
-*   GetNum:     Get a number form a given file.                                *
-*                                                                              *
-*   Input:      File Pointer                                                   *
-*                                                                              *
-*   Output:     -1 if EOF is reached                                           *
-*               0  if invalid input                                            *
-*               n  the number that is input                                    *
-*   Notes:      All trailing blanks are ignored.                               *
-*               ignored.
-*                                                                              *
-*******************************************************************************/
-
-int GetNum(FILE *fp)
-{
-    int i, j, c, opt;
-    char str[20];
+/******************************************************************************
+*                                                                             *
+*   SaturateRecords: Prints the sites created and destroyed by every base     *
+*                   substitution of each record of in.                        *
+*                                                                             *
+******************************************************************************/
 
-    c = fgetc(fp);
-    i = 0;
-    while ((c != '\n') && (c != EOF))
+static void SaturateRecords(RUN *run, SEQFILE *in)
+{
+    RECORD rec;
+    char *seq;
+    size_t bad;
+    long rows;
+
+    memset(&rec, 0, sizeof(rec));
+    StartPhase(run->stats, PHASE_INPUT);
+    while (ReadRecord(in, &rec) > 0)
     {
-        str[i++] = c;
-        c = fgetc(fp);
+        if (run->stats)
+        {
+            run->stats->records++;
+            run->stats->bytes_read = SeqOffset(in) - run->first;
+        }
+        StartPhase(run->stats, PHASE_CHECK);
+        if ((seq = RecordSequence(&rec)) == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
+        }
+        if (!ValidateInput(run->db, seq, 2, &bad))
+            fprintf(stderr, "Input sequence %s contains invalid entries at byte %lu of its"
+                    " sequence lines\n", rec.name, (unsigned long)bad + 1);
+        else
+        {
+            StartPhase(run->stats, PHASE_SCAN);
+            if ((rows = PrintSaturation(run->db, run->sites, seq, rec.name, run->res)) < 0)
+            {
+                fprintf(stderr, "Out of memory\n");
+                exit(-1);
+            }
+            if (run->stats)
+                run->stats->hits += rows;
+        }
+        StartPhase(run->stats, PHASE_INPUT);
     }
-    str[i] = '\0';
-
-    if (c == EOF)
-        return(EOF);
+    FreeRecord(&rec);
+}
 
-    if (i == 0)
-        return(0);
+/******************************************************************************
+*                                                                             *
+*   DomesticateRecords: Writes each record of in as FASTA with its sites      *
+*                   removed by synonymous codon changes, and tells of the     *
+*                   sites that could not be.                                  *
+*                                                                             *
+******************************************************************************/
 
-    j = 0;
-    opt = 0;
-    while (j < i)
+static void DomesticateRecords(RUN *run, SEQFILE *in)
+{
+    RECORD rec;
+    DOMESTIC *site;
+    char *seq;
+    size_t bad;
+    long n, k, len;
+
+    memset(&rec, 0, sizeof(rec));
+    StartPhase(run->stats, PHASE_INPUT);
+    while (ReadRecord(in, &rec) > 0)
     {
-        if (isdigit(str[j]))
+        if (run->stats)
         {
-            opt = opt * 10 + (str[j] - '0');
-            j++;
+            run->stats->records++;
+            run->stats->bytes_read = SeqOffset(in) - run->first;
         }
-        else if (str[j] == ' ')
+        StartPhase(run->stats, PHASE_CHECK);
+        if ((seq = RecordSequence(&rec)) == NULL)
         {
-            while (str[j] == ' ')
-                j++;
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
-        else
-            return(0);
+        if (!ValidateInput(run->db, seq, 2, &bad))
+        {
+            fprintf(stderr, "Input sequence %s contains invalid entries at byte %lu of its"
+                    " sequence lines\n", rec.name, (unsigned long)bad + 1);
+            StartPhase(run->stats, PHASE_INPUT);
+            continue;
+        }
+        StartPhase(run->stats, PHASE_SCAN);
+        if ((n = Domesticate(run->db, run->sites, seq, &site)) < 0)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
+        }
+        for (k = 0; k < n; k++)
+        {
+            if (site[k].edits < 0)
+                fprintf(stderr, "Input sequence %s: the %s site at %ld cannot be removed"
+                        " silently\n", rec.name, EnzymeName(run->db, site[k].re),
+                        site[k].pos + 1);
+        }
+        if (run->stats)
+            run->stats->hits += n;
+        free(site);
+
+        StartPhase(run->stats, PHASE_OUTPUT);
+        fprintf(run->res, ">%s\n", rec.name);
+        for (k = 0, len = strlen(seq); k < len; k += 60)
+            fprintf(run->res, "%.60s\n", &seq[k]);
+        StartPhase(run->stats, PHASE_INPUT);
     }
+    FreeRecord(&rec);
+}
 
-    return(opt);
+/******************************************************************************
+*                                                                             *
+*   LookupResult:   Prints the cached result of a sequence, if there is one,  *
+*                   or else makes run->res collect the result of analyzing    *
+*                   it, for StoreResult.                                      *
+*                                                                             *
+*   Input:          str, n. the sequence as read.                             *
+*                   seed. the options it is analyzed with; the output format  *
+*                   and, for a table, the record name are added.              *
+*                   key. set to the key of the result.                        *
+*                                                                             *
+*   Output:         1 if the result was printed from the cache, 0 otherwise.  *
+*                                                                             *
+******************************************************************************/
+
+static int LookupResult(RUN *run, const char *str, size_t n, uint64_t seed,
+                        uint64_t key[2])
+{
+    const char *out, *p;
+    size_t nout;
+    uint64_t min_score;
+    FILE *fp;
+
+    if ((run->cache == NULL) || (run->atlas != NULL) || run->window || run->min_orf)
+        return(0);
+
+    StartPhase(run->stats, PHASE_CHECK);
+    if (run->tsv)
+    {
+        /* the rows of a table carry the name and depend on the ranking; the
+           bits of min_score are hashed, so no two scores share a key */
+        memcpy(&min_score, &run->min_score, sizeof(min_score));
+        seed = (seed << 2) | 2 | run->by_score;
+        seed = seed * 0x100000001b3ULL + min_score;
+        for (p = run->name ? run->name : "-"; *p; p++)
+            seed = (seed ^ (unsigned char)*p) * 0x100000001b3ULL;
+    }
+    SequenceHash(run->db, str, n, seed, key);
+    if ((out = CacheLookup(run->cache, key, &nout)) != NULL)
+    {
+        StartPhase(run->stats, PHASE_OUTPUT);
+        fwrite(out, 1, nout, run->res);
+        if (run->stats)
+        {
+            run->stats->bytes_written += nout;
+            run->stats->cache_hits++;
+        }
+        return(1);
+    }
+    if ((fp = open_memstream(&run->buf, &run->nbuf)) != NULL)
+    {
+        run->out = run->res;
+        run->res = fp;
+    }
+    return(0);
+}
 
+/* prints the result collected since LookupResult, and caches it if valid */
+static void StoreResult(RUN *run, const uint64_t key[2], int valid)
+{
+    if ((run->cache == NULL) || (run->out == NULL))
+        return;
+
+    fclose(run->res);
+    run->res = run->out;
+    run->out = NULL;
+    fwrite(run->buf, 1, run->nbuf, run->res);
+    if (valid && (CacheStore(run->cache, key, run->buf, run->nbuf) < 0))
+        fprintf(stderr, "Cannot write to the result cache\n");
+    free(run->buf);
+    run->buf = NULL;
 }
 
-int Check_Input(char *str, int opt)
+/******************************************************************************
+*                                                                             *
+*   AnalyzeRegion:  Reads one region of an indexed FASTA file, indexing it    *
+*                   first if need be, and prints the sites of the region      *
+*                   read in its first reading frame, at their positions in    *
+*                   the genome, under a header written once it is read.       *
+*                                                                             *
+*   Input:          fname. the FASTA file; the index is fname.fai.            *
+*                   region. name:start-end, as for FetchRegion.               *
+*                                                                             *
+*   Output:         1 if the region was valid, 0 otherwise.                   *
+*                                                                             *
+******************************************************************************/
+
+static int AnalyzeRegion(RUN *run, const char *fname, const char *region)
 {
-    int i, j, len;
-    char c;
+    char *fai, *seq, *name;
+    FILE *fp;
+    int valid;
 
-    len = strlen(str);
-    if (len == 0)
+    StartPhase(run->stats, PHASE_INPUT);
+    if ((fai = malloc(strlen(fname) + 5)) == NULL)
         return(0);
+    sprintf(fai, "%s.fai", fname);
+    if ((fp = fopen(fai, "r")) != NULL)
+        fclose(fp);
+    else if (IndexFasta(fname) < 0)
+    {
+        fprintf(stderr, "Cannot index %s\n", fname);
+        free(fai);
+        return(0);
+    }
+    free(fai);
 
-    if (str[len - 1] == '\n')
-        str[len - 1] = '\0';
+    if ((seq = FetchRegion(fname, region, &run->start)) == NULL)
+    {
+        fprintf(stderr, "Cannot read region %s of %s\n", region, fname);
+        return(0);
+    }
+    fprintf(run->res, TSV_HEADER);
+    if (run->stats)
+    {
+        run->stats->records++;
+        run->stats->bytes_read += strlen(seq);
+    }
+
+    /* the rows are named by the record the region is in */
+    if ((name = malloc(strlen(region) + 1)) == NULL)
+    {
+        free(seq);
+        return(0);
+    }
+    strcpy(name, region);
+    if ((strrchr(name, ':') != NULL) && strchr("0123456789", strrchr(name, ':')[1]))
+        *strrchr(name, ':') = '\0';
+    run->name = name;
+    valid = Analyze(run, seq, 2, region);
+    run->name = NULL;
+    free(name);
+    free(seq);
+    return(valid);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Design:         Prints the best designs of the --design enzymes in one    *
+*                   nucleic acid sequence instead of all its sites.           *
+*                                                                             *
+*   Input:          na. sequence; it is normalized in place.                  *
+*                   name. name of the FASTA record, NULL for a typed          *
+*                   sequence.                                                 *
+*                                                                             *
+******************************************************************************/
 
+static void Design(RUN *run, char *na, const char *name)
+{
+    DESIGN *best;
+    size_t bad;
+    int i, k, n, c = 0;
 
-    len = strlen(str);
-    for (i = 0, j = 0; i < len; i++)
+    StartPhase(run->stats, PHASE_CHECK);
+    if (!ValidateInput(run->db, na, 2, &bad))
     {
-        if (str[i] != ' ')
-            str[j++] = str[i];
+        fprintf(stderr, "Input sequence %s is not a nucleic acid sequence: invalid entry"
+                " at character %lu\n", name ? name : na, (unsigned long)bad + 1);
+        return;
     }
-    str[j] = '\0';
 
-    for (i = 0; str[i]; i++)
+    StartPhase(run->stats, PHASE_SCAN);
+    if (((best = malloc(run->top * sizeof(DESIGN))) == NULL) ||
+            ((n = DesignSites(run->db, na, run->site, run->nsites, run->max_edits, best,
+                              run->top)) < 0))
     {
-        c = toupper(str[i]);
-        str[i] = c;
+        fprintf(stderr, "Out of memory, or a codon is missing from dbase1\n");
+        exit(-1);
     }
 
-    if (opt == 1)
+    StartPhase(run->stats, PHASE_OUTPUT);
+    if (n == 0)
+        c += fprintf(run->res, "No design found\n");
+    for (k = 0; k < n; k++)
     {
-        for (i = 0; str[i]; i++)
-        {
-            if (!IsChIn(valid_aa, str[i]))
-                return(0);
-        }
+        c += fprintf(run->res, "Design %d: %d edits\n", k + 1, best[k].edits);
+        for (i = 0; i < best[k].nsites; i++)
+            c += fprintf(run->res, "    %-45s base %8d  frame %d  %d edits\n",
+                         EnzymeName(run->db, run->site[i].re), best[k].start[i] + 1,
+                         best[k].hit[i].frame, best[k].site_edits[i]);
     }
-    else if (opt == 2)
+    if (run->stats)
+        run->stats->bytes_written += c;
+    free(best);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ProcessRecord:  Prints the designs or the sites of one FASTA record,      *
+*                   from the cache if it is there.                            *
+*                                                                             *
+*   Input:          type. as for AnalyzeRecord.                               *
+*                                                                             *
+******************************************************************************/
+
+static void ProcessRecord(RUN *run, RECORD *rec, int type)
+{
+    uint64_t key[2];
+    char *seq;
+
+    run->name = rec->name;
+    if (!run->tsv && !run->atlas && !run->window && !run->min_orf)
+        fprintf(run->res, ">%s\n", rec->name);
+    if (run->nsites > 0)
     {
-        for (i = 0; str[i]; i++)
+        if ((seq = RecordSequence(rec)) == NULL)
         {
-            if (!IsChIn(base, str[i]))
-                return(0);
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
+        Design(run, seq, rec->name);
     }
-
-    return(1);
+    else if (!LookupResult(run, rec->raw, rec->raw_len, 16 + type, key))
+        StoreResult(run, key, AnalyzeRecord(run, rec, type));
 }
 
 /******************************************************************************
 *                                                                             *
-*   PrintResult:        print the result indicating the mutation site and the *
-*                       name of the restriction enzyme that can be introduced *
-*                       at this site                                          *
+*   Checkpoint:     Notes in the --checkpoint file, at most every             *
+*                   CHECKPOINT_SECS seconds, that the results of the record   *
+*                   at offset are written out, and how long the output is.    *
 *                                                                             *
-*   Input:              string of amino acids and the file for output.        *
+*   Notes:          The file is written under a temporary name and renamed,   *
+*                   so a crash leaves the old checkpoint or the new one.      *
 *                                                                             *
-*   Output:             None.                                                 *
+******************************************************************************/
+
+static void Checkpoint(RUN *run, long long offset)
+{
+    char tmp[FILENAME_MAX];
+    time_t now;
+    FILE *fp;
+
+    if ((run->checkpoint == NULL) || ((now = time(NULL)) < run->checkpoint_due))
+        return;
+    run->checkpoint_due = now + CHECKPOINT_SECS;
+    if (fflush(run->res) != 0)
+        return;
+    sprintf(tmp, "%.*s.tmp", FILENAME_MAX - 5, run->checkpoint);
+    if ((fp = fopen(tmp, "w")) == NULL)
+        return;
+    fprintf(fp, "silmut checkpoint\nrecord %lld\noutput %ld\n", offset, ftell(run->res));
+    if (fclose(fp) == 0)
+        rename(tmp, run->checkpoint);
+}
+
+/******************************************************************************
 *                                                                             *
-*   Notes:              This function prints out the amino acid sequence and  *
-*                       the position in the string and the name of the        *
-*                       restriction enzyme/s that match with the amino acid   *
-*                       motif in the string.                                  *
+*   Resume:         Picks up a run from its --checkpoint file: opens the      *
+*                   output, cut at the end of the last record written, and    *
+*                   moves the input past that record.                         *
 *                                                                             *
+*   Output:         the output, positioned for the next record; NULL with     *
+*                   *resumed 0 if there is no checkpoint, so the run starts   *
+*                   from the beginning; NULL with a message if the            *
+*                   checkpoint does not fit the files.                        *
 *                                                                             *
 ******************************************************************************/
-PrintResult(str, fp)
-char *str;
-FILE *fp;
 
+static FILE *Resume(const char *checkpoint, const char *out_fname, SEQFILE *in,
+                    int *resumed)
 {
-    int i, j, k, l, m, len, pos;
+    long long record;
+    long output;
+    RECORD rec;
+    FILE *fp;
+    int n;
 
-    len = strlen(str);
-    fprintf(fp, "\n\n-----------------------------------------------------------------------\n");
+    *resumed = 0;
+    if ((fp = fopen(checkpoint, "r")) == NULL)
+        return(NULL);
+    n = fscanf(fp, "silmut checkpoint record %lld output %ld", &record, &output);
+    fclose(fp);
+    *resumed = 1;
+    if (n != 2)
+    {
+        fprintf(stderr, "%s is not a checkpoint\n", checkpoint);
+        return(NULL);
+    }
 
-    if (nout <= 0)
+    /* the record is written out already; go on after it */
+    memset(&rec, 0, sizeof(rec));
+    n = (SeqSeek(in, record) == 0) && (ReadRecord(in, &rec) > 0) && (rec.offset == record);
+    FreeRecord(&rec);
+    if (!n)
     {
-        for (i = 0; i < len; i++)
-            fprintf(fp, "%c", str[i]);
-        fprintf(fp, "\n");
+        fprintf(stderr, "The input does not fit the checkpoint %s\n", checkpoint);
+        return(NULL);
+    }
+    if (((fp = fopen(out_fname, "r+")) == NULL) || (fseek(fp, 0, SEEK_END) != 0) ||
+            (ftell(fp) < output) || (fseek(fp, output, SEEK_SET) != 0) ||
+            (ftruncate(fileno(fp), (off_t)output) != 0))
+    {
+        fprintf(stderr, "The output %s does not fit the checkpoint %s\n", out_fname,
+                checkpoint);
+        if (fp)
+            fclose(fp);
+        return(NULL);
+    }
+    return(fp);
+}
+
+/* The pipeline of a FASTA file: a reader thread reads records into slots
+   taken from a pool, worker threads analyze them, each printing into the
+   slot, and the calling thread writes the results out in input order and
+   gives the slots back to the pool.  Record n goes to worker n % nworkers,
+   so every queue has one producer and one consumer, and the writer finds
+   the results in order by taking them from the workers in turn.  The pool
+   bounds the records in flight, so a slow writer holds back the reader. */
+
+#define PIPE_DEPTH  4       /* records in flight per worker          */
+
+typedef struct
+{
+    RECORD rec;
+    FILE *fp;                   /* kept open and rewound for each record */
+    char *out;                  /* what ProcessRecord printed            */
+    size_t nout;
+} PIPE_SLOT;
 
-        fprintf(fp, "No site in the input string can be replaced with Restriction Enzymes\n");
-        return 0;
+typedef struct
+{
+    RUN run;                    /* own scan, statistics and output      */
+    QUEUE *in, *out;
+    int type;
+    pthread_t thread;
+} PIPE_WORKER;
+
+typedef struct
+{
+    SEQFILE *in;
+    STATS *stats;               /* of the reader                        */
+    QUEUE *pool;                /* free slots, from the writer          */
+    PIPE_WORKER *worker;
+    int nworkers;
+    int status;                 /* what ended the input: 0 or -1        */
+} PIPE_READER;
+
+static void *PipeReader(void *arg)
+{
+    PIPE_READER *r = (PIPE_READER *)arg;
+    PIPE_SLOT *slot;
+    long n;
+    int k;
+
+    for (n = 0; ; n++)
+    {
+        slot = (PIPE_SLOT *)QueuePop(r->pool);
+        StartPhase(r->stats, PHASE_INPUT);
+        if ((r->status = ReadRecord(r->in, &slot->rec)) <= 0)
+            break;
+        StopPhase(r->stats);
+        if (r->stats)
+            r->stats->records++;
+        QueuePush(r->worker[n % r->nworkers].in, slot);
     }
+    StopPhase(r->stats);
 
-    pos = 0;
-    i = 0;
+    /* the first NULL the writer meets, in turn, ends the run */
+    for (k = 0; k < r->nworkers; k++)
+        QueuePush(r->worker[(n + k) % r->nworkers].in, NULL);
+    return(NULL);
+}
+
+static void *PipeWorker(void *arg)
+{
+    PIPE_WORKER *w = (PIPE_WORKER *)arg;
+    PIPE_SLOT *slot;
 
-    while (i < nout)
+    while ((slot = (PIPE_SLOT *)QueuePop(w->in)) != NULL)
     {
-        j = i;
-        while (j < nout)
+        if ((slot->fp == NULL) &&
+                ((slot->fp = open_memstream(&slot->out, &slot->nout)) == NULL))
         {
-            len = out[j].pos - pos + strlen(out[j].name);
-            if (len > LINELEN)
-                break;
-            else
-                j++;
+            fprintf(stderr, "Out of memory\n");
+            exit(-1);
         }
+        rewind(slot->fp);
+        w->run.res = slot->fp;
+        ProcessRecord(&w->run, &slot->rec, w->type);
+        fflush(slot->fp);
+        StopPhase(w->run.stats);
+        QueuePush(w->out, slot);
+    }
+    QueuePush(w->out, NULL);
+    return(NULL);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PipeRecords:    Analyzes every record of a FASTA file on a pipeline of    *
+*                   a reader thread, nworkers worker threads and the calling  *
+*                   thread as the writer, and adds the statistics of all of   *
+*                   them to run->stats.  The output is the same as that of    *
+*                   ProcessRecord on each record in turn.                     *
+*                                                                             *
+*   Input:          type. as for AnalyzeRecord.                               *
+*                                                                             *
+*   Returns:        0, or -1 if a record could not be read for want of        *
+*                   memory; the records before it are written all the same.   *
+*                                                                             *
+*   Notes:          Not for the result cache, which is not shared between     *
+*                   threads.                                                  *
+*                                                                             *
+******************************************************************************/
+
+static int PipeRecords(RUN *run, SEQFILE *in, int type, int nworkers)
+{
+    PIPE_READER r;
+    PIPE_SLOT *slot, *done;
+    pthread_t reader;
+    int i, n, nslots;
+
+    StopPhase(run->stats);
+    if (nworkers < 1)
+        nworkers = 1;
+    nslots = nworkers * PIPE_DEPTH;
+    r.in = in;
+    r.nworkers = nworkers;
+    r.status = 0;
+    r.stats = run->stats ? NewStats() : NULL;
+    r.pool = NewQueue(nslots);
+    r.worker = calloc(nworkers, sizeof(PIPE_WORKER));
+    slot = calloc(nslots, sizeof(PIPE_SLOT));
+    if ((r.pool == NULL) || (r.worker == NULL) || (slot == NULL) ||
+            (run->stats && (r.stats == NULL)))
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    for (i = 0; i < nslots; i++)
+        QueuePush(r.pool, &slot[i]);
 
-        l = i;
-        if (i == j)
+    for (i = 0; i < nworkers; i++)
+    {
+        /* a queue never holds more than every slot and the end mark */
+        r.worker[i].run = *run;
+        r.worker[i].type = type;
+        r.worker[i].run.scan = NewScan(run->db);
+        r.worker[i].run.stats = run->stats ? NewStats() : NULL;
+        r.worker[i].in = NewQueue(nslots + 1);
+        r.worker[i].out = NewQueue(nslots + 1);
+        if ((r.worker[i].run.scan == NULL) || (r.worker[i].in == NULL) ||
+                (r.worker[i].out == NULL) || (run->stats && (r.worker[i].run.stats == NULL)) ||
+                (pthread_create(&r.worker[i].thread, NULL, PipeWorker, &r.worker[i]) != 0))
         {
-            len = out[i].pos;
-            for (k = pos; k < len; k++)
-                fprintf(fp, "%c", str[k]);
+            fprintf(stderr, "Cannot start the worker threads\n");
+            exit(-1);
+        }
+    }
+    if (pthread_create(&reader, NULL, PipeReader, &r) != 0)
+    {
+        fprintf(stderr, "Cannot start the reader thread\n");
+        exit(-1);
+    }
+
+    for (n = 0; (done = (PIPE_SLOT *)QueuePop(r.worker[n % nworkers].out)) != NULL; n++)
+    {
+        StartPhase(run->stats, PHASE_OUTPUT);
+        fwrite(done->out, 1, done->nout, run->res);
+        Checkpoint(run, done->rec.offset);
+        StopPhase(run->stats);
+        QueuePush(r.pool, done);
+    }
+    StopPhase(run->stats);
+
+    pthread_join(reader, NULL);
+    MergeStats(run->stats, r.stats);
+    FreeStats(r.stats);
+    for (i = 0; i < nworkers; i++)
+    {
+        pthread_join(r.worker[i].thread, NULL);
+        MergeStats(run->stats, r.worker[i].run.stats);
+        FreeStats(r.worker[i].run.stats);
+        FreeScan(r.worker[i].run.scan);
+        FreeQueue(r.worker[i].in);
+        FreeQueue(r.worker[i].out);
+    }
+    if (run->stats)
+        run->stats->bytes_read = SeqOffset(in) - run->first;
+
+    /* every slot is idle now */
+    for (i = 0; i < nslots; i++)
+    {
+        if (slot[i].fp != NULL)
+            fclose(slot[i].fp);
+        free(slot[i].out);
+        FreeRecord(&slot[i].rec);
+    }
+    free(slot);
+    FreeQueue(r.pool);
+    free(r.worker);
+    if (r.status < 0)
+    {
+        fprintf(stderr, "Out of memory reading the input\n");
+        return(-1);
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ParseDesign:    Reads the --design enzymes and their --spacing.           *
+*                                                                             *
+*   Input:          names. enzyme names separated by commas.                  *
+*                   spacing. min-max, once for every pair of neighbouring     *
+*                   sites or once for each pair, separated by commas; NULL    *
+*                   for any spacing.                                          *
+*                                                                             *
+*   Output:         0 on success, -1 with a message otherwise.                *
+*                                                                             *
+******************************************************************************/
 
-            pos += len;
+static int ParseDesign(RUN *run, const char *names, const char *spacing)
+{
+    char name[50];
+    const char *p = names;
+    int i, n, lo, hi;
+
+    for (run->nsites = 0; *p; run->nsites++)
+    {
+        n = strcspn(p, ",");
+        if ((run->nsites == MAX_DESIGN) || (n >= (int)sizeof(name)))
+        {
+            fprintf(stderr, "Too many enzymes or too long a name in --design\n");
+            return(-1);
         }
-        else
+        memcpy(name, p, n);
+        name[n] = '\0';
+        if ((run->site[run->nsites].re = FindEnzyme(run->db, name)) < 0)
         {
-            if (j == nout)
-                len = strlen(str) + 1;
-            else
-                len = out[j - 1].pos + out[j - 1].number;
+            fprintf(stderr, "Unknown Restriction Enzyme %s\n", name);
+            return(-1);
+        }
+        for (i = 0; i < run->nsites; i++)
+        {
+            if (run->site[i].re == run->site[run->nsites].re)
+            {
+                fprintf(stderr, "Restriction Enzyme %s is given twice\n", name);
+                return(-1);
+            }
+        }
+        run->site[run->nsites].min_space = 0;
+        run->site[run->nsites].max_space = INT_MAX;
+        p += n + (p[n] == ',');
+    }
+    if (run->nsites == 0)
+    {
+        fprintf(stderr, "No Restriction Enzyme in --design\n");
+        return(-1);
+    }
 
-            for (k = pos; k < len; k++)
-                fprintf(fp, "%c", str[k]);
-            fprintf(fp, "\n");
+    for (i = 1, p = spacing; p && *p; i++)
+    {
+        if ((sscanf(p, "%d-%d", &lo, &hi) != 2) || (lo < 0) || (hi < lo) ||
+                (i >= run->nsites))
+        {
+            fprintf(stderr, "Invalid --spacing %s\n", spacing);
+            return(-1);
+        }
+        run->site[i].min_space = lo;
+        run->site[i].max_space = hi;
+        p += strcspn(p, ",");
+        p += (*p == ',');
+    }
+    if (i == 2)
+    {
+        /* one range for every pair */
+        for (i = 2; i < run->nsites; i++)
+        {
+            run->site[i].min_space = lo;
+            run->site[i].max_space = hi;
+        }
+    }
+    else if (spacing && (i != run->nsites))
+    {
+        fprintf(stderr, "--spacing needs one range, or one for each pair of sites\n");
+        return(-1);
+    }
+    return(0);
+}
 
-            k = pos;
-            for (; i < j; i++)
-            {
-                for (; k < out[i].pos; k++)
-                    fprintf(fp, " ");
-                fprintf(fp, "%s", out[i].name);
-                k += strlen(out[i].name);
+/* marks the enzymes a --enzymes name or pattern stands for */
+static int KeepEnzymes(const DATABASE *db, const char *pattern, char *keep)
+{
+    int i, n = 0;
 
-                if ((i + 1 < j) && (k >= out[i + 1].pos))
-                {
-                    k = pos;
-                    fprintf(fp, "\n");
-                }
-            }
+    for (i = 0; i < NumEnzymes(db); i++)
+    {
+        if (MatchEnzyme(db, i, pattern))
+        {
+            keep[i] = 1;
+            n++;
+        }
+    }
+    if (n == 0)
+        fprintf(stderr, "No Restriction Enzyme is named %s\n", pattern);
+    return(n);
+}
+
+/******************************************************************************
+*                                                                             *
+*   ParseEnzymes:   Keeps only the --enzymes Restriction Enzymes in the       *
+*                   database, before anything is scanned.                     *
+*                                                                             *
+*   Input:          arg. a file of names, separated by white space or commas  *
+*                   and with '#' starting a comment, or if there is no such   *
+*                   file the names separated by commas.  A name may be any    *
+*                   one of those an entry of dbase2 lists, and may hold the   *
+*                   wild cards '*' and '?'.                                   *
+*                                                                             *
+*   Output:         0 on success, -1 with a message otherwise.                *
+*                                                                             *
+******************************************************************************/
 
-            fprintf(fp, "\n\n");
-            for (k = l; k < j; k++)
+static int ParseEnzymes(DATABASE *db, const char *arg)
+{
+    char name[50], *keep;
+    const char *p = arg;
+    int c, n, status = 0;
+    FILE *fp;
+
+    if ((keep = calloc(NumEnzymes(db) + 1, 1)) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return(-1);
+    }
+    if ((fp = fopen(arg, "r")) != NULL)
+    {
+        n = 0;
+        do
+        {
+            c = fgetc(fp);
+            if (c == '#')
             {
-                fprintf(fp, "Position in the input string: %d\n", out[k].pos - pos + 1);
-                fprintf(fp, "Amino acid string at this position: ");
-                if (out[k].number == 2)
-                {
-                    fprintf(fp, "%c", str[out[k].pos]);
-                    fprintf(fp, "%c", str[out[k].pos + 1]);
-                }
-                else if (out[k].number == 3)
-                {
-                    fprintf(fp, "%c", str[out[k].pos]);
-                    fprintf(fp, "%c", str[out[k].pos + 1]);
-                    fprintf(fp, "%c", str[out[k].pos + 2]);
-                }
-                fprintf(fp, "\n");
-                fprintf(fp, "Restriction Enzyme site/s that can be introduced at this position: ");
-                fprintf(fp, "%s (%s)", out[k].name, out[k].na);
-                fprintf(fp, "\n\n");
+                while ((c != '\n') && (c != EOF))
+                    c = fgetc(fp);
             }
-
-            if (i < nout)
+            if ((c == EOF) || (c == ',') || isspace(c))
             {
-                if ((out[i - 1].pos + out[i - 1].number) < out[i].pos)
-                    pos += out[i - 1].pos + out[i - 1].number;
-                else
-                    pos += out[i - 1].pos;
+                name[n] = '\0';
+                if (n && (KeepEnzymes(db, name, keep) == 0))
+                    status = -1;
+                n = 0;
             }
-
-            if (j == nout)
-                pos = strlen(str) - 1;
+            else if (n < (int)sizeof(name) - 1)
+                name[n++] = c;
+        } while (c != EOF);
+        fclose(fp);
+    }
+    else
+    {
+        while (*p)
+        {
+            n = strcspn(p, ",");
+            if (n >= (int)sizeof(name))
+                n = sizeof(name) - 1;
+            memcpy(name, p, n);
+            name[n] = '\0';
+            if (n && (KeepEnzymes(db, name, keep) == 0))
+                status = -1;
+            p += strcspn(p, ",");
+            p += (*p == ',');
         }
+    }
 
-        fprintf(fp, "\n");
+    if ((status == 0) && (SelectEnzymes(db, keep) <= 0))
+    {
+        fprintf(stderr, "No Restriction Enzyme in --enzymes\n");
+        status = -1;
     }
+    free(keep);
+    return(status);
+}
+
+static void Usage(const char *prog)
+{
+    fprintf(stderr, "Usage %s [-i <infile> -o <outfile>] [--type aa|na] [--threads n]"
+            " [--stats[=json]] [--cache] [--cache-dir <dir>]\n"
+            "       [--design enzyme,... [--spacing min-max,...] [--max-edits n]"
+            " [--top n]]\n"
+            "       [-f text|tsv] [--usage <codon usage>] [--sort position|score]"
+            " [--min-score s]\n"
+            "       [--atlas <atlasfile> --motif kmer,...] [--summary]"
+            " [--enzymes name,...|<file>]\n"
+            "       [-r name:start-end] [--index] [--shard i/n]"
+            " [--checkpoint <file> [--resume]]\n"
+            "       [--density window[,step] [-f bedgraph|wig]] [--conserved percent]"
+            " [--diff <mutant>] [--saturation] [--domesticate]\n"
+            "       [--orfs min_codons]\n"
+            "       %s merge [-o <outfile>] file...\n", prog, prog);
+    exit(-1);
+}
+
+/* what each output mode prints instead of the sites of each record, by the
+   flag that asks for it, and the -f formats it takes; only one can be given */
+typedef struct
+{
+    const char *flag;
+    const char *formats;        /* comma separated, "" for none          */
+} MODE;
 
-    len = strlen(str);
-    if (pos < len - 1)
+static const MODE modes[] =
+{
+    { NULL, "text,tsv" },
+    { "--summary", "" },
+    { "--density", "bedgraph,wig" },
+    { "--conserved", "" },
+    { "--diff", "" },
+    { "--saturation", "" },
+    { "--domesticate", "" },
+    { "--orfs", "" },
+    { "--design", "" },
+    { "--atlas", "" },
+    { "-r", "tsv" }
+};
+
+/* sets the output mode of a flag; a second mode is an error */
+static void SetMode(int *mode, int m)
+{
+    if ((*mode != MODE_SITES) && (*mode != m))
     {
-        for (; pos < len; pos++)
-            fprintf(fp, "%c", str[pos]);
+        fprintf(stderr, "only one of --summary/--density/--conserved/--diff/--saturation/"
+                "--domesticate/--orfs/--design/--atlas/-r\n");
+        exit(-1);
     }
-    fprintf(fp, "\n");
+    *mode = m;
+}
 
+/* 1 if a mode takes a -f format */
+static int TakesFormat(int mode, const char *format)
+{
+    const char *p = modes[mode].formats;
+    size_t n = strlen(format);
+
+    for (; *p; p += strcspn(p, ","), p += (*p == ','))
+    {
+        if (!strncmp(p, format, n) && ((p[n] == ',') || (p[n] == '\0')))
+            return(1);
+    }
+    return(0);
 }
 
 /******************************************************************************
 *                                                                             *
-*   Duplicate:      checks for a duplicate amino acid sequence.               *
+*   Merge:          silmut merge [-o outfile] file...  joins the outputs of   *
+*                   the shards of one input, given in shard order, into the   *
+*                   output of a single run.                                   *
 *                                                                             *
-*   Input:          string of amino acids and the file for output.            *
-*                                                                             *
-*   Output:   1:    if there is a duplicate                                   *
-*             0:    otherwise                                                 *
-*                                                                             *
-*   Notes:          When the input nucleic acid sequence is not a multiple of *
-*                   3, duplicate amino acid sequences might be generated.     *
-*                   This function eliminates the analysis of duplicate        *
-*                   amino acid sequences.                                     *
+*   Notes:          Summary tables are added up row by row; any other output  *
+*                   is copied in turn, without the header line of -f tsv or   *
+*                   --atlas after the first file.                             *
 *                                                                             *
 ******************************************************************************/
 
-
-int Duplicate(char *str[], int n)
+static int Merge(int argc, char *argv[])
 {
-    int i, res = 0;
+    static const char summary[] = "#section\tbin\t";
+    char line[256], header[256], buf[1 << 16];
+    size_t n;
+    FILE *res = stdout, *fp;
+    int i = 2, c, err = 0;
 
-    for (i = 0; i < n; i++)
+    if ((i + 1 < argc) && !strcmp(argv[i], "-o"))
     {
-        if (!strcmp(str[i], str[n]))
-            res = 1;
+        if ((res = fopen(argv[i + 1], "w")) == NULL)
+        {
+            fprintf(stderr, "Cannot write %s\n", argv[i + 1]);
+            return(-1);
+        }
+        i += 2;
     }
-    return(res);
-}
+    if (i == argc)
+        Usage(argv[0]);
 
-void  main(argc, argv)
-int argc;
-char *argv[];
+    header[0] = '\0';
+    for ( ; (i < argc) && !err; i++)
+    {
+        if ((fp = fopen(argv[i], "rb")) == NULL)
+        {
+            fprintf(stderr, "Cannot read %s\n", argv[i]);
+            err = 1;
+            break;
+        }
+        /* only the first file keeps the header line of a table */
+        if ((c = getc(fp)) == '#')
+        {
+            line[0] = c;
+            if (fgets(line + 1, sizeof(line) - 1, fp) == NULL)
+                line[1] = '\0';
+            if ((header[0] == '\0') && !strncmp(line, summary, strlen(summary)))
+            {
+                fclose(fp);
+                if (MergeSummaryFiles((const char **)argv + i, argc - i, res) < 0)
+                {
+                    fprintf(stderr, "Cannot merge the summary tables\n");
+                    err = 1;
+                }
+                break;
+            }
+            if (strcmp(line, header))
+                fputs(line, res);
+            if (header[0] == '\0')
+                strcpy(header, line);
+        }
+        else if (c != EOF)
+            ungetc(c, fp);
+        while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+            fwrite(buf, 1, n, res);
+        err |= ferror(fp);
+        fclose(fp);
+    }
+    if (res != stdout)
+        err |= (fclose(res) != 0);
+    return(err ? -1 : 0);
+}
 
+int main(int argc, char *argv[])
 {
     char aa_database[FILE_NAME_SIZE];
     char re_database[FILE_NAME_SIZE];
-    char input_str[MAX_INPUT_LEN], *aa_str[64];
-    int option, i, c, len, n;
-    FILE *res, *in;
-
-    res = stdout;
-    in = stdin;
+    char *input_str = NULL;
+    size_t input_cap = 0;
+    const char *bad_fname, *in_fname = NULL, *cache_dir = NULL;
+    const char *design = NULL, *spacing = NULL, *usage = NULL, *atlas = NULL;
+    const char *enzymes = NULL, *region = NULL, *out_fname = NULL, *diff = NULL;
+    const char *format = NULL;
+    int option, i, err, type = 0, nthreads = 1, stats_json = 0, cache = 0, summary = 0;
+    int index = 0, shard = 0, nshards = 0, resume = 0, resumed = 0, saturation = 0;
+    int domesticate = 0, mode = MODE_SITES;
+    double conserved = -1;
+    uint64_t key[2];
+    long long offset;
+    FILE *res;
+    SEQFILE *in, *mutant = NULL;
+    RECORD rec;
+    RUN run;
+
+    res = NULL;
+    run.stats = NULL;
+    run.cache = NULL;
+    run.out = NULL;
+    run.buf = NULL;
+    run.nsites = 0;
+    run.max_edits = -1;
+    run.top = DESIGN_TOP;
+    run.tsv = 0;
+    run.by_score = 0;
+    run.min_score = 0;
+    run.name = NULL;
+    run.atlas = NULL;
+    run.motifs = NULL;
+    run.summary = NULL;
+    run.conserved = NULL;
+    run.sites = NULL;
+    run.start = -1;
+    run.window = 0;
+    run.step = 0;
+    run.wig = 0;
+    run.min_orf = 0;
+    run.checkpoint = NULL;
+    run.checkpoint_due = 0;
+    run.first = 0;
+
+    if ((argc > 1) && !strcmp(argv[1], "merge"))
+        return(Merge(argc, argv));
 
     i = 1;
     while (i < argc)
     {
-        if (!strcmp(argv[i], "-i"))
+        if (!strcmp(argv[i], "-i") && (i + 1 < argc))
+        {
+            i++;
+            in_fname = argv[i];
+        }
+        else if (!strcmp(argv[i], "-o") && (i + 1 < argc))
+            out_fname = argv[++i];
+        else if (!strcmp(argv[i], "--type") && (i + 1 < argc))
         {
             i++;
-            if ((in = fopen(argv[i], "r")) == (FILE *)NULL)
-                in = stdin;
+            if (!strcmp(argv[i], "aa"))
+                type = 1;
+            else if (!strcmp(argv[i], "na"))
+                type = 2;
+            else
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "-f") && (i + 1 < argc))
+        {
+            format = argv[++i];
+            if (strcmp(format, "text") && strcmp(format, "tsv") &&
+                    strcmp(format, "bedgraph") && strcmp(format, "wig"))
+                Usage(argv[0]);
         }
-        else if (!strcmp(argv[i], "-o"))
+        else if (!strcmp(argv[i], "--usage") && (i + 1 < argc))
+            usage = argv[++i];
+        else if (!strcmp(argv[i], "--atlas") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_ATLAS);
+            atlas = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--motif") && (i + 1 < argc))
+            run.motifs = argv[++i];
+        else if (!strcmp(argv[i], "--sort") && (i + 1 < argc))
         {
             i++;
-            if ((res = fopen(argv[i], "w")) == (FILE *)NULL)
-                res = stdin;
+            if (!strcmp(argv[i], "score"))
+                run.by_score = 1;
+            else if (strcmp(argv[i], "position"))
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--min-score") && (i + 1 < argc))
+            run.min_score = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && (i + 1 < argc))
+        {
+            i++;
+            nthreads = atoi(argv[i]);
+        }
+        else if (!strcmp(argv[i], "--stats") || !strcmp(argv[i], "--stats=json"))
+        {
+            stats_json = (argv[i][7] == '=');
+            if ((run.stats == NULL) && ((run.stats = NewStats()) == NULL))
+            {
+                fprintf(stderr, "Out of memory\n");
+                exit(-1);
+            }
+        }
+        else if (!strcmp(argv[i], "-r") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_REGION);
+            region = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--index"))
+            index = 1;
+        else if (!strcmp(argv[i], "--checkpoint") && (i + 1 < argc))
+            run.checkpoint = argv[++i];
+        else if (!strcmp(argv[i], "--resume"))
+            resume = 1;
+        else if (!strcmp(argv[i], "--shard") && (i + 1 < argc))
+        {
+            i++;
+            if ((sscanf(argv[i], "%d/%d", &shard, &nshards) != 2) || (shard < 1) ||
+                    (shard > nshards))
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--enzymes") && (i + 1 < argc))
+            enzymes = argv[++i];
+        else if (!strcmp(argv[i], "--density") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_DENSITY);
+            i++;
+            if ((sscanf(argv[i], "%d,%d", &run.window, &run.step) < 1) || (run.window < 1))
+                Usage(argv[0]);
+            if (run.step < 1)
+                run.step = run.window;
+        }
+        else if (!strcmp(argv[i], "--conserved") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_CONSERVED);
+            conserved = atof(argv[++i]);
+            if ((conserved <= 0) || (conserved > 100))
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--diff") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_DIFF);
+            diff = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--orfs") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_ORFS);
+            if ((run.min_orf = atoi(argv[++i])) < 1)
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--saturation"))
+        {
+            SetMode(&mode, MODE_SATURATION);
+            saturation = 1;
+        }
+        else if (!strcmp(argv[i], "--domesticate"))
+        {
+            SetMode(&mode, MODE_DOMESTICATE);
+            domesticate = 1;
+        }
+        else if (!strcmp(argv[i], "--summary"))
+        {
+            SetMode(&mode, MODE_SUMMARY);
+            summary = 1;
+        }
+        else if (!strcmp(argv[i], "--cache"))
+            cache = 1;
+        else if (!strcmp(argv[i], "--cache-dir") && (i + 1 < argc))
+        {
+            i++;
+            cache = 1;
+            cache_dir = argv[i];
+        }
+        else if (!strcmp(argv[i], "--design") && (i + 1 < argc))
+        {
+            SetMode(&mode, MODE_DESIGN);
+            design = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--spacing") && (i + 1 < argc))
+            spacing = argv[++i];
+        else if (!strcmp(argv[i], "--max-edits") && (i + 1 < argc))
+            run.max_edits = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--top") && (i + 1 < argc))
+        {
+            if ((run.top = atoi(argv[++i])) < 1)
+                Usage(argv[0]);
         }
         else
         {
             fprintf(stderr, "Invalid Option %s \n", argv[i]);
-            fprintf(stderr, "Usage %s [-i <infile> -o <outfile>]\n", argv[0]);
-            exit(-1);
+            Usage(argv[0]);
         }
         i++;
 
     }
 
-    strcpy(aa_database, "dbase1");
-    ReadDataBase_AA(aa_database);
-
-    strcpy(re_database, "dbase2");
-    ReadDataBase_RE(re_database);
+    /* each mode takes only the formats it can write */
+    if (format && !TakesFormat(mode, format))
+    {
+        if (mode == MODE_SITES)
+            fprintf(stderr, "-f %s needs --density\n", format);
+        else
+            fprintf(stderr, "%s cannot be used with -f %s\n", modes[mode].flag, format);
+        exit(-1);
+    }
+    run.tsv = (format && !strcmp(format, "tsv")) || (mode == MODE_REGION);
+    run.wig = format && !strcmp(format, "wig");
 
-    while (1)
+    if ((index || region) && (in_fname == NULL))
     {
-        if (in == stdin)
+        fprintf(stderr, "-r and --index need a FASTA file given with -i\n");
+        exit(-1);
+    }
+    if (index)
+    {
+        if (IndexFasta(in_fname) < 0)
         {
-            printf("1:  Amino Acid Sequence.\n");
-            printf("2:  Nucleic Acid Sequence.\n");
-            printf("3:  Quit \n");
-            printf("Enter number for the type of input sequence or 3 to quit: ");
+            fprintf(stderr, "Cannot index %s\n", in_fname);
+            exit(-1);
         }
+        if (region == NULL)
+            return(0);
+    }
 
-        option = GetNum(in);
+    /* a region is read through the index, not from the start of the file */
+    if (region)
+        in = NULL;
+    else if ((in = OpenSeqFile(in_fname, nthreads)) == NULL)
+    {
+        fprintf(stderr, "Cannot read input file %s\n", in_fname);
+        exit(-1);
+    }
+    if (nshards && (region || (SeqShard(in, shard - 1, nshards) < 0)))
+    {
+        fprintf(stderr, "--shard needs an uncompressed FASTA file given with -i,"
+                " without -r\n");
+        exit(-1);
+    }
+    if (in)
+        run.first = SeqOffset(in);
+
+    /* the checkpoints are written only as the records of a FASTA file are */
+    if ((run.checkpoint || resume) &&
+            ((out_fname == NULL) || (run.checkpoint == NULL) || (mode == MODE_SUMMARY) ||
+             (mode == MODE_CONSERVED) || (mode == MODE_REGION) || (mode == MODE_DIFF) ||
+             (mode == MODE_SATURATION) || (mode == MODE_DOMESTICATE) ||
+             SeqInteractive(in) || (SeqPeek(in) != '>')))
+    {
+        fprintf(stderr, "--checkpoint needs -o and a FASTA file, --resume needs --checkpoint,"
+                " and neither goes with --summary, --conserved, -r, --diff, --saturation"
+                " or --domesticate\n");
+        exit(-1);
+    }
+    if (resume && ((res = Resume(run.checkpoint, out_fname, in, &resumed)) == NULL) && resumed)
+        exit(-1);
+    if ((res == NULL) && ((out_fname == NULL) || ((res = fopen(out_fname, "w")) == NULL)))
+        res = stdout;
 
-        if (option == 3)
-            break;
+    strcpy(aa_database, "dbase1");
+    strcpy(re_database, "dbase2");
+    StartPhase(run.stats, PHASE_LOAD);
+    if ((run.db = LoadDataBase(aa_database, re_database, &bad_fname)) == NULL)
+    {
+        printf("Error opening DataBase file %s\n", bad_fname);
+        exit(-1);
+    }
+    if (enzymes && (ParseEnzymes(run.db, enzymes) < 0))
+        exit(-1);
+    if (usage && (LoadCodonUsage(run.db, usage) < 0))
+    {
+        fprintf(stderr, "Cannot read the codon usage table %s\n", usage);
+        exit(-1);
+    }
 
-        if ((option == 1) || (option == 2))
-        {
-            if (in == stdin)
-                printf("Enter the Input Sequence\n");
+    if ((run.scan = NewScan(run.db)) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    run.res = res;
 
-            i = 0;
-            c = fgetc(in);
-            while ((c != '\n') && (c != EOF))
+    if (design && (ParseDesign(&run, design, spacing) < 0))
+        exit(-1);
+    if ((run.by_score || (run.min_score > 0)) && !run.tsv)
+    {
+        fprintf(stderr, "--sort and --min-score need -f tsv\n");
+        exit(-1);
+    }
+    if ((atlas != NULL) != (run.motifs != NULL))
+    {
+        fprintf(stderr, "--atlas and --motif go together\n");
+        exit(-1);
+    }
+    if (atlas && ((run.atlas = ReadAtlas(atlas)) == NULL))
+    {
+        fprintf(stderr, "Cannot read the atlas file %s\n", atlas);
+        exit(-1);
+    }
+    if (run.atlas && (CheckMotifs(&run) < 0))
+    {
+        fprintf(stderr, "Every --motif must be a %d-mer of bases\n", AtlasK(run.atlas));
+        exit(-1);
+    }
+
+    if ((conserved > 0) && ((run.conserved = NewConserved(run.db, conserved)) == NULL))
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    if (diff && ((mutant = OpenSeqFile(diff, 1)) == NULL))
+    {
+        fprintf(stderr, "Cannot read the mutant file %s\n", diff);
+        exit(-1);
+    }
+    if ((diff || saturation || domesticate) && ((run.sites = NewSiteTable(run.db)) == NULL))
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+    if (summary && ((run.summary = NewSummary(run.db)) == NULL))
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(-1);
+    }
+
+    /* a resumed output has its header already */
+    if (run.atlas && !resumed)
+        fprintf(res, "#sequence\tposition\tframe\tamino_acids\tmotif\n");
+    else if (run.min_orf && !resumed)
+        fprintf(res, "#sequence\torf\tstrand\tposition\tframe\tamino_acids\tenzyme\tsite"
+                "\tscore\n");
+    else if (run.sites && saturation)
+        fprintf(res, "#sequence\tposition\tref\talt\tamino_acid\tnew_amino_acid"
+                "\tsynonymous\tcreated\tdestroyed\n");
+    else if (run.sites && !domesticate)
+        fprintf(res, "#sequence\tchange\tkind\tposition\tenzyme\tsite\n");
+    else if (run.tsv && (run.nsites == 0) && !run.summary && !region && !resumed)
+        fprintf(res, TSV_HEADER);
+
+    if (cache && ((run.cache = OpenCache(cache_dir)) == NULL))
+    {
+        fprintf(stderr, "Cannot open the result cache %s\n", cache_dir ? cache_dir : "");
+        exit(-1);
+    }
+
+    err = 0;
+    if (region)
+        err = !AnalyzeRegion(&run, in_fname, region);
+    else if (run.conserved)
+    {
+        if (SeqInteractive(in) || (SeqPeek(in) != '>'))
+            fprintf(stderr, "--conserved needs an aligned FASTA file\n");
+        err = (SeqInteractive(in) || (SeqPeek(in) != '>') ||
+               (AlignRecords(&run, in, type) < 0));
+    }
+    else if (run.sites && saturation)
+    {
+        err = SeqInteractive(in) || (SeqPeek(in) != '>');
+        if (err)
+            fprintf(stderr, "--saturation needs a FASTA file\n");
+        else
+            SaturateRecords(&run, in);
+    }
+    else if (run.sites && domesticate)
+    {
+        err = SeqInteractive(in) || (SeqPeek(in) != '>');
+        if (err)
+            fprintf(stderr, "--domesticate needs a FASTA file\n");
+        else
+            DomesticateRecords(&run, in);
+    }
+    else if (run.sites)
+    {
+        if (SeqInteractive(in) || (SeqPeek(in) != '>') || (SeqPeek(mutant) != '>'))
+            fprintf(stderr, "--diff needs FASTA files\n");
+        err = (SeqInteractive(in) || (SeqPeek(in) != '>') || (SeqPeek(mutant) != '>') ||
+               (DiffRecords(&run, in, mutant) < 0));
+    }
+    else if (run.summary && !SeqInteractive(in) && (SeqPeek(in) == '>'))
+        SummarizeRecords(&run, in, type, nthreads);
+    else if (!SeqInteractive(in) && (SeqPeek(in) == '>') && !run.cache)
+        err = (PipeRecords(&run, in, type, nthreads) < 0);
+    else if (!SeqInteractive(in) && (SeqPeek(in) == '>'))
+    {
+        /* FASTA input with the cache: one analysis per record in turn */
+        memset(&rec, 0, sizeof(rec));
+        StartPhase(run.stats, PHASE_INPUT);
+        while ((i = ReadRecord(in, &rec)) > 0)
+        {
+            if (run.stats)
+            {
+                run.stats->records++;
+                run.stats->bytes_read = SeqOffset(in) - run.first;
+            }
+            ProcessRecord(&run, &rec, type);
+            Checkpoint(&run, rec.offset);
+            StartPhase(run.stats, PHASE_INPUT);
+        }
+        FreeRecord(&rec);
+        err = (i < 0);
+        if (err)
+            fprintf(stderr, "Out of memory reading the input\n");
+    }
+    else
+    {
+        while (1)
+        {
+            if (SeqInteractive(in))
             {
-                input_str[i++] = c;
-                c = fgetc(in);
+                printf("1:  Amino Acid Sequence.\n");
+                printf("2:  Nucleic Acid Sequence.\n");
+                printf("3:  Quit \n");
+                printf("Enter number for the type of input sequence or 3 to quit: ");
             }
-            input_str[i] = '\0';
 
+            StartPhase(run.stats, PHASE_INPUT);
+            option = GetNum(in);
 
-            if (Check_Input(input_str, option))
+            if ((option == 3) || (option == EOF))
+                break;
+
+            if ((option == 1) || (option == 2))
             {
-                len = strlen(input_str);
+                if (SeqInteractive(in))
+                    printf("Enter the Input Sequence\n");
 
-                if (option == 2)
+                offset = SeqOffset(in);
+                if (SeqGetLine(in, &input_str, &input_cap) < 0)
                 {
-                    n = ConvertNAToAA(input_str, aa_str, (len % 3));
-                    for (i = 0; i < n; i++)
-                    {
-                        /* Avoids analysis of duplicate amino acid sequences. */
-
-                        if (!Duplicate(aa_str, i))
-                        {
-                            ScanForRE(aa_str[i]);
-                            PrintResult(aa_str[i], res);
-                        }
-                    }
+                    if ((input_str == NULL) && ((input_str = malloc(1)) == NULL))
+                        break;
+                    input_str[0] = '\0';
                 }
-                else
+                if (run.stats)
                 {
-                    ScanForRE(input_str);
-                    PrintResult(input_str, res);
+                    run.stats->records++;
+                    run.stats->bytes_read += SeqOffset(in) - offset;
                 }
+
+                if (run.nsites > 0)
+                {
+                    if (option == 2)
+                        Design(&run, input_str, NULL);
+                    else
+                        fprintf(stderr, "--design needs nucleic acid sequences\n");
+                }
+                else if (run.summary)
+                    Analyze(&run, input_str, option, NULL);
+                else if (!LookupResult(&run, input_str, strlen(input_str), option, key))
+                    StoreResult(&run, key, Analyze(&run, input_str, option, NULL));
             }
             else
             {
-                fprintf(stderr, "Input sequence contains invalid entries: %s\n", input_str);
-                fprintf(stderr, "Please check the sequence and try again \n");
+                fprintf(stderr, "Incorrect Response. Please Enter the Correct Choice\n\n");
             }
         }
-        else
-        {
-            fprintf(stderr, "Incorrect Response. Please Enter the Correct Choice\n\n");
-        }
     }
+
+    if ((in && SeqError(in)) || (mutant && SeqError(mutant)))
+    {
+        fprintf(stderr, "Error reading the input: it is truncated or corrupt\n");
+        err = 1;
+    }
+
+    if (run.summary || (run.conserved && !err))
+    {
+        StartPhase(run.stats, PHASE_OUTPUT);
+        i = run.summary ? PrintSummary(run.summary, res) : PrintConserved(run.conserved, res);
+        if (run.stats)
+            run.stats->bytes_written += i;
+    }
+
+    StopPhase(run.stats);
+    PrintStats(run.stats, run.db, stderr, stats_json);
+
+    /* a finished run has nothing to resume */
+    if (run.checkpoint && !err)
+        remove(run.checkpoint);
+
+    free(input_str);
+    CloseSeqFile(in);
+    CloseSeqFile(mutant);
+    CloseCache(run.cache);
+    FreeAtlas(run.atlas);
+    FreeSummary(run.summary);
+    FreeConserved(run.conserved);
+    FreeSiteTable(run.sites);
+    FreeStats(run.stats);
+    FreeScan(run.scan);
+    FreeDataBase(run.db);
+    return(err ? -1 : 0);
 }
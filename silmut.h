@@ -0,0 +1,306 @@
+/****************************************************************************
+*                                                                           *
+*       libsilmut: library interface to the SILMUT engine for recognizing   *
+*       the potential silent mutation sites in an amino acid sequence.      *
+*                                                                           *
+*       A DATABASE holds the codon table (dbase1) and the amino acid        *
+*       motifs of the Restriction Enzymes (dbase2).  SelectEnzymes and      *
+*       LoadCodonUsage change it in place, so they must be called before    *
+*       the SCANs that use it are made and before any other thread uses     *
+*       it; from then on it is never modified and may be shared by any      *
+*       number of threads.                                                  *
+*       A SCAN holds the results of one scan and must only be used by one   *
+*       thread at a time.                                                   *
+*                                                                           *
+****************************************************************************/
+#ifndef SILMUT_H
+#define SILMUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define MAX_NO_AA   64
+#define LINELEN 80
+
+typedef struct DATABASE DATABASE;
+typedef struct SCAN SCAN;
+typedef struct SEQFILE SEQFILE;
+typedef struct EDIT EDIT;
+typedef struct CACHE CACHE;
+typedef struct ATLAS ATLAS;
+typedef struct SUMMARY SUMMARY;
+typedef struct CONSERVED CONSERVED;
+typedef struct QUEUE QUEUE;
+typedef struct SITE_TABLE SITE_TABLE;
+
+typedef struct
+{
+    int pos;        /* position of the motif in the amino acid string   */
+    int number;     /* number of amino acids in the motif (2 or 3)      */
+    int frame;      /* reading frame (1, 2 or 3) giving the motif       */
+    int re;         /* index of the Restriction Enzyme in the database  */
+}  OUTPUT;
+
+/* One FASTA record; the buffers are reused from record to record */
+typedef struct
+{
+    char *name;
+    size_t name_cap;
+    char *seq;              /* sequence lines, see RecordSequence           */
+    size_t seq_cap;
+    size_t len;
+    const char *raw;        /* sequence as read, maybe with line ends      */
+    size_t raw_len;
+    long long offset;       /* offset of the '>' in the uncompressed input */
+} RECORD;
+
+/* Constraints and results of DesignSites */
+#define MAX_DESIGN  16
+
+typedef struct
+{
+    int re;                 /* index of the Restriction Enzyme          */
+    int min_space;          /* bases from the start of the previous     */
+    int max_space;          /* site, not used for the first one         */
+} DESIGN_SITE;
+
+typedef struct
+{
+    int edits;                      /* base changes of all the sites    */
+    int nsites;
+    int start[MAX_DESIGN];          /* first base of each site          */
+    int site_edits[MAX_DESIGN];
+    OUTPUT hit[MAX_DESIGN];         /* each site in the translation     */
+} DESIGN;
+
+/* Recognition sequences, six bases each, and their 12-bit codes */
+#define SITE_LEN    6
+#define SITE_CODES  4096
+
+/* A site gained or lost between two versions of a sequence (DiffSites) */
+#define DIFF_SILENT 0       /* can be introduced by silent mutations    */
+#define DIFF_SITE   1       /* the recognition sequence is there        */
+
+typedef struct
+{
+    int change;             /* 1 gained, -1 lost                        */
+    int kind;               /* DIFF_SILENT or DIFF_SITE                 */
+    long pos;               /* first base, in the version that has it   */
+    int re;
+} DIFF;
+
+/* A site of a sequence and what removing it took (Domesticate) */
+typedef struct
+{
+    long pos;               /* first base                               */
+    int re;
+    int edits;              /* base changes; 0 if removed with another, */
+                            /* -1 if it could not be removed            */
+} DOMESTIC;
+
+/* An open reading frame (FindOrfs): bases start to end - 1 of the forward
+   strand, the stop codon included, read on strand 1 (forward) or -1 */
+#define ORF_START   'M'     /* amino acid of the start codons           */
+#define ORF_STOP    'X'     /* amino acid of the stop codons in dbase1  */
+
+typedef struct
+{
+    long start, end;
+    int strand;
+} ORF;
+
+/* Phases timed by STATS */
+#define PHASE_LOAD      0
+#define PHASE_INPUT     1
+#define PHASE_CHECK     2
+#define PHASE_TRANSLATE 3
+#define PHASE_SCAN      4
+#define PHASE_OUTPUT    5
+#define NPHASES         6
+
+typedef struct
+{
+    double wall[NPHASES], cpu[NPHASES];     /* seconds spent in each phase  */
+    double wall0, cpu0;                     /* start of the running phase   */
+    double start;                           /* wall clock at NewStats       */
+    int phase;                              /* running phase, -1 if none    */
+    uint64_t records;
+    uint64_t bytes_read;
+    uint64_t codons;                        /* codons translated            */
+    uint64_t positions;                     /* amino acid positions scanned */
+    uint64_t tests;                         /* enzyme motif tests           */
+    uint64_t hits;
+    uint64_t bytes_written;
+    uint64_t cache_hits;
+    uint64_t *enzyme_hits;                  /* hits of each enzyme          */
+    int nre;
+} STATS;
+
+/* Lazy scan of an amino acid string; the fields are private. */
+typedef struct
+{
+    const DATABASE *db;
+    const char *str;
+    int len, end;
+    int pos, frame, word;
+    uint64_t bits;
+} CURSOR;
+
+/* Database */
+DATABASE *LoadDataBase(const char *aa_fname, const char *re_fname,
+                       const char **bad_fname);
+void FreeDataBase(DATABASE *db);
+int NumEnzymes(const DATABASE *db);
+const char *EnzymeName(const DATABASE *db, int n);
+const char *EnzymeSite(const DATABASE *db, int n);
+int FindEnzyme(const DATABASE *db, const char *name);
+int MatchEnzyme(const DATABASE *db, int n, const char *pattern);
+int SelectEnzymes(DATABASE *db, const char *keep);
+const char *ValidAminoAcids(const DATABASE *db);
+int CodonAminoAcid(const DATABASE *db, int code);
+uint64_t DataBaseFingerprint(const DATABASE *db);
+int LoadCodonUsage(DATABASE *db, const char *fname);
+const char *ReadingFrame(const DATABASE *db, int n, int frame, int slot);
+void DisplayReTable(const DATABASE *db, FILE *fp);
+
+/* Sequences */
+int IsChIn(const char *str, char c);
+int Check_Input(const DATABASE *db, char *str, int opt);
+int ValidateInput(const DATABASE *db, char *str, int opt, size_t *bad);
+void SequenceHash(const DATABASE *db, const char *str, size_t n, uint64_t seed,
+                  uint64_t hash[2]);
+int ConvertNAToAA(const DATABASE *db, char *in_str, char **aa, int option);
+int ConvertRawNAToAA(const DATABASE *db, const char *raw, size_t n, char **aa,
+                     size_t *bad);
+int Duplicate(char *str[], int n);
+
+/* Scanning */
+SCAN *NewScan(const DATABASE *db);
+void FreeScan(SCAN *scan);
+int ScanForRE(SCAN *scan, char *str);
+int SharedResidues(char *str[], int n);
+int ScanVariants(SCAN *scan, char *str[], int n);
+int NumHits(const SCAN *scan);
+const OUTPUT *GetHit(const SCAN *scan, int k);
+const DATABASE *ScanDataBase(const SCAN *scan);
+void OpenCursor(CURSOR *cur, const DATABASE *db, const char *str, int start, int end);
+void SeekCursor(CURSOR *cur, int pos);
+int NextHit(CURSOR *cur, OUTPUT *hit);
+int HitEdits(const DATABASE *db, const char *na, const char *aa, const OUTPUT *hit);
+double HitScore(const DATABASE *db, const char *aa, const OUTPUT *hit);
+int PrintResult(const SCAN *scan, char *str, FILE *fp);
+int PrintTable(const SCAN *scan, char *str[], int nstr, const char *name,
+               long long start, double min_score, int by_score, FILE *fp);
+
+/* Edit sessions */
+EDIT *NewEdit(const DATABASE *db, const char *str, int opt);
+void FreeEdit(EDIT *ed);
+int EditReplace(EDIT *ed, int pos, int ndel, const char *ins);
+int EditInsert(EDIT *ed, int pos, const char *ins);
+int EditDelete(EDIT *ed, int pos, int ndel);
+int EditSubstitute(EDIT *ed, int pos, const char *ins);
+const char *EditText(const EDIT *ed);
+int EditLength(const EDIT *ed);
+const char *EditAminoAcids(const EDIT *ed);
+const SCAN *EditScan(const EDIT *ed);
+
+/* Sequence input (seqfile.c) */
+SEQFILE *OpenSeqFile(const char *fname, int nthreads);
+void CloseSeqFile(SEQFILE *sf);
+int SeqGetc(SEQFILE *sf);
+int SeqPeek(SEQFILE *sf);
+int SeqError(const SEQFILE *sf);
+long long SeqOffset(const SEQFILE *sf);
+int SeqInteractive(const SEQFILE *sf);
+long SeqGetLine(SEQFILE *sf, char **line, size_t *cap);
+int ReadRecord(SEQFILE *sf, RECORD *rec);
+char *RecordSequence(RECORD *rec);
+void FreeRecord(RECORD *rec);
+int SeqShard(SEQFILE *sf, int shard, int nshards);
+int SeqSeek(SEQFILE *sf, long long offset);
+int IndexFasta(const char *fname);
+char *FetchRegion(const char *fname, const char *region, long long *start);
+
+/* Multi-site designs (design.c) */
+int DesignSites(const DATABASE *db, const char *na, const DESIGN_SITE *site, int nsites,
+                int max_edits, DESIGN *best, int nbest);
+
+/* Motif atlas of all k-mers (atlas.c) */
+ATLAS *BuildAtlas(const DATABASE *db, int k, int nthreads);
+ATLAS *ReadAtlas(const char *fname);
+int WriteAtlas(const ATLAS *atlas, const char *fname);
+void PrintAtlas(const ATLAS *atlas, FILE *fp);
+void FreeAtlas(ATLAS *atlas);
+int AtlasK(const ATLAS *atlas);
+int AtlasScan(const ATLAS *atlas, const char *site, const char *aa, OUTPUT *out,
+              int max_out);
+
+/* Counts of the sites of many sequences (summary.c) */
+SUMMARY *NewSummary(const DATABASE *db);
+void FreeSummary(SUMMARY *sm);
+long SummarizeSequence(SUMMARY *sm, const char *aa);
+long SummarizeVariants(SUMMARY *sm, char *aa[], int n);
+void MergeSummary(SUMMARY *to, const SUMMARY *from);
+int PrintSummary(const SUMMARY *sm, FILE *fp);
+int MergeSummaryFiles(const char **fname, int nfiles, FILE *fp);
+
+/* Sites shared by aligned sequences (conserved.c) */
+CONSERVED *NewConserved(const DATABASE *db, double percent);
+void FreeConserved(CONSERVED *cs);
+int AddAligned(CONSERVED *cs, const char *aln, int type, size_t *bad);
+int PrintConserved(const CONSERVED *cs, FILE *fp);
+
+/* Recognition sequences present in a sequence (sites.c) */
+int SiteCode(const char *na);
+SITE_TABLE *NewSiteTable(const DATABASE *db);
+void FreeSiteTable(SITE_TABLE *t);
+const uint64_t *SiteBits(const SITE_TABLE *t, int code);
+int SiteWords(const SITE_TABLE *t);
+
+/* Sites gained and lost by an edit (diff.c) */
+long DiffSites(const DATABASE *db, const SITE_TABLE *t, const char *wt, const char *mut,
+               DIFF **diff);
+int PrintDiff(const DATABASE *db, const DIFF *diff, long n, const char *name, FILE *fp);
+
+/* Sites created and destroyed by every base substitution (saturation.c) */
+void SnvSites(const SITE_TABLE *t, const char *na, long len, long pos, char alt,
+              uint64_t *created, uint64_t *destroyed);
+long PrintSaturation(const DATABASE *db, const SITE_TABLE *t, const char *na,
+                     const char *name, FILE *fp);
+
+/* Synonymous removal of the sites of a coding sequence (domesticate.c) */
+long Domesticate(const DATABASE *db, const SITE_TABLE *t, char *na, DOMESTIC **site);
+
+/* Open reading frames (orf.c) */
+long FindOrfs(const DATABASE *db, const char *na, int min_codons, ORF **orf);
+int OrfProtein(const DATABASE *db, const char *na, const ORF *orf, char *aa);
+int PrintOrfSites(const DATABASE *db, const SCAN *scan, const char *aa, const ORF *orf,
+                  const char *name, FILE *fp);
+
+/* Tracks of the enzymes per window (density.c) */
+int PrintDensity(const DATABASE *db, const char *aa, long long nbases, const char *name,
+                 int window, int step, int wig, FILE *fp);
+
+/* Bounded single producer, single consumer queues (queue.c) */
+QUEUE *NewQueue(int capacity);
+void FreeQueue(QUEUE *q);
+void QueuePush(QUEUE *q, void *item);
+void *QueuePop(QUEUE *q);
+
+/* Result cache (cache.c) */
+CACHE *OpenCache(const char *dir);
+void CloseCache(CACHE *cache);
+const char *CacheLookup(CACHE *cache, const uint64_t key[2], size_t *nout);
+int CacheStore(CACHE *cache, const uint64_t key[2], const char *out, size_t nout);
+
+/* Statistics (stats.c); every function accepts a NULL STATS */
+STATS *NewStats(void);
+void FreeStats(STATS *st);
+void StartPhase(STATS *st, int phase);
+void StopPhase(STATS *st);
+void CountScan(STATS *st, const SCAN *scan, int len);
+void CountHits(STATS *st, const DATABASE *db, int len, long nhits);
+void MergeStats(STATS *to, const STATS *from);
+void PrintStats(const STATS *st, const DATABASE *db, FILE *fp, int json);
+
+#endif
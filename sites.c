@@ -0,0 +1,126 @@
+/****************************************************************************
+*                                                                           *
+*       sites: the recognition sequences a nucleic acid sequence already    *
+*       holds, on either strand.                                            *
+*                                                                           *
+*       The six bases at a position are read as a 12-bit code, two bits a   *
+*       base, and looked up in a table of all 4096 six-mers that gives      *
+*       the enzymes recognizing each one on either strand, as a bit set in  *
+*       the 64-bit words of the compiled tables.  So testing a position     *
+*       for every enzyme costs one lookup, and the code of the next         *
+*       position is the last one shifted by a base.                         *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+struct SITE_TABLE
+{
+    int nwords;
+    uint64_t *bits;                 /* nwords for each of the 4096 codes */
+};
+
+/* 2-bit code of a base, -1 for any other character */
+static int BaseCode(char c)
+{
+    switch (c)
+    {
+    case 'A': return(0);
+    case 'C': return(1);
+    case 'G': return(2);
+    case 'T': return(3);
+    }
+    return(-1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SiteCode:       The 12-bit code of the SITE_LEN bases at na.              *
+*                                                                             *
+*   Output:         the code, or -1 if one of them is not A, C, G or T.       *
+*                                                                             *
+******************************************************************************/
+
+int SiteCode(const char *na)
+{
+    int i, b, code = 0;
+
+    for (i = 0; i < SITE_LEN; i++)
+    {
+        if ((b = BaseCode(na[i])) < 0)
+            return(-1);
+        code = (code << 2) | b;
+    }
+    return(code);
+}
+
+/******************************************************************************
+*                                                                             *
+*   NewSiteTable:   Builds the table of the enzymes recognizing each          *
+*                   six-mer on either strand.                                 *
+*                                                                             *
+*   Output:         the table, or NULL if memory is exhausted.                *
+*                                                                             *
+*   Notes:          Enzymes whose site is not six of A, C, G and T never      *
+*                   match.                                                    *
+*                                                                             *
+******************************************************************************/
+
+SITE_TABLE *NewSiteTable(const DATABASE *db)
+{
+    SITE_TABLE *t;
+    const char *site;
+    int re, i, code, rev;
+
+    if ((t = malloc(sizeof(SITE_TABLE))) == NULL)
+        return(NULL);
+    t->nwords = (NumEnzymes(db) + 63) / 64;
+    if ((t->bits = calloc((size_t)(SITE_CODES + 1) * t->nwords, sizeof(uint64_t))) == NULL)
+    {
+        free(t);
+        return(NULL);
+    }
+    for (re = 0; re < NumEnzymes(db); re++)
+    {
+        site = EnzymeSite(db, re);
+        if ((strlen(site) != SITE_LEN) || ((code = SiteCode(site)) < 0))
+            continue;
+        for (i = 0, rev = 0; i < SITE_LEN; i++)
+            rev = (rev << 2) | (3 - ((code >> (2 * i)) & 3));
+        t->bits[code * t->nwords + re / 64] |= 1ULL << (re % 64);
+        t->bits[rev * t->nwords + re / 64] |= 1ULL << (re % 64);
+    }
+    return(t);
+}
+
+void FreeSiteTable(SITE_TABLE *t)
+{
+    if (t == NULL)
+        return;
+    free(t->bits);
+    free(t);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SiteBits:       The enzymes recognizing the six-mer of a code, as bits    *
+*                   re % 64 of words re / 64.                                 *
+*                                                                             *
+*   Input:          code. from SiteCode; -1 gives no enzymes.                 *
+*                                                                             *
+******************************************************************************/
+
+const uint64_t *SiteBits(const SITE_TABLE *t, int code)
+{
+    if (code < 0)
+        return(&t->bits[(size_t)SITE_CODES * t->nwords]);
+    return(&t->bits[code * t->nwords]);
+}
+
+int SiteWords(const SITE_TABLE *t)
+{
+    return(t->nwords);
+}
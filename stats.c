@@ -0,0 +1,267 @@
+/****************************************************************************
+*                                                                           *
+*       stats: per-phase timing and counters of a SILMUT run.               *
+*                                                                           *
+*       Every function accepts a NULL STATS and then does nothing, so the   *
+*       callers keep a single code path and pay one test per call when      *
+*       the statistics are not wanted.                                      *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "silmut.h"
+
+static const char *phase_name[NPHASES] =
+{
+    "load", "input", "check", "translate", "scan", "output"
+};
+
+static void Clocks(double *wall, double *cpu)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *wall = ts.tv_sec + ts.tv_nsec * 1e-9;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    *cpu = ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/******************************************************************************
+*                                                                             *
+*   NewStats:       Creates zeroed statistics.                                *
+*                                                                             *
+*   Output:         the statistics, or NULL if memory is exhausted.           *
+*                                                                             *
+*   Notes:          The per enzyme hit counters are sized by the first scan,  *
+*                   so the statistics can be created before the database is  *
+*                   loaded and time the loading too.                          *
+*                                                                             *
+******************************************************************************/
+
+STATS *NewStats(void)
+{
+    STATS *st;
+
+    double cpu;
+
+    if ((st = calloc(1, sizeof(STATS))) == NULL)
+        return(NULL);
+    st->phase = -1;
+    Clocks(&st->start, &cpu);
+    return(st);
+}
+
+static int GrowEnzymeHits(STATS *st, int nre)
+{
+    uint64_t *hits;
+
+    if (nre <= st->nre)
+        return(0);
+    if ((hits = realloc(st->enzyme_hits, nre * sizeof(uint64_t))) == NULL)
+        return(-1);
+    memset(&hits[st->nre], 0, (nre - st->nre) * sizeof(uint64_t));
+    st->enzyme_hits = hits;
+    st->nre = nre;
+    return(0);
+}
+
+void FreeStats(STATS *st)
+{
+    if (st == NULL)
+        return;
+    free(st->enzyme_hits);
+    free(st);
+}
+
+/******************************************************************************
+*                                                                             *
+*   StartPhase:     Charges the time since the last call to the phase that    *
+*                   was running and starts timing another one.               *
+*                                                                             *
+*   Input:          phase. PHASE_LOAD ... PHASE_OUTPUT, or -1 to stop.        *
+*                                                                             *
+******************************************************************************/
+
+void StartPhase(STATS *st, int phase)
+{
+    double wall, cpu;
+
+    if (st == NULL)
+        return;
+
+    Clocks(&wall, &cpu);
+    if (st->phase >= 0)
+    {
+        st->wall[st->phase] += wall - st->wall0;
+        st->cpu[st->phase] += cpu - st->cpu0;
+    }
+    st->phase = phase;
+    st->wall0 = wall;
+    st->cpu0 = cpu;
+}
+
+void StopPhase(STATS *st)
+{
+    StartPhase(st, -1);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CountScan:      Adds the work of one ScanForRE to the counters.           *
+*                                                                             *
+*   CountHits:      Adds the work of a scan whose sites were only counted,    *
+*                   as by SummarizeSequence, so there are no hits per enzyme. *
+*                                                                             *
+******************************************************************************/
+
+void CountHits(STATS *st, const DATABASE *db, int len, long nhits)
+{
+    int nre;
+
+    if (st == NULL)
+        return;
+
+    nre = NumEnzymes(db);
+    st->positions += len;
+    if (len >= 2)
+        st->tests += (uint64_t)nre * (len - 1);
+    if (len >= 3)
+        st->tests += (uint64_t)2 * nre * (len - 2);
+    st->hits += nhits;
+}
+
+void CountScan(STATS *st, const SCAN *scan, int len)
+{
+    int k;
+
+    if (st == NULL)
+        return;
+
+    CountHits(st, ScanDataBase(scan), len, NumHits(scan));
+    if (GrowEnzymeHits(st, NumEnzymes(ScanDataBase(scan))) < 0)
+        return;
+    for (k = 0; k < NumHits(scan); k++)
+        st->enzyme_hits[GetHit(scan, k)->re]++;
+}
+
+/******************************************************************************
+*                                                                             *
+*   MergeStats:     Adds the counters and times of one set of statistics to   *
+*                   another, e.g. those of a worker thread to the run's.      *
+*                                                                             *
+*   Notes:          Only the CPU times are added: the wall time of a worker   *
+*                   overlaps that of the thread that waits for it.            *
+*                                                                             *
+******************************************************************************/
+
+void MergeStats(STATS *to, const STATS *from)
+{
+    int i;
+
+    if ((to == NULL) || (from == NULL))
+        return;
+    GrowEnzymeHits(to, from->nre);
+
+    for (i = 0; i < NPHASES; i++)
+        to->cpu[i] += from->cpu[i];
+    to->records += from->records;
+    to->bytes_read += from->bytes_read;
+    to->codons += from->codons;
+    to->positions += from->positions;
+    to->tests += from->tests;
+    to->hits += from->hits;
+    to->bytes_written += from->bytes_written;
+    to->cache_hits += from->cache_hits;
+    for (i = 0; (i < to->nre) && (i < from->nre); i++)
+        to->enzyme_hits[i] += from->enzyme_hits[i];
+}
+
+static void JsonString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str; str++)
+    {
+        if ((*str == '"') || (*str == '\\'))
+            fputc('\\', fp);
+        fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintStats:     Writes the statistics as a summary table or as one JSON   *
+*                   object.                                                   *
+*                                                                             *
+*   Input:          db. database whose enzyme names label the hit counters.   *
+*                   json. nonzero for JSON.                                   *
+*                                                                             *
+*   Notes:          The total wall time is the time since NewStats, and that  *
+*                   of a phase is the time the calling thread spent in it.    *
+*                   The CPU times add up those of every thread merged in.     *
+*                                                                             *
+******************************************************************************/
+
+void PrintStats(const STATS *st, const DATABASE *db, FILE *fp, int json)
+{
+    int i;
+    double wall, cpu;
+
+    if (st == NULL)
+        return;
+
+    Clocks(&wall, &cpu);
+    wall -= st->start;
+    for (i = 0, cpu = 0; i < NPHASES; i++)
+        cpu += st->cpu[i];
+
+    if (json)
+    {
+        fprintf(fp, "{\"phases\":{");
+        for (i = 0; i < NPHASES; i++)
+            fprintf(fp, "%s\"%s\":{\"wall\":%.6f,\"cpu\":%.6f}", i ? "," : "",
+                    phase_name[i], st->wall[i], st->cpu[i]);
+        fprintf(fp, "},\"wall\":%.6f,\"cpu\":%.6f,", wall, cpu);
+        fprintf(fp, "\"records\":%llu,\"bytes_read\":%llu,\"codons\":%llu,"
+                "\"positions\":%llu,\"enzyme_tests\":%llu,\"hits\":%llu,"
+                "\"bytes_written\":%llu,\"cache_hits\":%llu,\"enzyme_hits\":{",
+                (unsigned long long)st->records, (unsigned long long)st->bytes_read,
+                (unsigned long long)st->codons, (unsigned long long)st->positions,
+                (unsigned long long)st->tests, (unsigned long long)st->hits,
+                (unsigned long long)st->bytes_written,
+                (unsigned long long)st->cache_hits);
+        for (i = 0; i < st->nre; i++)
+        {
+            if (i)
+                fputc(',', fp);
+            JsonString(fp, EnzymeName(db, i));
+            fprintf(fp, ":%llu", (unsigned long long)st->enzyme_hits[i]);
+        }
+        fprintf(fp, "}}\n");
+        return;
+    }
+
+    fprintf(fp, "%-12s %12s %12s\n", "phase", "wall (s)", "cpu (s)");
+    for (i = 0; i < NPHASES; i++)
+        fprintf(fp, "%-12s %12.6f %12.6f\n", phase_name[i], st->wall[i], st->cpu[i]);
+    fprintf(fp, "%-12s %12.6f %12.6f\n\n", "total", wall, cpu);
+
+    fprintf(fp, "%-20s %llu\n", "records", (unsigned long long)st->records);
+    fprintf(fp, "%-20s %llu\n", "bytes read", (unsigned long long)st->bytes_read);
+    fprintf(fp, "%-20s %llu\n", "codons translated", (unsigned long long)st->codons);
+    fprintf(fp, "%-20s %llu\n", "positions scanned", (unsigned long long)st->positions);
+    fprintf(fp, "%-20s %llu\n", "enzyme tests", (unsigned long long)st->tests);
+    fprintf(fp, "%-20s %llu\n", "hits", (unsigned long long)st->hits);
+    fprintf(fp, "%-20s %llu\n", "bytes written", (unsigned long long)st->bytes_written);
+    fprintf(fp, "%-20s %llu\n\n", "cache hits", (unsigned long long)st->cache_hits);
+
+    for (i = 0; i < st->nre; i++)
+    {
+        if (st->enzyme_hits[i])
+            fprintf(fp, "%-45s %llu\n", EnzymeName(db, i),
+                    (unsigned long long)st->enzyme_hits[i]);
+    }
+}
@@ -0,0 +1,386 @@
+/****************************************************************************
+*                                                                           *
+*       summary: counts of the potential mutation sites of many sequences   *
+*       without the sites themselves.                                       *
+*                                                                           *
+*       The sites of each amino acid sequence are taken one at a time       *
+*       from a CURSOR and only counted, per enzyme, per bin of sequence     *
+*       length and per bin of sites per sequence, so the memory used does   *
+*       not grow with the input.  Each thread keeps its own SUMMARY and     *
+*       they are added together at the end with MergeSummary.  Every row    *
+*       of the printed table is a sum, so tables of separate runs on the    *
+*       same databases can be merged by adding the rows with the same       *
+*       section and bin.                                                    *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmut.h"
+
+#define SUMMARY_BINS    33      /* 0, 1, 2-3, 4-7, ... 2^31-2^32-1      */
+
+typedef struct
+{
+    uint64_t sequences, residues, sites;
+} SUMMARY_ROW;
+
+struct SUMMARY
+{
+    const DATABASE *db;
+    SUMMARY_ROW total;
+    SUMMARY_ROW length[SUMMARY_BINS];   /* by residues of the sequence  */
+    SUMMARY_ROW density[SUMMARY_BINS];  /* by sites of the sequence     */
+    SUMMARY_ROW *enzyme;                /* sequences the enzyme fits    */
+    uint64_t *last;                     /* last sequence counted for it */
+    uint16_t *tail;                     /* its sites in a partial codon */
+};
+
+/* 0 for 0, else 1 + the number of the highest bit set */
+static int Bin(uint64_t n)
+{
+    int b = 0;
+
+    while (n)
+    {
+        b++;
+        n >>= 1;
+    }
+    return(b);
+}
+
+static void AddRow(SUMMARY_ROW *to, const SUMMARY_ROW *from)
+{
+    to->sequences += from->sequences;
+    to->residues += from->residues;
+    to->sites += from->sites;
+}
+
+/******************************************************************************
+*                                                                             *
+*   NewSummary:     Creates an empty summary of the sites of the enzymes of   *
+*                   a database.                                               *
+*                                                                             *
+*   Output:         the summary, or NULL if memory is exhausted.              *
+*                                                                             *
+******************************************************************************/
+
+SUMMARY *NewSummary(const DATABASE *db)
+{
+    SUMMARY *sm;
+    int nre = NumEnzymes(db);
+
+    if ((sm = calloc(1, sizeof(SUMMARY))) == NULL)
+        return(NULL);
+    sm->db = db;
+    sm->enzyme = calloc(nre ? nre : 1, sizeof(SUMMARY_ROW));
+    sm->last = calloc(nre ? nre : 1, sizeof(uint64_t));
+    sm->tail = calloc(nre ? nre : 1, sizeof(uint16_t));
+    if ((sm->enzyme == NULL) || (sm->last == NULL) || (sm->tail == NULL))
+    {
+        FreeSummary(sm);
+        return(NULL);
+    }
+    return(sm);
+}
+
+void FreeSummary(SUMMARY *sm)
+{
+    if (sm == NULL)
+        return;
+    free(sm->enzyme);
+    free(sm->last);
+    free(sm->tail);
+    free(sm);
+}
+
+/******************************************************************************
+*                                                                             *
+*   SummarizeSequence:  Adds the sites of one amino acid sequence to a        *
+*                       summary.                                              *
+*                                                                             *
+*   Input:              aa. sequence, as normalized by Check_Input.           *
+*                                                                             *
+*   Output:             the number of sites, as ScanForRE would find.         *
+*                                                                             *
+******************************************************************************/
+
+long SummarizeSequence(SUMMARY *sm, const char *aa)
+{
+    char *str = (char *)aa;
+
+    return(SummarizeVariants(sm, &str, 1));
+}
+
+/******************************************************************************
+*                                                                             *
+*   SummarizeVariants:  Adds the sites of one nucleic acid sequence to a      *
+*                       summary, from all its translations.                   *
+*                                                                             *
+*   Input:              aa, n. the translations from ConvertNAToAA.           *
+*                                                                             *
+*   Output:             the number of sites, as ScanVariants would find.      *
+*                                                                             *
+*   Notes:              The sequence is counted once, with the residues of    *
+*                       the first translation.  The sites of the others only  *
+*                       count where they reach the partial last codon, each   *
+*                       position, frame and enzyme once; those few are kept   *
+*                       as bits of sm->tail, so no site list is built.        *
+*                                                                             *
+******************************************************************************/
+
+long SummarizeVariants(SUMMARY *sm, char *aa[], int n)
+{
+    CURSOR cur;
+    OUTPUT hit;
+    SUMMARY_ROW row;
+    uint64_t serial = sm->total.sequences + 1;
+    int i, bit, shared = SharedResidues(aa, n);
+    long count = 0;
+
+    row.sequences = 1;
+    row.residues = strlen(aa[0]);
+    if (n > 1)
+        memset(sm->tail, 0, NumEnzymes(sm->db) * sizeof(uint16_t));
+    for (i = 0; i < n; i++)
+    {
+        if (Duplicate(aa, i))
+            continue;
+        OpenCursor(&cur, sm->db, aa[i], ((i == 0) || (shared < 2)) ? 0 : shared - 2, -1);
+        while (NextHit(&cur, &hit))
+        {
+            if (hit.pos + hit.number > shared)
+            {
+                /* a site of the partial codon: hit.pos is shared - 2 or more */
+                bit = 1 << (3 * (hit.pos - shared + 2) + hit.frame - 1);
+                if (sm->tail[hit.re] & bit)
+                    continue;
+                sm->tail[hit.re] |= bit;
+            }
+            else if (i > 0)
+                continue;
+            count++;
+            sm->enzyme[hit.re].sites++;
+            if (sm->last[hit.re] != serial)
+            {
+                sm->last[hit.re] = serial;
+                sm->enzyme[hit.re].sequences++;
+                sm->enzyme[hit.re].residues += row.residues;
+            }
+        }
+    }
+    row.sites = count;
+    AddRow(&sm->total, &row);
+    AddRow(&sm->length[Bin(row.residues)], &row);
+    AddRow(&sm->density[Bin(count)], &row);
+    return(count);
+}
+
+/******************************************************************************
+*                                                                             *
+*   MergeSummary:   Adds the counts of one summary to another of the same     *
+*                   database, e.g. those of a worker thread to the run's.     *
+*                                                                             *
+******************************************************************************/
+
+void MergeSummary(SUMMARY *to, const SUMMARY *from)
+{
+    int i;
+
+    AddRow(&to->total, &from->total);
+    for (i = 0; i < SUMMARY_BINS; i++)
+    {
+        AddRow(&to->length[i], &from->length[i]);
+        AddRow(&to->density[i], &from->density[i]);
+    }
+    for (i = 0; i < NumEnzymes(to->db); i++)
+        AddRow(&to->enzyme[i], &from->enzyme[i]);
+}
+
+static int PrintRow(FILE *fp, const char *section, const char *bin, const SUMMARY_ROW *row)
+{
+    return(fprintf(fp, "%s\t%s\t%llu\t%llu\t%llu\n", section, bin,
+                   (unsigned long long)row->sequences, (unsigned long long)row->residues,
+                   (unsigned long long)row->sites));
+}
+
+static int PrintBins(FILE *fp, const char *section, const SUMMARY_ROW *row)
+{
+    char bin[48];
+    int i, c = 0;
+
+    for (i = 0; i < SUMMARY_BINS; i++)
+    {
+        if (row[i].sequences == 0)
+            continue;
+        if (i <= 1)
+            sprintf(bin, "%d", i);
+        else
+            sprintf(bin, "%llu-%llu", 1ULL << (i - 1), (1ULL << i) - 1);
+        c += PrintRow(fp, section, bin, &row[i]);
+    }
+    return(c);
+}
+
+/******************************************************************************
+*                                                                             *
+*   PrintSummary:   Writes a summary as a tab separated table.                *
+*                                                                             *
+*   Output:         the number of characters written.                         *
+*                                                                             *
+*   Notes:          Each row gives a section, a bin, and the number of        *
+*                   sequences in the bin, their residues and their sites:     *
+*                       total   all           every sequence                  *
+*                       length  64-127        sequences of 64 to 127 residues *
+*                       sites   2-3           sequences with 2 or 3 sites     *
+*                       enzyme  EcoRI         sequences with a site of the    *
+*                                             enzyme, and its sites only      *
+*                   Empty length and sites bins are left out; every enzyme    *
+*                   has a row.                                                *
+*                                                                             *
+******************************************************************************/
+
+int PrintSummary(const SUMMARY *sm, FILE *fp)
+{
+    int i, c;
+
+    c = fprintf(fp, "#section\tbin\tsequences\tresidues\tsites\n");
+    c += PrintRow(fp, "total", "all", &sm->total);
+    c += PrintBins(fp, "length", sm->length);
+    c += PrintBins(fp, "sites", sm->density);
+    for (i = 0; i < NumEnzymes(sm->db); i++)
+        c += PrintRow(fp, "enzyme", EnzymeName(sm->db, i), &sm->enzyme[i]);
+    return(c);
+}
+
+typedef struct
+{
+    char section[16];
+    char bin[64];
+    int rank;                           /* order of the section         */
+    unsigned long long lo;              /* first value of a bin, or the */
+    SUMMARY_ROW row;                    /* order an enzyme was found in */
+} TABLE_ROW;
+
+static int CompareRows(const void *a, const void *b)
+{
+    const TABLE_ROW *x = a, *y = b;
+
+    if (x->rank != y->rank)
+        return(x->rank < y->rank ? -1 : 1);
+    if (x->lo != y->lo)
+        return(x->lo < y->lo ? -1 : 1);
+    return(0);
+}
+
+static int SectionRank(const char *section)
+{
+    static const char *order[] = {"total", "length", "sites", "enzyme"};
+    int i;
+
+    for (i = 0; i < 4; i++)
+        if (!strcmp(section, order[i]))
+            return(i);
+    return(-1);
+}
+
+typedef struct
+{
+    TABLE_ROW *row;
+    int n, cap, nenzymes;
+    char header[256];
+} TABLE;
+
+/* adds one row of a table to the sum, -1 if it is not a summary row */
+static int AddTableRow(TABLE *t, const char *line)
+{
+    TABLE_ROW r, *p;
+    unsigned long long sequences, residues, sites, hi;
+    int i;
+
+    memset(&r, 0, sizeof(r));
+    if ((sscanf(line, "%15[^\t]\t%63[^\t]\t%llu\t%llu\t%llu", r.section, r.bin,
+                &sequences, &residues, &sites) != 5) ||
+            ((r.rank = SectionRank(r.section)) < 0))
+        return(-1);
+    r.row.sequences = sequences;
+    r.row.residues = residues;
+    r.row.sites = sites;
+    for (i = 0; i < t->n; i++)
+    {
+        if (!strcmp(t->row[i].section, r.section) && !strcmp(t->row[i].bin, r.bin))
+        {
+            AddRow(&t->row[i].row, &r.row);
+            return(0);
+        }
+    }
+    if (r.rank == 3)
+        r.lo = t->nenzymes++;
+    else if ((r.rank != 0) && (sscanf(r.bin, "%llu-%llu", &r.lo, &hi) < 1))
+        return(-1);
+    if (t->n == t->cap)
+    {
+        if ((p = realloc(t->row, 2 * (t->cap + 32) * sizeof(TABLE_ROW))) == NULL)
+            return(-1);
+        t->row = p;
+        t->cap = 2 * (t->cap + 32);
+    }
+    t->row[t->n++] = r;
+    return(0);
+}
+
+/* adds the rows of one table file, -1 if it cannot be read or has other columns */
+static int ReadTable(TABLE *t, const char *fname)
+{
+    char line[256];
+    FILE *fp;
+    int status = 0;
+
+    if ((fp = fopen(fname, "r")) == NULL)
+        return(-1);
+    while ((status == 0) && fgets(line, sizeof(line), fp))
+    {
+        if (line[0] != '#')
+            status = AddTableRow(t, line);
+        else if (t->header[0] == '\0')
+            strcpy(t->header, line);
+        else if (strcmp(line, t->header))
+            status = -1;
+    }
+    if (ferror(fp) || (t->header[0] == '\0'))
+        status = -1;
+    fclose(fp);
+    return(status);
+}
+
+/******************************************************************************
+*                                                                             *
+*   MergeSummaryFiles:  Adds up summary tables written by PrintSummary, e.g.  *
+*                       those of the shards of one input, and writes the sum  *
+*                       as PrintSummary would have for the whole input.       *
+*                                                                             *
+*   Output:             the number of characters written, or -1 if a file     *
+*                       cannot be read or is not a summary table.             *
+*                                                                             *
+******************************************************************************/
+
+int MergeSummaryFiles(const char **fname, int nfiles, FILE *fp)
+{
+    TABLE t;
+    int i, c = -1;
+
+    memset(&t, 0, sizeof(t));
+    for (i = 0; i < nfiles; i++)
+        if (ReadTable(&t, fname[i]) < 0)
+            break;
+    if (i == nfiles)
+    {
+        qsort(t.row, t.n, sizeof(TABLE_ROW), CompareRows);
+        c = fprintf(fp, "%s", t.header);
+        for (i = 0; i < t.n; i++)
+            c += PrintRow(fp, t.row[i].section, t.row[i].bin, &t.row[i].row);
+    }
+    free(t.row);
+    return(c);
+}
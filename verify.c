@@ -0,0 +1,2475 @@
+/****************************************************************************
+*                                                                           *
+*       verify: differential check of the SILMUT engine.                    *
+*                                                                           *
+*       Every case draws a random dbase2 and a random nucleic acid or       *
+*       amino acid sequence, runs the engine and compares the result with   *
+*       a brute force reference that knows nothing about reading frame      *
+*       motifs: for every window of two or three amino acids it tries all   *
+*       the synonymous codon choices and looks for the recognition          *
+*       sequence in the resulting DNA.                                      *
+*                                                                           *
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "silmut.h"
+#include "seqgen.h"
+#include "verify.h"
+
+#define MAX_RE      130
+#define MAX_AA_LEN  80
+#define MAX_NA_LEN  240
+#define EDITS       20
+#define DESIGNS     100000
+#define QUEUE_ITEMS 100000
+#define SHARD_RECORDS 6
+#define GZ_RECORDS  3
+#define ALIGNED     8
+#define MAX_GAPS    10
+
+typedef struct
+{
+    char codon[64][4];          /* all codons, in 2-bit code order      */
+    char aa[64];                /* amino acid of each codon, 0 if none  */
+    char site[MAX_RE][7];
+    int nre;
+    double cost[64];            /* -ln w of each codon, from the usage  */
+} REFERENCE;
+
+typedef struct
+{
+    OUTPUT hit[MAX_AA_LEN * 3 * MAX_RE];
+    int edits[MAX_AA_LEN * 3 * MAX_RE];
+    double score[MAX_AA_LEN * 3 * MAX_RE];
+    int n;
+} REF_HITS;
+
+static const char base[5] = { 'A', 'C', 'G', 'T', '\0' };
+
+/* What Check_Input drops between letters: white space, line ends and the
+   position numbers of a GenBank or EMBL listing */
+static const char *separator[6] = { " ", "\t", "\n", "\r\n", "1", "60 " };
+
+/******************************************************************************
+*                                                                             *
+*   RefReadCodons:  Reads the codon table straight from dbase1; the first     *
+*                   entry for a codon wins, as in the engine.                 *
+*                                                                             *
+******************************************************************************/
+
+static int RefReadCodons(REFERENCE *ref, const char *fname)
+{
+    FILE *fp;
+    char line[80], codon[8], aa;
+    int i;
+
+    for (i = 0; i < 64; i++)
+    {
+        ref->codon[i][0] = base[i >> 4];
+        ref->codon[i][1] = base[(i >> 2) & 3];
+        ref->codon[i][2] = base[i & 3];
+        ref->codon[i][3] = '\0';
+        ref->aa[i] = 0;
+    }
+
+    if ((fp = fopen(fname, "r")) == NULL)
+        return(-1);
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (sscanf(line, "%7s %c", codon, &aa) != 2)
+            continue;
+        for (i = 0; i < 64; i++)
+        {
+            if (!strcmp(ref->codon[i], codon) && (ref->aa[i] == 0))
+                ref->aa[i] = aa;
+        }
+    }
+    fclose(fp);
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RandomUsage:    Writes a random codon usage table, in one of the formats  *
+*                   LoadCodonUsage reads, and sets the cost of each codon as  *
+*                   the reference sees it.                                    *
+*                                                                             *
+******************************************************************************/
+
+static int RandomUsage(REFERENCE *ref, SEQGEN *g, const char *fname)
+{
+    double freq[64], best;
+    int i, j, rna = SeqGenNext(g) & 1, with_aa = SeqGenNext(g) & 1;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "w")) == NULL)
+        return(-1);
+    for (i = 0; i < 64; i++)
+    {
+        freq[i] = (SeqGenNext(g) % 8) ? (double)(SeqGenNext(g) % 500) / 10 : 0;
+        for (j = 0; j < 3; j++)
+            fputc((rna && (ref->codon[i][j] == 'T')) ? 'U' : ref->codon[i][j], fp);
+        if (with_aa)
+            fprintf(fp, " %c", ref->aa[i] ? ref->aa[i] : 'X');
+        fprintf(fp, " %.1f%s", freq[i], (i % 4 == 3) ? "\n" : "  ");
+    }
+    fclose(fp);
+
+    for (i = 0; i < 64; i++)
+    {
+        for (j = 0, best = 0; j < 64; j++)
+        {
+            if ((ref->aa[j] == ref->aa[i]) && (freq[j] > best))
+                best = freq[j];
+        }
+        if (best <= 0)
+            ref->cost[i] = 0;
+        else
+            ref->cost[i] = -log((freq[i] / best < 0.01) ? 0.01 : freq[i] / best);
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RefTranslate:   Translates the complete codons of a nucleic acid string.  *
+*                                                                             *
+******************************************************************************/
+
+static void RefTranslate(const REFERENCE *ref, const char *na, int len, char *aa)
+{
+    int i, j, k = 0;
+
+    for (i = 0; i + 3 <= len; i += 3)
+    {
+        for (j = 0; j < 64; j++)
+        {
+            if (!strncmp(ref->codon[j], &na[i], 3))
+            {
+                if (ref->aa[j])
+                    aa[k++] = ref->aa[j];
+                break;
+            }
+        }
+    }
+    aa[k] = '\0';
+}
+
+/******************************************************************************
+*                                                                             *
+*   Scramble:       Writes a sequence as a user might type or paste it, with  *
+*                   separators between letters and some in lower case.        *
+*                                                                             *
+*   Output:         the length of the result, at most 4 * strlen(str).        *
+*                                                                             *
+******************************************************************************/
+
+static int Scramble(SEQGEN *g, const char *str, char *out)
+{
+    int i, j, clean;
+    const char *sep;
+
+    /* half of them mostly clean, for the 16 character fast path */
+    clean = (int)(SeqGenNext(g) & 1);
+    for (i = 0, j = 0; str[i]; i++)
+    {
+        if ((SeqGenNext(g) % (clean ? 64 : 16)) == 0)
+        {
+            for (sep = separator[SeqGenNext(g) % 6]; *sep; sep++)
+                out[j++] = *sep;
+        }
+        out[j++] = (clean || (SeqGenNext(g) % 4)) ? str[i] : tolower((unsigned char)str[i]);
+    }
+    out[j] = '\0';
+    return(j);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckInvalid:   Puts an invalid character into a scrambled sequence and   *
+*                   checks that ValidateInput finds it.                       *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckInvalid(const DATABASE *db, SEQGEN *g, const char *str, int len,
+                        int opt, FILE *log)
+{
+    char buf[4 * MAX_NA_LEN + 1], c;
+    size_t bad;
+    int k;
+
+    if (len == 0)
+        return(0);
+
+    /* an upper case letter that is not an amino acid, if there is one */
+    c = (opt == 2) ? 'N' : 'A';
+    while ((opt == 1) && (c <= 'Z') && IsChIn(ValidAminoAcids(db), c))
+        c++;
+    if (c > 'Z')
+        c = '#';
+
+    strcpy(buf, str);
+    k = (int)(SeqGenNext(g) % len);
+    buf[k] = c;
+    if (ValidateInput(db, buf, opt, &bad) || (bad != (size_t)k))
+    {
+        fprintf(log, "  ValidateInput missed the %c at %d of %s\n", c, k, str);
+        return(1);
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RefSite:        Tries every synonymous codon choice for n amino acids     *
+*                   and looks for a recognition sequence at offset off of the *
+*                   resulting DNA.                                            *
+*                                                                             *
+*   Output:         -1 if no choice gives the site, otherwise the smallest    *
+*                   number of bases differing from na (positions past nalen   *
+*                   are free).  cost is set to the smallest codon usage cost  *
+*                   of a choice giving the site.                              *
+*                                                                             *
+******************************************************************************/
+
+static int RefSite(const REFERENCE *ref, const char *aa, int n, const char *site,
+                   int off, const char *na, int nalen, double *cost)
+{
+    int syn[3][64], nsyn[3], pick[3];
+    int i, j, k, d, best = -1;
+    char dna[10];
+    double c;
+
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0, nsyn[i] = 0; j < 64; j++)
+        {
+            if (ref->aa[j] == aa[i])
+                syn[i][nsyn[i]++] = j;
+        }
+        if (nsyn[i] == 0)
+            return(-1);
+        pick[i] = 0;
+    }
+
+    for (;;)
+    {
+        for (i = 0; i < n; i++)
+            memcpy(&dna[3 * i], ref->codon[syn[i][pick[i]]], 3);
+
+        if (!memcmp(&dna[off], site, 6))
+        {
+            for (k = 0, d = 0; k < 3 * n; k++)
+            {
+                if ((na != NULL) && (k < nalen) && (dna[k] != na[k]))
+                    d++;
+            }
+            for (i = 0, c = 0; i < n; i++)
+                c += ref->cost[syn[i][pick[i]]];
+            if ((best < 0) || (c < *cost))
+                *cost = c;
+            if ((best < 0) || (d < best))
+                best = d;
+        }
+
+        for (i = n - 1; i >= 0; i--)
+        {
+            if (++pick[i] < nsyn[i])
+                break;
+            pick[i] = 0;
+        }
+        if (i < 0)
+            break;
+    }
+    return(best);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RefScan:        Brute force equivalent of ScanForRE, HitEdits and         *
+*                   HitScore.                                                 *
+*                                                                             *
+******************************************************************************/
+
+static void RefScan(const REFERENCE *ref, const char *aa, const char *na, int nalen,
+                    REF_HITS *hits)
+{
+    int len = strlen(aa), p, frame, j, n, e;
+    double cost;
+
+    hits->n = 0;
+    for (p = 0; p < len; p++)
+    {
+        for (frame = 1; frame <= 3; frame++)
+        {
+            n = (frame == 1) ? 2 : 3;
+            if (p + n > len)
+                continue;
+            for (j = 0; j < ref->nre; j++)
+            {
+                e = RefSite(ref, &aa[p], n, ref->site[j], frame - 1,
+                            na ? &na[3 * p] : NULL, na ? nalen - 3 * p : 0, &cost);
+                if (e < 0)
+                    continue;
+                hits->hit[hits->n].pos = p;
+                hits->hit[hits->n].number = n;
+                hits->hit[hits->n].frame = frame;
+                hits->hit[hits->n].re = j;
+                hits->edits[hits->n] = e;
+                hits->score[hits->n] = exp(-cost / n);
+                hits->n++;
+            }
+        }
+    }
+}
+
+static int SameHit(const OUTPUT *a, const OUTPUT *b)
+{
+    return((a->pos == b->pos) && (a->number == b->number) &&
+           (a->frame == b->frame) && (a->re == b->re));
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckScan:      Compares ScanForRE, HitEdits, HitScore, the site count    *
+*                   of SummarizeSequence, AtlasScan and a resumed CURSOR on   *
+*                   one amino acid string with the reference.                 *
+*                                                                             *
+*   Output:         number of differences.                                    *
+*                                                                             *
+******************************************************************************/
+
+static int CheckScan(const DATABASE *db, const REFERENCE *ref, SCAN *scan, SEQGEN *g,
+                     const char *aa, const char *na, const ATLAS *atlas, REF_HITS *hits,
+                     FILE *log)
+{
+    static OUTPUT motif[MAX_AA_LEN * 3];
+    SUMMARY *sm;
+    CURSOR cur;
+    OUTPUT hit;
+    int i, k, n, e, start, end, stop, len = strlen(aa), errors = 0;
+
+    RefScan(ref, aa, na, na ? (int)strlen(na) : 0, hits);
+
+    if (ScanForRE(scan, (char *)aa) != hits->n)
+    {
+        fprintf(log, "  ScanForRE found %d sites, reference %d\n", NumHits(scan), hits->n);
+        return(1);
+    }
+    for (i = 0; i < hits->n; i++)
+    {
+        if (!SameHit(GetHit(scan, i), &hits->hit[i]))
+        {
+            fprintf(log, "  site %d differs: pos %d frame %d enzyme %d, reference"
+                    " pos %d frame %d enzyme %d\n", i, GetHit(scan, i)->pos,
+                    GetHit(scan, i)->frame, GetHit(scan, i)->re, hits->hit[i].pos,
+                    hits->hit[i].frame, hits->hit[i].re);
+            return(1);
+        }
+        if ((na != NULL) &&
+                ((e = HitEdits(db, na, aa, &hits->hit[i])) != hits->edits[i]))
+        {
+            fprintf(log, "  site %d needs %d edits, reference %d\n", i, e, hits->edits[i]);
+            errors++;
+        }
+        if (fabs(HitScore(db, aa, &hits->hit[i]) - hits->score[i]) > 1e-4)
+        {
+            fprintf(log, "  site %d scores %f, reference %f\n", i,
+                    HitScore(db, aa, &hits->hit[i]), hits->score[i]);
+            errors++;
+        }
+    }
+
+    /* A summary counts the same sites without keeping them */
+    if ((sm = NewSummary(db)) != NULL)
+    {
+        if (SummarizeSequence(sm, aa) != hits->n)
+        {
+            fprintf(log, "  SummarizeSequence counted %ld sites, reference %d\n",
+                    SummarizeSequence(sm, aa), hits->n);
+            errors++;
+        }
+        FreeSummary(sm);
+    }
+
+    /* The atlas finds the sites of one enzyme from its recognition sequence */
+    e = (int)(SeqGenNext(g) % ref->nre);
+    n = AtlasScan(atlas, ref->site[e], aa, motif, MAX_AA_LEN * 3);
+    for (i = k = 0; (i < hits->n) && (n >= 0); i++)
+    {
+        if (hits->hit[i].re != e)
+            continue;
+        if ((k == n) || (motif[k].pos != hits->hit[i].pos) ||
+                (motif[k].frame != hits->hit[i].frame) ||
+                (motif[k].number != hits->hit[i].number))
+            break;
+        k++;
+    }
+    if ((k != n) || (i < hits->n))
+    {
+        fprintf(log, "  AtlasScan of %s differs from the sites of enzyme %d\n",
+                ref->site[e], e);
+        errors++;
+    }
+
+    /* A window scanned in two pieces gives the same sites as ScanForRE */
+    start = (int)(SeqGenNext(g) % (len + 1));
+    end = start + (int)(SeqGenNext(g) % (len + 1 - start));
+    stop = (int)(SeqGenNext(g) % 8);
+    OpenCursor(&cur, db, aa, start, end);
+    for (i = 0; (i < hits->n) && (hits->hit[i].pos < start); i++)
+        ;
+    for (k = 0; ; k++)
+    {
+        if (k == stop)
+        {
+            /* Suspend the cursor, scan something else, then resume it */
+            CURSOR saved = cur;
+
+            OpenCursor(&cur, db, aa, 0, -1);
+            NextHit(&cur, &hit);
+            cur = saved;
+        }
+        if (!NextHit(&cur, &hit))
+            break;
+        if ((i >= hits->n) || (hits->hit[i].pos >= end) || !SameHit(&hit, &hits->hit[i]))
+        {
+            fprintf(log, "  cursor on [%d, %d) differs at site %d\n", start, end, k);
+            return(errors + 1);
+        }
+        i++;
+    }
+    if ((i < hits->n) && (hits->hit[i].pos < end))
+    {
+        fprintf(log, "  cursor on [%d, %d) stopped early\n", start, end);
+        errors++;
+    }
+    return(errors);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RefVariants:    The sites of all the translations of one nucleic acid     *
+*                   sequence, each position, frame and enzyme once.           *
+*                                                                             *
+*   Output:         the number of sites; variant_of gives the first           *
+*                   translation with each, -1 where there is none.            *
+*                                                                             *
+******************************************************************************/
+
+static signed char variant_of[MAX_AA_LEN + 1][3][MAX_RE];
+
+static int RefVariants(const REFERENCE *ref, char **aa_str, int n, REF_HITS *hits)
+{
+    int i, k, count = 0;
+    signed char *v;
+
+    memset(variant_of, -1, sizeof(variant_of));
+    for (i = 0; i < n; i++)
+    {
+        if (Duplicate(aa_str, i))
+            continue;
+        RefScan(ref, aa_str[i], NULL, 0, hits);
+        for (k = 0; k < hits->n; k++)
+        {
+            v = &variant_of[hits->hit[k].pos][hits->hit[k].frame - 1][hits->hit[k].re];
+            if (*v < 0)
+            {
+                *v = (signed char)i;
+                count++;
+            }
+        }
+    }
+    return(count);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckVariants:  Compares ScanVariants on the translations of a nucleic    *
+*                   acid sequence with the reference, and checks that         *
+*                   PrintTable lists each of its sites once, with the amino   *
+*                   acids of a translation that has it, and that a summary    *
+*                   of the sequence taken twice counts each site twice.       *
+*                                                                             *
+*   Input:          start. as for PrintTable.                                 *
+*                                                                             *
+*   Output:         number of differences.                                    *
+*                                                                             *
+******************************************************************************/
+
+static int CheckVariants(const DATABASE *db, const REFERENCE *ref, SCAN *scan, SEQGEN *g,
+                         char **aa_str, int n, long long start, REF_HITS *hits, FILE *log)
+{
+    char motif[8], section[16], bin[16];
+    const OUTPUT *hit;
+    long long x;
+    int p, f, re, k = 0, nref = RefVariants(ref, aa_str, n, hits), rows = 0, v;
+    int sites[MAX_RE];
+    unsigned long long seqs, res, count, len = strlen(aa_str[0]);
+    double score;
+    SUMMARY *sm;
+    FILE *fp;
+
+    if (ScanVariants(scan, aa_str, n) != nref)
+    {
+        fprintf(log, "  ScanVariants of %d translations found %d sites, reference %d\n", n,
+                NumHits(scan), nref);
+        return(1);
+    }
+    for (p = 0; p <= MAX_AA_LEN; p++)
+    {
+        for (f = 0; f < 3; f++)
+        {
+            for (re = 0; re < ref->nre; re++)
+            {
+                if (variant_of[p][f][re] < 0)
+                    continue;
+                hit = GetHit(scan, k++);
+                if ((hit->pos != p) || (hit->frame != f + 1) || (hit->re != re))
+                {
+                    fprintf(log, "  ScanVariants site %d is pos %d frame %d enzyme %d,"
+                            " reference pos %d frame %d enzyme %d\n", k - 1, hit->pos,
+                            hit->frame, hit->re, p, f + 1, re);
+                    return(1);
+                }
+            }
+        }
+    }
+
+    /* the summary rows of the total and of each enzyme */
+    memset(sites, 0, sizeof(sites));
+    for (p = 0; p <= MAX_AA_LEN; p++)
+        for (f = 0; f < 3; f++)
+            for (re = 0; re < ref->nre; re++)
+                sites[re] += (variant_of[p][f][re] >= 0);
+    if (((sm = NewSummary(db)) == NULL) || ((fp = tmpfile()) == NULL))
+        return(1);
+    for (k = 0; k < 2; k++)
+        SummarizeVariants(sm, aa_str, n);
+    PrintSummary(sm, fp);
+    FreeSummary(sm);
+    rewind(fp);
+    fscanf(fp, "%*[^\n]");
+    while (fscanf(fp, "%15s %15s %llu %llu %llu", section, bin, &seqs, &res, &count) == 5)
+    {
+        re = -1;
+        if ((!strcmp(section, "total") && ((seqs != 2) || (res != 2 * len) ||
+                                            (count != 2ULL * nref))) ||
+                (!strcmp(section, "enzyme") && (sscanf(bin, "Rnd%d", &re) == 1) &&
+                 ((re < 1) || (re > ref->nre) || (count != 2ULL * sites[re - 1]) ||
+                  (seqs != (sites[re - 1] ? 2 : 0)) || (res != seqs * len))))
+        {
+            fprintf(log, "  summary of %d translations of %llu residues gave %s %s"
+                    " %llu %llu %llu, reference %d sites\n", n, len, section, bin, seqs,
+                    res, count, ((re >= 1) && (re <= ref->nre)) ? sites[re - 1] : nref);
+            fclose(fp);
+            return(1);
+        }
+    }
+    fclose(fp);
+
+    if ((fp = tmpfile()) == NULL)
+        return(1);
+    PrintTable(scan, aa_str, n, "v", start, -1.0, (int)(SeqGenNext(g) & 1), fp);
+    rewind(fp);
+    while (fscanf(fp, "%*s %lld %d %7s Rnd%d %*s %lf", &x, &f, motif, &re, &score) == 5)
+    {
+        rows++;
+        p = (int)((start < 0) ? x - 1 : (x - start - f) / 3);
+        re--;
+        if ((p < 0) || (p > MAX_AA_LEN) || (f < 1) || (f > 3) || (re < 0) ||
+                (re >= ref->nre) || ((v = variant_of[p][f - 1][re]) < 0) ||
+                ((int)strlen(motif) != ((f == 1) ? 2 : 3)) ||
+                strncmp(motif, &aa_str[v][p], strlen(motif)))
+        {
+            fprintf(log, "  PrintTable row %d, position %lld frame %d %s enzyme %d, is"
+                    " not a site or listed twice\n", rows, x, f, motif, re);
+            fclose(fp);
+            return(1);
+        }
+        variant_of[p][f - 1][re] = -2;
+    }
+    fclose(fp);
+    if (rows != nref)
+    {
+        fprintf(log, "  PrintTable listed %d sites, ScanVariants %d\n", rows, nref);
+        return(1);
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckEdit:      Makes random edits in an edit session and compares its    *
+*                   sites after each with a full ScanForRE of the sequence.   *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckEdit(const DATABASE *db, const REFERENCE *ref, SCAN *scan, SEQGEN *g,
+                     const char *str, int opt, FILE *log)
+{
+    EDIT *ed;
+    const SCAN *es;
+    char ins[8], *aa_str[16];
+    int i, k, n, pos, ndel, len, errors = 0;
+
+    /* nucleic acid sessions need all 64 codons */
+    for (i = 0; (opt == 2) && (i < 64); i++)
+    {
+        if (ref->aa[i] == 0)
+            return(0);
+    }
+
+    if ((ed = NewEdit(db, str, opt)) == NULL)
+    {
+        fprintf(log, "  NewEdit failed on %s\n", str);
+        return(1);
+    }
+    if (EditReplace(ed, EditLength(ed) + 1, 0, "") != -1)
+    {
+        fprintf(log, "  EditReplace accepted a position past the end\n");
+        errors++;
+    }
+
+    for (k = 0; (k < EDITS) && !errors; k++)
+    {
+        len = EditLength(ed);
+        pos = (int)(SeqGenNext(g) % (len + 1));
+        ndel = (int)(SeqGenNext(g) % 4);
+        if (ndel > len - pos)
+            ndel = len - pos;
+        n = (int)(SeqGenNext(g) % 5);
+        if (opt == 2)
+            RandomNA(g, ins, n, 0.5);
+        else
+            RandomAA(g, ins, n, ValidAminoAcids(db));
+        if (EditReplace(ed, pos, ndel, ins) < 0)
+        {
+            fprintf(log, "  EditReplace(%d, %d, %s) failed\n", pos, ndel, ins);
+            errors++;
+            break;
+        }
+
+        if (opt == 2)
+            ConvertNAToAA(db, (char *)EditText(ed), aa_str, 0);
+        else if ((aa_str[0] = malloc(strlen(EditText(ed)) + 1)) != NULL)
+            strcpy(aa_str[0], EditText(ed));
+        if (aa_str[0] == NULL)
+            break;
+        ScanForRE(scan, aa_str[0]);
+        es = EditScan(ed);
+        if (strcmp(EditAminoAcids(ed), aa_str[0]) || (NumHits(es) != NumHits(scan)))
+        {
+            fprintf(log, "  after EditReplace(%d, %d, %s) the session has %d sites on %s,"
+                    " ScanForRE %d on %s\n", pos, ndel, ins, NumHits(es),
+                    EditAminoAcids(ed), NumHits(scan), aa_str[0]);
+            errors++;
+        }
+        for (i = 0; !errors && (i < NumHits(scan)); i++)
+        {
+            if (!SameHit(GetHit(es, i), GetHit(scan, i)))
+            {
+                fprintf(log, "  after EditReplace(%d, %d, %s) site %d differs\n",
+                        pos, ndel, ins, i);
+                errors++;
+            }
+        }
+        free(aa_str[0]);
+    }
+    FreeEdit(ed);
+    return(errors);
+}
+
+/* occurrences of a recognition sequence on either strand, and the first one */
+static int RefCount(const char *site, const char *na, int len, int *first)
+{
+    char rev[7];
+    int i, j, n = 0;
+
+    for (i = 0; i < 6; i++)
+    {
+        for (j = 0; base[j] != site[5 - i]; j++)
+            ;
+        rev[i] = base[3 - j];
+    }
+    for (i = 0; i + 6 <= len; i++)
+    {
+        if ((!memcmp(&na[i], site, 6) || !memcmp(&na[i], rev, 6)) && (n++ == 0))
+            *first = i;
+    }
+    return(n);
+}
+
+/* writes the codons of a site of aa with the fewest changes to na, as HitEdits
+   counts them */
+static void RefWriteSite(const REFERENCE *ref, char *na, const char *aa, const OUTPUT *hit)
+{
+    int t, j, k, diff, best, pick = 0, start = 3 * hit->pos + hit->frame - 1, at;
+
+    for (t = 0; t < hit->number; t++)
+    {
+        for (j = 0, best = -1; j < 64; j++)
+        {
+            if (ref->aa[j] != aa[hit->pos + t])
+                continue;
+            for (k = 0, diff = 0; k < 3; k++)
+            {
+                at = 3 * (hit->pos + t) + k;
+                if ((at >= start) && (at < start + 6) &&
+                        (ref->codon[j][k] != ref->site[hit->re][at - start]))
+                    break;
+                diff += (ref->codon[j][k] != na[at]);
+            }
+            if ((k == 3) && ((best < 0) || (diff < best)))
+            {
+                best = diff;
+                pick = j;
+            }
+        }
+        memcpy(&na[3 * (hit->pos + t)], ref->codon[pick], 3);
+    }
+}
+
+static int CompareInt(const void *a, const void *b)
+{
+    return(*(const int *)a - *(const int *)b);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckDesign:    Compares the edits of the designs of DesignSites with     *
+*                   those of every combination of reference sites on codons   *
+*                   of their own, and checks that writing the sites of each   *
+*                   design into na changes no amino acid and as many bases    *
+*                   as it says.                                               *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckDesign(const DATABASE *db, const REFERENCE *ref, SEQGEN *g,
+                       const char *na, int len, REF_HITS *hits, FILE *log)
+{
+    static int total[DESIGNS];
+    DESIGN_SITE site[3];
+    DESIGN best[6];
+    char aa[MAX_NA_LEN / 3 + 1], edited[MAX_NA_LEN + 1], edited_aa[MAX_NA_LEN / 3 + 1];
+    int pick[3], start[3], cand[3][MAX_AA_LEN * 3], ncand[3], present[3], first[3];
+    int i, j, k, n, nsites, nbest, max_edits, e, ntotal = 0;
+
+    /* sites of the whole codons need all 64 codons to line up with na */
+    for (i = 0; i < 64; i++)
+    {
+        if (ref->aa[i] == 0)
+            return(0);
+    }
+    RefTranslate(ref, na, len, aa);
+    RefScan(ref, aa, na, len, hits);
+    if (hits->n == 0)
+        return(0);
+
+    /* enzymes that have sites, in random order */
+    nsites = 1 + (int)(SeqGenNext(g) % 3);
+    for (i = 0; i < nsites; i++)
+    {
+        site[i].re = hits->hit[SeqGenNext(g) % hits->n].re;
+        for (j = 0; (j < i) && (site[j].re != site[i].re); j++)
+            ;
+        if (j < i)
+        {
+            nsites = i;
+            break;
+        }
+        site[i].min_space = (int)(SeqGenNext(g) % 30);
+        site[i].max_space = site[i].min_space + (int)(SeqGenNext(g) % 120);
+    }
+
+    /* half the time, two enzymes with sites 6 to 8 bases apart, which share a
+       codon unless the first is in the first frame */
+    if (SeqGenNext(g) % 2)
+    {
+        k = (int)(SeqGenNext(g) % hits->n);
+        for (j = 0; j < hits->n; j++)
+        {
+            e = 3 * (hits->hit[j].pos - hits->hit[k].pos) + hits->hit[j].frame -
+                hits->hit[k].frame;
+            if ((hits->hit[j].re != hits->hit[k].re) && (e >= 6) && (e <= 8))
+                break;
+        }
+        if (j < hits->n)
+        {
+            nsites = 2;
+            site[0].re = hits->hit[k].re;
+            site[1].re = hits->hit[j].re;
+            site[1].min_space = 0;
+            site[1].max_space = 8 + (int)(SeqGenNext(g) % 120);
+        }
+    }
+    for (i = 0; i < nsites; i++)
+        present[i] = RefCount(ref->site[site[i].re], na, len, &first[i]);
+    max_edits = (int)(SeqGenNext(g) % 8) - 1;
+    nbest = 1 + (int)(SeqGenNext(g) % 6);
+
+    /* every combination of sites, each unique in the designed sequence: the
+       one already there, on either strand, or one made by edits (-1 - first) */
+    for (i = 0; i < nsites; i++)
+    {
+        ncand[i] = 0;
+        if (present[i] == 1)
+            cand[i][ncand[i]++] = -1 - first[i];
+        for (k = 0; (k < hits->n) && (present[i] == 0); k++)
+        {
+            if ((hits->hit[k].re == site[i].re) && (hits->edits[k] > 0))
+                cand[i][ncand[i]++] = k;
+        }
+        if (ncand[i] == 0)
+            break;
+        pick[i] = 0;
+    }
+    while (i == nsites)
+    {
+        for (j = 0, e = 0; j < nsites; j++)
+        {
+            k = cand[j][pick[j]];
+            start[j] = (k < 0) ? -1 - k : 3 * hits->hit[k].pos + hits->hit[k].frame - 1;
+            e += (k < 0) ? 0 : hits->edits[k];
+            if ((j > 0) && ((start[j] - start[j - 1] < site[j].min_space) ||
+                            (start[j] / 3 <= (start[j - 1] + 5) / 3) ||
+                            (start[j] - start[j - 1] > site[j].max_space)))
+                break;
+        }
+        if ((j == nsites) && ((max_edits < 0) || (e <= max_edits)) && (ntotal < DESIGNS))
+            total[ntotal++] = e;
+
+        for (j = nsites - 1; j >= 0; j--)
+        {
+            if (++pick[j] < ncand[j])
+                break;
+            pick[j] = 0;
+        }
+        if (j < 0)
+            break;
+    }
+    qsort(total, ntotal, sizeof(int), CompareInt);
+
+    n = DesignSites(db, na, site, nsites, max_edits, best, nbest);
+    if (n != ((ntotal < nbest) ? ntotal : nbest))
+    {
+        fprintf(log, "  DesignSites found %d designs of %d enzymes, reference %d\n",
+                n, nsites, ntotal);
+        return(1);
+    }
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0, e = 0; j < nsites; j++)
+        {
+            e += best[i].site_edits[j];
+            if ((j > 0) && ((best[i].start[j] - best[i].start[j - 1] < site[j].min_space) ||
+                            (best[i].start[j] - best[i].start[j - 1] > site[j].max_space)))
+                e = -1000;
+        }
+        if ((best[i].edits != total[i]) || (e != total[i]))
+        {
+            fprintf(log, "  design %d of %d enzymes needs %d edits (sites %d), reference"
+                    " %d\n", i, nsites, best[i].edits, e, total[i]);
+            return(1);
+        }
+
+        /* the sites written in, those already there left as they are */
+        strcpy(edited, na);
+        for (j = 0; j < nsites; j++)
+        {
+            if (best[i].site_edits[j] > 0)
+                RefWriteSite(ref, edited, aa, &best[i].hit[j]);
+        }
+        for (j = 0, e = 0; j < len; j++)
+            e += (edited[j] != na[j]);
+        RefTranslate(ref, edited, len, edited_aa);
+        if (strcmp(edited_aa, aa) || (e != best[i].edits))
+        {
+            fprintf(log, "  design %d of %d enzymes changes %d bases to %s, not %d to %s\n",
+                    i, nsites, e, edited_aa, best[i].edits, aa);
+            return(1);
+        }
+    }
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckSelect:    Keeps the enzymes a random name pattern matches with      *
+*                   SelectEnzymes and compares a scan of the pruned database  *
+*                   with the reference for those enzymes alone.  The          *
+*                   database is left pruned.                                  *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckSelect(DATABASE *db, const REFERENCE *ref, SEQGEN *g, const char *aa,
+                       REF_HITS *hits, FILE *log)
+{
+    static REFERENCE sub;
+    char pattern[8], name[16], keep[MAX_RE];
+    int i, errors = 0;
+    SCAN *scan;
+
+    /* Rnd<d>* is every enzyme whose number starts with d */
+    sprintf(pattern, "rND%d*", 1 + (int)(SeqGenNext(g) % 9));
+    sub = *ref;
+    sub.nre = 0;
+    for (i = 0; i < ref->nre; i++)
+    {
+        sprintf(name, "rnd%d", i + 1);
+        keep[i] = (name[3] == pattern[3]);
+        if (keep[i])
+            strcpy(sub.site[sub.nre++], ref->site[i]);
+        if (MatchEnzyme(db, i, pattern) != keep[i])
+        {
+            fprintf(log, "  MatchEnzyme of %s and %s gave %d\n", pattern,
+                    EnzymeName(db, i), !keep[i]);
+            errors++;
+        }
+    }
+    if ((SelectEnzymes(db, keep) != sub.nre) || ((scan = NewScan(db)) == NULL))
+    {
+        fprintf(log, "  SelectEnzymes did not keep the %d enzymes of %s\n", sub.nre,
+                pattern);
+        return(errors + 1);
+    }
+
+    RefScan(&sub, aa, NULL, 0, hits);
+    if (ScanForRE(scan, (char *)aa) != hits->n)
+    {
+        fprintf(log, "  ScanForRE found %d sites of %s, reference %d\n", NumHits(scan),
+                pattern, hits->n);
+        errors++;
+    }
+    for (i = 0; (i < hits->n) && (i < NumHits(scan)); i++)
+    {
+        if (!SameHit(GetHit(scan, i), &hits->hit[i]) ||
+                (fabs(HitScore(db, aa, GetHit(scan, i)) - hits->score[i]) > 1e-4))
+        {
+            fprintf(log, "  site %d of %s differs from the reference\n", i, pattern);
+            errors++;
+            break;
+        }
+    }
+    FreeScan(scan);
+    return(errors);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckRegion:    Writes a nucleic acid sequence as a FASTA record with     *
+*                   random line lengths and line ends, behind another         *
+*                   record, indexes the file and reads a random region back   *
+*                   through the index, often one ending in a partial codon,   *
+*                   then checks the table of its sites.                       *
+*                                                                             *
+*   Input:          fname. scratch file; fname.fai is removed afterwards.     *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckRegion(const DATABASE *db, const REFERENCE *ref, SCAN *scan, SEQGEN *g,
+                       const char *na, int len, const char *fname, REF_HITS *hits,
+                       FILE *log)
+{
+    char region[64], fai[64], *seq, *aa_str[16];
+    int i, n, width = 1 + (int)(SeqGenNext(g) % 70), first, last, errors = 0;
+    const char *eol = (SeqGenNext(g) & 1) ? "\r\n" : "\n";
+    long long start = -1;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "w")) == NULL)
+        return(1);
+    fprintf(fp, ">other%s%s%s>seq %d bases%s", eol, na, eol, len, eol);
+    for (i = 0; i < len; i += width)
+        fprintf(fp, "%.*s%s", width, &na[i], eol);
+    fclose(fp);
+
+    first = 1 + (int)(SeqGenNext(g) % len);
+    last = first + (int)(SeqGenNext(g) % (len + 8 - first));
+
+    /* often one that ends in a partial codon */
+    n = ((last > len) ? len : last) - first + 1;
+    if ((n % 3 == 0) && (n > 1) && (SeqGenNext(g) & 1))
+        last = first + n - 2;
+    sprintf(region, "seq:%d-%d", first, last);
+    if (IndexFasta(fname) < 0)
+    {
+        fprintf(log, "  IndexFasta failed on lines of %d bases\n", width);
+        return(1);
+    }
+    if (last > len)
+        last = len;
+    seq = FetchRegion(fname, region, &start);
+    if ((seq == NULL) || (start != first - 1) || ((int)strlen(seq) != last - first + 1) ||
+            strncmp(seq, &na[first - 1], last - first + 1))
+    {
+        fprintf(log, "  FetchRegion of %s with lines of %d bases gave %s\n", region, width,
+                seq ? seq : "nothing");
+        errors++;
+    }
+    else
+    {
+        /* its table lists each site once, at its first base in the record */
+        n = ConvertNAToAA(db, seq, aa_str, strlen(seq) % 3);
+        if (n > 0)
+            errors += CheckVariants(db, ref, scan, g, aa_str, n, start, hits, log);
+        for (i = 0; i < n; i++)
+            free(aa_str[i]);
+    }
+    free(seq);
+    sprintf(fai, "%s.fai", fname);
+    remove(fai);
+    return(errors);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckShard:     Writes pieces of a nucleic acid sequence as FASTA         *
+*                   records, reads the file back as a random number of        *
+*                   shards and checks that the shards give every record       *
+*                   once and in order, and that SeqSeek to the offset of a    *
+*                   record finds it.                                          *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckShard(SEQGEN *g, const char *na, int len, const char *fname, FILE *log)
+{
+    int start[SHARD_RECORDS + 1], i, k, n = 0, nshards = 1 + (int)(SeqGenNext(g) % 8);
+    long long offset[SHARD_RECORDS + 1];
+    char name[16], *seq;
+    SEQFILE *sf;
+    RECORD rec;
+    FILE *fp;
+
+    if ((fp = fopen(fname, "w")) == NULL)
+        return(1);
+    start[0] = 0;
+    offset[0] = 0;
+    for (i = 0; i < SHARD_RECORDS; i++)
+    {
+        start[i + 1] = start[i] + (int)(SeqGenNext(g) % (len - start[i] + 1));
+        offset[i + 1] = offset[i] + fprintf(fp, ">r%d\n%.*s\n", i, start[i + 1] - start[i],
+                                            &na[start[i]]);
+    }
+    fclose(fp);
+
+    memset(&rec, 0, sizeof(rec));
+    for (k = 0; k < nshards; k++)
+    {
+        if (((sf = OpenSeqFile(fname, 1)) == NULL) || (SeqShard(sf, k, nshards) < 0))
+        {
+            CloseSeqFile(sf);
+            FreeRecord(&rec);
+            return(1);
+        }
+        while ((ReadRecord(sf, &rec) > 0) && (n <= SHARD_RECORDS))
+        {
+            sprintf(name, "r%d", n);
+            seq = RecordSequence(&rec);
+            if ((n == SHARD_RECORDS) || strcmp(rec.name, name) || (seq == NULL) ||
+                    ((int)strcspn(seq, "\n") != start[n + 1] - start[n]) ||
+                    strncmp(seq, &na[start[n]], start[n + 1] - start[n]))
+            {
+                fprintf(log, "  shard %d of %d gave record %s, expected %s\n", k, nshards,
+                        rec.name, name);
+                n = SHARD_RECORDS + 1;
+            }
+            n++;
+        }
+        CloseSeqFile(sf);
+    }
+
+    i = (int)(SeqGenNext(g) % SHARD_RECORDS);
+    sprintf(name, "r%d", i);
+    if (((sf = OpenSeqFile(fname, 1)) == NULL) || (SeqSeek(sf, offset[i]) < 0) ||
+            (ReadRecord(sf, &rec) <= 0) || strcmp(rec.name, name) || (rec.offset != offset[i]))
+    {
+        fprintf(log, "  SeqSeek to %lld did not find record %s\n", offset[i], name);
+        n = SHARD_RECORDS + 1;
+    }
+    CloseSeqFile(sf);
+    FreeRecord(&rec);
+    if (n == SHARD_RECORDS)
+        return(0);
+    if (n < SHARD_RECORDS)
+        fprintf(log, "  %d shards gave %d of %d records\n", nshards, n, SHARD_RECORDS);
+    return(1);
+}
+
+#ifdef HAVE_ZLIB
+
+/* writes text as BGZF blocks of random sizes, then the EOF block */
+static int WriteBgzf(SEQGEN *g, const char *text, int len, FILE *fp)
+{
+    static const unsigned char eof[28] =
+    {
+        0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0, 3, 0,
+        0, 0, 0, 0, 0, 0, 0, 0
+    };
+    unsigned char hdr[18] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0 };
+    unsigned char out[256], tail[8];
+    unsigned long crc;
+    z_stream z;
+    int i, k, n, size;
+
+    for (i = 0; i < len; i += n)
+    {
+        n = 1 + (int)(SeqGenNext(g) % 64);
+        if (n > len - i)
+            n = len - i;
+        memset(&z, 0, sizeof(z));
+        if (deflateInit2(&z, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return(-1);
+        z.next_in = (unsigned char *)&text[i];
+        z.avail_in = n;
+        z.next_out = out;
+        z.avail_out = sizeof(out);
+        k = deflate(&z, Z_FINISH);
+        size = 18 + (int)z.total_out + 8;
+        deflateEnd(&z);
+        if (k != Z_STREAM_END)
+            return(-1);
+        crc = crc32(crc32(0L, Z_NULL, 0), (const unsigned char *)&text[i], n);
+        hdr[16] = (size - 1) & 0xff;
+        hdr[17] = (size - 1) >> 8;
+        for (k = 0; k < 4; k++)
+        {
+            tail[k] = (crc >> (8 * k)) & 0xff;
+            tail[4 + k] = (n >> (8 * k)) & 0xff;
+        }
+        fwrite(hdr, 1, 18, fp);
+        fwrite(out, 1, size - 26, fp);
+        fwrite(tail, 1, 8, fp);
+    }
+    fwrite(eof, 1, 28, fp);
+    return(0);
+}
+
+/* 0 if a file holds the GZ_RECORDS records of CheckCompressed and reads
+   without error, 1 if it reads with an error, -1 if neither */
+static int ReadBack(const char *fname, int nthreads, const char *na, int len)
+{
+    char name[16], *seq;
+    SEQFILE *sf;
+    RECORD rec;
+    int k = 0, same = 1, status;
+
+    if ((sf = OpenSeqFile(fname, nthreads)) == NULL)
+        return(1);
+    memset(&rec, 0, sizeof(rec));
+    while (ReadRecord(sf, &rec) > 0)
+    {
+        sprintf(name, "c%d", k++);
+        seq = RecordSequence(&rec);
+        if (strcmp(rec.name, name) || (seq == NULL) || ((int)strcspn(seq, "\n") != len) ||
+                strncmp(seq, na, len))
+            same = 0;
+    }
+    status = SeqError(sf) ? 1 : (same && (k == GZ_RECORDS)) ? 0 : -1;
+    CloseSeqFile(sf);
+    FreeRecord(&rec);
+    return(status);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckCompressed: Writes records as gzip and as BGZF, reads them back with *
+*                   one and two threads, then cuts each file short at a       *
+*                   random byte past the first header and checks that the     *
+*                   reader reports the error.                                 *
+*                                                                             *
+*   Input:          fname. scratch file.                                      *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckCompressed(SEQGEN *g, const char *na, int len, const char *fname,
+                           FILE *log)
+{
+    char text[GZ_RECORDS * (MAX_NA_LEN + 8)];
+    int i, k, n = 0, bgzf, errors = 0;
+    long size, cut;
+    gzFile gz;
+    FILE *fp;
+
+    for (i = 0; i < GZ_RECORDS; i++)
+        n += sprintf(&text[n], ">c%d\n%s\n", i, na);
+
+    for (bgzf = 0; bgzf <= 1; bgzf++)
+    {
+        if (bgzf)
+        {
+            if ((fp = fopen(fname, "wb")) == NULL)
+                return(1);
+            k = WriteBgzf(g, text, n, fp);
+            fclose(fp);
+        }
+        else if ((gz = gzopen(fname, "wb")) != NULL)
+            k = (gzwrite(gz, text, n) == n) ? gzclose(gz) : -1;
+        else
+            k = -1;
+        if ((k != 0) || ((fp = fopen(fname, "rb")) == NULL))
+            return(1);
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fclose(fp);
+
+        for (k = 1; k <= 2; k++)
+        {
+            if (ReadBack(fname, k, na, len) != 0)
+            {
+                fprintf(log, "  %s file of %ld bytes read with %d threads differs\n",
+                        bgzf ? "BGZF" : "gzip", size, k);
+                errors++;
+            }
+        }
+
+        /* a BGZF file is often cut between its last block and the EOF block */
+        cut = 18 + (long)(SeqGenNext(g) % (size - 18));
+        if (bgzf && (SeqGenNext(g) & 1))
+            cut = size - 28;
+        if (truncate(fname, cut) != 0)
+            return(errors + 1);
+        for (k = 1; k <= 2; k++)
+        {
+            if (ReadBack(fname, k, na, len) != 1)
+            {
+                fprintf(log, "  %s file cut to %ld of %ld bytes read with %d threads"
+                        " without an error\n", bgzf ? "BGZF" : "gzip", cut, size, k);
+                errors++;
+            }
+        }
+    }
+    return(errors);
+}
+
+#endif
+
+/******************************************************************************
+*                                                                             *
+*   CheckDensity:   Compares the track of PrintDensity, for a random window   *
+*                   and step, with the distinct enzymes of the ScanForRE      *
+*                   sites in each window counted one window at a time.        *
+*                                                                             *
+*   Input:          aa. translation of len bases, maybe with a partial last   *
+*                   codon.                                                    *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckDensity(const DATABASE *db, SCAN *scan, SEQGEN *g, int len, const char *aa,
+                        FILE *log)
+{
+    char whole[MAX_NA_LEN / 3 + 1], name[16], *out = NULL, *p;
+    int window = 1 + (int)(SeqGenNext(g) % 60), step = 1 + (int)(SeqGenNext(g) % 60);
+    int seen[MAX_RE], i, k, value, expect, start, errors = 0;
+    long long from, to;
+    size_t nout;
+    FILE *fp;
+
+    sprintf(whole, "%.*s", len / 3, aa);
+    ScanForRE(scan, whole);
+    if ((fp = open_memstream(&out, &nout)) == NULL)
+        return(1);
+    if (PrintDensity(db, whole, len, "seq x", window, step, 0, fp) < 0)
+        errors++;
+    fclose(fp);
+
+    p = out;
+    for (k = 0, start = 0; (start < len) && !errors; k++, start += step)
+    {
+        memset(seen, 0, sizeof(seen));
+        for (i = expect = 0; i < NumHits(scan); i++)
+        {
+            value = 3 * GetHit(scan, i)->pos + GetHit(scan, i)->frame - 1;
+            if ((value >= start) && (value < start + window) && !seen[GetHit(scan, i)->re]++)
+                expect++;
+        }
+        if ((sscanf(p, "%15s %lld %lld %d", name, &from, &to, &value) != 4) ||
+                strcmp(name, "seq") || (from != start) ||
+                (to != ((start + step < len) ? start + step : len)) || (value != expect))
+        {
+            fprintf(log, "  PrintDensity of %d bases, window %d step %d: row %d is %.*s,"
+                    " expected %d enzymes from %d\n", len, window, step, k,
+                    (int)strcspn(p, "\n"), p, expect, start);
+            errors++;
+        }
+        p += strcspn(p, "\n") + (*p != '\0');
+    }
+    if (!errors && (*p != '\0'))
+    {
+        fprintf(log, "  PrintDensity of %d bases gave rows after the end\n", len);
+        errors++;
+    }
+    free(out);
+    return(errors);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckConserved: Aligns a few variants of an amino acid sequence with      *
+*                   random gaps and compares the conserved sites of           *
+*                   AddAligned and PrintConserved, for a random share, with   *
+*                   the ScanForRE sites of each variant counted per column.   *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckConserved(const DATABASE *db, SCAN *scan, SEQGEN *g, const char *aa,
+                          int len, FILE *log)
+{
+    char row[MAX_AA_LEN + MAX_GAPS + 1], str[MAX_AA_LEN + 1], name[64], frame[4];
+    char *out = NULL, *p;
+    int ncols = len + (int)(SeqGenNext(g) % (MAX_GAPS + 1));
+    int nseq = 1 + (int)(SeqGenNext(g) % ALIGNED);
+    int col[MAX_AA_LEN], *count, nre = NumEnzymes(db), i, j, k, column, errors = 0;
+    double percent = (SeqGenNext(g) & 1) ? 100 : 1 + (int)(SeqGenNext(g) % 100);
+    long need, n;
+    size_t nout, bad;
+    CONSERVED *cs;
+    FILE *fp;
+
+    if ((count = calloc(3 * ncols * nre + 1, sizeof(int))) == NULL)
+        return(1);
+    if ((cs = NewConserved(db, percent)) == NULL)
+    {
+        free(count);
+        return(1);
+    }
+    for (i = 0; i < nseq; i++)
+    {
+        /* a variant, its residues in len of the columns in order */
+        RandomAA(g, str, len, ValidAminoAcids(db));
+        for (j = 0; j < len; j++)
+            if (SeqGenNext(g) % 8)
+                str[j] = aa[j];
+        memset(row, '-', ncols);
+        row[ncols] = '\0';
+        for (j = 0, k = 0; j < ncols; j++)
+        {
+            if ((k < len) && ((int)(SeqGenNext(g) % (ncols - j)) < len - k))
+            {
+                col[k] = j;
+                row[j] = str[k++];
+            }
+        }
+        if (AddAligned(cs, row, 1, &bad) != 1)
+        {
+            fprintf(log, "  AddAligned rejected %s\n", row);
+            errors++;
+        }
+        ScanForRE(scan, str);
+        for (j = 0; j < NumHits(scan); j++)
+            count[(3 * col[GetHit(scan, j)->pos] + GetHit(scan, j)->frame - 1) * nre +
+                  GetHit(scan, j)->re]++;
+    }
+
+    if ((fp = open_memstream(&out, &nout)) == NULL)
+        errors++;
+    else
+    {
+        PrintConserved(cs, fp);
+        fclose(fp);
+    }
+    need = (long)(percent * nseq / 100);
+    if (need * 100.0 < percent * nseq)
+        need++;
+
+    p = out ? out + strcspn(out, "\n") + 1 : NULL;
+    for (i = 0; (i < 3 * ncols * nre) && !errors; i++)
+    {
+        if ((count[i] == 0) || (count[i] < need))
+            continue;
+        if ((sscanf(p, "%d %3s %63s %*s %ld", &column, frame, name, &n) != 4) ||
+                (column != i / nre / 3 + 1) || (atoi(frame) != i / nre % 3 + 1) ||
+                strcmp(name, EnzymeName(db, i % nre)) || (n != count[i]))
+        {
+            fprintf(log, "  PrintConserved of %d sequences at %.0f%% gave %.*s, expected"
+                    " %d sequences with %s in column %d frame %d\n", nseq, percent,
+                    (int)strcspn(p, "\n"), p, count[i], EnzymeName(db, i % nre),
+                    i / nre / 3 + 1, i / nre % 3 + 1);
+            errors++;
+        }
+        p += strcspn(p, "\n") + (*p != '\0');
+    }
+    if (!errors && (*p != '\0'))
+    {
+        fprintf(log, "  PrintConserved of %d sequences at %.0f%% gave more sites: %.*s\n",
+                nseq, percent, (int)strcspn(p, "\n"), p);
+        errors++;
+    }
+    free(out);
+    free(count);
+    FreeConserved(cs);
+    return(errors);
+}
+
+static void *QueueProducer(void *arg)
+{
+    QUEUE *q = (QUEUE *)arg;
+    long i;
+
+    for (i = 1; i <= QUEUE_ITEMS; i++)
+        QueuePush(q, (void *)i);
+    return(NULL);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckQueue:     Passes numbers from one thread to another through a       *
+*                   small QUEUE and checks that they all arrive in order.     *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckQueue(FILE *log)
+{
+    QUEUE *q;
+    pthread_t producer;
+    long i;
+    int errors = 0;
+
+    if ((q = NewQueue(3)) == NULL)
+        return(1);
+    if (pthread_create(&producer, NULL, QueueProducer, q) != 0)
+    {
+        FreeQueue(q);
+        return(1);
+    }
+    for (i = 1; i <= QUEUE_ITEMS; i++)
+    {
+        if ((long)QueuePop(q) != i)
+            errors++;
+    }
+    pthread_join(producer, NULL);
+    FreeQueue(q);
+    if (errors)
+        fprintf(log, "  %d items came out of the QUEUE out of order\n", errors);
+    return(errors);
+}
+
+/******************************************************************************
+*                                                                             *
+*   VerifyEngine:   Runs the differential check on random cases.              *
+*                                                                             *
+*   Input:          aa_fname. codon table (dbase1).                           *
+*                   seed. seed of the first case; case i uses seed + i, so a  *
+*                   failing case can be repeated alone.                       *
+*                   ncases. number of cases.                                  *
+*                   log. where to describe the failures.                      *
+*                                                                             *
+*   Output:         number of failing cases, -1 if the check cannot run.      *
+*                                                                             *
+******************************************************************************/
+
+/* 1 if the six bases at na are the site of enzyme j on either strand */
+static int RefMatch(const REFERENCE *ref, int j, const char *na)
+{
+    char rev[7];
+    int k;
+
+    for (k = 0; k < 6; k++)
+        rev[k] = base[3 - (strchr(base, ref->site[j][5 - k]) - base)];
+    rev[6] = '\0';
+    return(!strncmp(na, ref->site[j], 6) || !strncmp(na, rev, 6));
+}
+
+/* orders sites by kind, position and enzyme, and differences as DiffSites */
+static int CompareSite(const void *a, const void *b)
+{
+    const DIFF *x = a, *y = b;
+
+    if (x->change != y->change)
+        return(x->change - y->change);
+    if (x->kind != y->kind)
+        return(x->kind - y->kind);
+    if (x->pos != y->pos)
+        return(x->pos < y->pos ? -1 : 1);
+    return(x->re - y->re);
+}
+
+static int CompareDiff(const void *a, const void *b)
+{
+    const DIFF *x = a, *y = b;
+
+    if (x->pos != y->pos)
+        return(x->pos < y->pos ? -1 : 1);
+    return(CompareSite(a, b));
+}
+
+/******************************************************************************
+*                                                                             *
+*   RefSites:       Every site of a nucleic acid sequence, the recognition    *
+*                   sequences looked for on both strands at every base and    *
+*                   the ScanForRE sites of its whole codons.                  *
+*                                                                             *
+*   Output:         the number of sites, sorted by CompareSite.               *
+*                                                                             *
+******************************************************************************/
+
+static int RefSites(const REFERENCE *ref, SCAN *scan, const char *na, DIFF *site)
+{
+    char aa[MAX_NA_LEN / 3 + 8];
+    int len = strlen(na), i, j, n = 0;
+
+    for (j = 0; j < ref->nre; j++)
+    {
+        for (i = 0; i + 6 <= len; i++)
+        {
+            if (!RefMatch(ref, j, &na[i]))
+                continue;
+            site[n].change = 0;
+            site[n].kind = DIFF_SITE;
+            site[n].pos = i;
+            site[n++].re = j;
+        }
+    }
+    RefTranslate(ref, na, len - len % 3, aa);
+    ScanForRE(scan, aa);
+    for (i = 0; i < NumHits(scan); i++)
+    {
+        site[n].change = 0;
+        site[n].kind = DIFF_SILENT;
+        site[n].pos = 3 * GetHit(scan, i)->pos + GetHit(scan, i)->frame - 1;
+        site[n++].re = GetHit(scan, i)->re;
+    }
+    qsort(site, n, sizeof(DIFF), CompareSite);
+    return(n);
+}
+
+/* edits the len bases of mut by k substitutions in [at, at + span), or an
+   insertion or deletion of k bases at at; gives the new length */
+static int EditNA(SEQGEN *g, char *mut, int len, int how, int at, int span, int k)
+{
+    char c = mut[at];
+    int i;
+
+    switch (how)
+    {
+    case 0:
+        for (i = 0; (i < k) && (span > 0); i++)
+            mut[at + SeqGenNext(g) % span] = base[SeqGenNext(g) % 4];
+        break;
+    case 1:
+        memmove(&mut[at + k], &mut[at], len - at + 1);
+        RandomNA(g, &mut[at], k, 0.5);
+        mut[at + k] = c;
+        break;
+    default:
+        if (at + k > len)
+            k = len - at;
+        memmove(&mut[at], &mut[at + k], len - at - k + 1);
+    }
+    return((int)strlen(mut));
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckDiff:      Edits a nucleic acid sequence by a few substitutions, an  *
+*                   insertion or deletion, or substitutions in one half and   *
+*                   an insertion or deletion in the other, and compares       *
+*                   DiffSites with the sites of both versions found in full,  *
+*                   matched through the common start and end of each half.    *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckDiff(const DATABASE *db, const REFERENCE *ref, SCAN *scan, SEQGEN *g,
+                     const char *na, int len, FILE *log)
+{
+    char mut[MAX_NA_LEN + 16];
+    int i, k, at, na_n, mut_n, nexpect = 0, lb, errors = 0, how, half, shift, h;
+    int end[2], mut_end[2], pre[2], suf[2];
+    long n;
+    DIFF *a, *b, *expect, *diff, key;
+    SITE_TABLE *t;
+
+    /* substitutions, or an insertion or deletion of up to 6 bases, or both in
+       halves far enough apart to be aligned on their own */
+    strcpy(mut, na);
+    at = len ? (int)(SeqGenNext(g) % len) : 0;
+    k = 1 + (int)(SeqGenNext(g) % 6);
+    how = (int)(SeqGenNext(g) % 4);
+    half = 0;
+    shift = 0;
+    if ((how < 3) || (len < 120))
+        lb = EditNA(g, mut, len, how % 3, (how % 3) ? at : 0, len, k);
+    else
+    {
+        /* the second half first, so the first keeps its bases */
+        half = len / 2;
+        how = (int)(SeqGenNext(g) % 2);
+        at = half + 40 + (int)(SeqGenNext(g) % (len - half - 40));
+        lb = EditNA(g, mut, len, how ? 0 : 1 + (int)(SeqGenNext(g) % 2), at,
+                    (len - at < 6) ? len - at : 6, k);
+        at = (int)(SeqGenNext(g) % (half - 46));
+        shift = lb;
+        lb = EditNA(g, mut, lb, how ? 1 + (int)(SeqGenNext(g) % 2) : 0, at, 6,
+                    1 + (int)(SeqGenNext(g) % 6));
+        shift = lb - shift;
+    }
+
+    /* the common start and end of each half, the second of mut starting after
+       the change of length in the first */
+    end[0] = half;
+    end[1] = len;
+    mut_end[0] = half + shift;
+    mut_end[1] = lb;
+    for (h = 0; h < 2; h++)
+    {
+        i = h ? end[0] : 0;
+        at = h ? mut_end[0] : 0;
+        for (pre[h] = 0; (i + pre[h] < end[h]) && (at + pre[h] < mut_end[h]) &&
+                (na[i + pre[h]] == mut[at + pre[h]]); pre[h]++)
+            ;
+        for (suf[h] = 0; (pre[h] + suf[h] < end[h] - i) &&
+                (pre[h] + suf[h] < mut_end[h] - at) &&
+                (na[end[h] - 1 - suf[h]] == mut[mut_end[h] - 1 - suf[h]]); suf[h]++)
+            ;
+    }
+
+    a = malloc(2 * (MAX_NA_LEN + 16) * MAX_RE * sizeof(DIFF));
+    b = malloc(2 * (MAX_NA_LEN + 16) * MAX_RE * sizeof(DIFF));
+    expect = malloc(4 * (MAX_NA_LEN + 16) * MAX_RE * sizeof(DIFF));
+    if ((a == NULL) || (b == NULL) || (expect == NULL) || ((t = NewSiteTable(db)) == NULL))
+    {
+        free(a);
+        free(b);
+        free(expect);
+        return(1);
+    }
+    na_n = RefSites(ref, scan, na, a);
+    mut_n = RefSites(ref, scan, mut, b);
+
+    /* map the sites of na onto mut: those not there are lost */
+    for (i = 0; i < na_n; i++)
+    {
+        key = a[i];
+        h = (key.pos >= end[0]);
+        at = h ? end[0] : 0;
+        k = (h ? mut_end[0] : 0) - at;
+        if (end[h] - at == mut_end[h] - at - k)
+            key.pos += k;
+        else if (key.pos >= end[h] - suf[h])
+            key.pos += mut_end[h] - end[h];
+        else if (key.pos >= at + pre[h])
+            key.pos = -1;
+        else
+            key.pos += k;
+        if ((key.pos < 0) || !bsearch(&key, b, mut_n, sizeof(DIFF), CompareSite))
+        {
+            expect[nexpect] = a[i];
+            expect[nexpect++].change = -1;
+        }
+        a[i].pos = key.pos;
+    }
+    qsort(a, na_n, sizeof(DIFF), CompareSite);
+    for (i = 0; i < mut_n; i++)
+    {
+        if (!bsearch(&b[i], a, na_n, sizeof(DIFF), CompareSite))
+        {
+            expect[nexpect] = b[i];
+            expect[nexpect++].change = 1;
+        }
+    }
+    qsort(expect, nexpect, sizeof(DIFF), CompareDiff);
+
+    if ((n = DiffSites(db, t, na, mut, &diff)) < 0)
+        errors++;
+    for (i = 0; (i < n) && (i < nexpect) && !errors; i++)
+    {
+        if (CompareDiff(&diff[i], &expect[i]))
+        {
+            fprintf(log, "  DiffSites of %s and %s: difference %d is %+d %d %ld %s,"
+                    " expected %+d %d %ld %s\n", na, mut, i, diff[i].change, diff[i].kind,
+                    diff[i].pos, EnzymeName(db, diff[i].re), expect[i].change,
+                    expect[i].kind, expect[i].pos, EnzymeName(db, expect[i].re));
+            errors++;
+        }
+    }
+    if (!errors && (n != nexpect))
+    {
+        fprintf(log, "  DiffSites of %s and %s gave %ld differences, expected %d\n", na,
+                mut, n, nexpect);
+        errors++;
+    }
+    if (n >= 0)
+        free(diff);
+    FreeSiteTable(t);
+    free(a);
+    free(b);
+    free(expect);
+    return(errors);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckSaturation: Compares SnvSites and the rows of PrintSaturation for    *
+*                   every substitution of a nucleic acid sequence with the    *
+*                   recognition sequences looked for in the six-mers around   *
+*                   the base before and after it is changed.                  *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckSaturation(const DATABASE *db, const REFERENCE *ref, const char *na,
+                           int len, FILE *log)
+{
+    char mut[MAX_NA_LEN + 1], expect[4 * MAX_RE * 16], *out = NULL, *p, *q;
+    int pos, alt, j, s, c, before, after, codon, aa, mut_aa, errors = 0;
+    int created[MAX_RE], destroyed[MAX_RE];
+    uint64_t cbits[(MAX_RE + 63) / 64], dbits[(MAX_RE + 63) / 64];
+    size_t nout;
+    SITE_TABLE *t;
+    FILE *fp;
+
+    if ((t = NewSiteTable(db)) == NULL)
+        return(1);
+    if ((fp = open_memstream(&out, &nout)) == NULL)
+    {
+        FreeSiteTable(t);
+        return(1);
+    }
+    PrintSaturation(db, t, na, "seq x", fp);
+    fclose(fp);
+
+    p = out;
+    for (pos = 0; (pos < len) && !errors; pos++)
+    {
+        for (alt = 0; (alt < 4) && !errors; alt++)
+        {
+            if (base[alt] == na[pos])
+                continue;
+            strcpy(mut, na);
+            mut[pos] = base[alt];
+            memset(created, 0, sizeof(created));
+            memset(destroyed, 0, sizeof(destroyed));
+            for (s = pos - 5; s <= pos; s++)
+            {
+                for (j = 0; (s >= 0) && (s + 6 <= len) && (j < ref->nre); j++)
+                {
+                    before = RefMatch(ref, j, &na[s]);
+                    after = RefMatch(ref, j, &mut[s]);
+                    created[j] |= after && !before;
+                    destroyed[j] |= before && !after;
+                }
+            }
+
+            SnvSites(t, na, len, pos, base[alt], cbits, dbits);
+            for (j = 0; j < ref->nre; j++)
+            {
+                if ((int)((cbits[j / 64] >> (j % 64)) & 1) != created[j] ||
+                        (int)((dbits[j / 64] >> (j % 64)) & 1) != destroyed[j])
+                {
+                    fprintf(log, "  SnvSites of %c at %d of %s: %s created %d destroyed %d,"
+                            " expected %d %d\n", base[alt], pos, na, EnzymeName(db, j),
+                            (int)((cbits[j / 64] >> (j % 64)) & 1),
+                            (int)((dbits[j / 64] >> (j % 64)) & 1), created[j],
+                            destroyed[j]);
+                    errors++;
+                    break;
+                }
+            }
+
+            /* the row PrintSaturation should have written */
+            for (j = 0, c = 0; j < ref->nre; j++)
+                c |= created[j] | destroyed[j];
+            if (!c || errors)
+                continue;
+            aa = mut_aa = 0;
+            if (pos - pos % 3 + 3 <= len)
+            {
+                for (codon = 0; strncmp(ref->codon[codon], &na[pos - pos % 3], 3); codon++)
+                    ;
+                aa = ref->aa[codon];
+                for (codon = 0; strncmp(ref->codon[codon], &mut[pos - pos % 3], 3); codon++)
+                    ;
+                mut_aa = ref->aa[codon];
+            }
+            c = sprintf(expect, "seq\t%d\t%c\t%c\t%c\t%c\t%s\t", pos + 1, na[pos],
+                        base[alt], aa ? aa : '-', mut_aa ? mut_aa : '-',
+                        (!aa || !mut_aa) ? "-" : (aa == mut_aa) ? "yes" : "no");
+            for (s = 0; s < 2; s++)
+            {
+                q = &expect[c];
+                for (j = 0; j < ref->nre; j++)
+                    if (s ? destroyed[j] : created[j])
+                        c += sprintf(&expect[c], "%s%s", (&expect[c] == q) ? "" : ",",
+                                     EnzymeName(db, j));
+                if (&expect[c] == q)
+                    c += sprintf(&expect[c], "-");
+                c += sprintf(&expect[c], s ? "\n" : "\t");
+            }
+            if (strncmp(p, expect, c))
+            {
+                fprintf(log, "  PrintSaturation of %s gave %.*s, expected %s", na,
+                        (int)strcspn(p, "\n"), p, expect);
+                errors++;
+            }
+            p += strcspn(p, "\n") + (*p != '\0');
+        }
+    }
+    if (!errors && (*p != '\0'))
+    {
+        fprintf(log, "  PrintSaturation of %s gave more rows: %.*s\n", na,
+                (int)strcspn(p, "\n"), p);
+        errors++;
+    }
+    free(out);
+    FreeSiteTable(t);
+    return(errors);
+}
+
+/* 1 if a six-mer of mut starting in [from, to) has an enzyme that of old has not */
+static int RefCreates(const REFERENCE *ref, const char *old, const char *mut, int from,
+                      int to)
+{
+    int w, j;
+
+    for (w = from; w < to; w++)
+        for (j = 0; j < ref->nre; j++)
+            if (RefMatch(ref, j, &mut[w]) && !RefMatch(ref, j, &old[w]))
+                return(1);
+    return(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*   RefRemove:      The fewest base changes, by synonymous codons of the      *
+*                   reference table, that leave no site at base s of na and   *
+*                   create none; every choice for the whole codons under it   *
+*                   is tried.                                                 *
+*                                                                             *
+*   Output:         the number of changes, or -1 if no choice will do.        *
+*                                                                             *
+******************************************************************************/
+
+static int RefRemove(const REFERENCE *ref, const char *na, int len, int s)
+{
+    char buf[MAX_NA_LEN + 1];
+    int syn[3][64], nsyn[3], pick[3], c0 = s / 3, c1 = (s + 5) / 3, i, j, k, code;
+    int edits, min = -1, from, to;
+
+    if (c1 >= len / 3)
+        c1 = len / 3 - 1;
+    for (i = 0; i <= c1 - c0; i++)
+    {
+        for (code = 0; strncmp(ref->codon[code], &na[3 * (c0 + i)], 3); code++)
+            ;
+        for (j = 0, nsyn[i] = 0; j < 64; j++)
+            if ((j == code) || (ref->aa[code] && (ref->aa[j] == ref->aa[code])))
+                syn[i][nsyn[i]++] = j;
+        pick[i] = 0;
+    }
+    from = (3 * c0 - 5 < 0) ? 0 : 3 * c0 - 5;
+    to = (3 * c1 + 3 < len - 5) ? 3 * c1 + 3 : len - 5;
+    while (c0 <= c1)
+    {
+        strcpy(buf, na);
+        for (i = 0, edits = 0; i <= c1 - c0; i++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                buf[3 * (c0 + i) + k] = ref->codon[syn[i][pick[i]]][k];
+                edits += (buf[3 * (c0 + i) + k] != na[3 * (c0 + i) + k]);
+            }
+        }
+        for (j = 0; (j < ref->nre) && !RefMatch(ref, j, &buf[s]); j++)
+            ;
+        if ((edits > 0) && ((min < 0) || (edits < min)) && (j == ref->nre) &&
+                !RefCreates(ref, na, buf, from, to))
+            min = edits;
+        for (i = 0; (i <= c1 - c0) && (++pick[i] == nsyn[i]); i++)
+            pick[i] = 0;
+        if (i > c1 - c0)
+            break;
+    }
+    return(min);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckDomesticate: Removes the sites of a nucleic acid sequence with       *
+*                   Domesticate and checks that the translation is the same,  *
+*                   that every site is listed and is gone unless said to be   *
+*                   kept, that no site is created, and that the first site    *
+*                   took as few changes as RefRemove finds.                   *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckDomesticate(const DATABASE *db, const REFERENCE *ref, const char *na,
+                            int len, FILE *log)
+{
+    char ed[MAX_NA_LEN + 1], aa[MAX_NA_LEN / 3 + 1], expect[MAX_NA_LEN / 3 + 1];
+    int s, j, k = 0, errors = 0;
+    long n;
+    DOMESTIC *site;
+    SITE_TABLE *t;
+
+    if ((t = NewSiteTable(db)) == NULL)
+        return(1);
+    strcpy(ed, na);
+    if ((n = Domesticate(db, t, ed, &site)) < 0)
+    {
+        FreeSiteTable(t);
+        return(1);
+    }
+    RefTranslate(ref, na, len - len % 3, expect);
+    RefTranslate(ref, ed, len - len % 3, aa);
+    if (strcmp(aa, expect) || strcmp(&ed[len - len % 3], &na[len - len % 3]))
+    {
+        fprintf(log, "  Domesticate changed the protein of %s: %s\n", na, ed);
+        errors++;
+    }
+    for (s = 0; (s + 6 <= len) && !errors; s++)
+    {
+        for (j = 0; (j < ref->nre) && !errors; j++)
+        {
+            if (RefMatch(ref, j, &ed[s]) && !RefMatch(ref, j, &na[s]))
+            {
+                fprintf(log, "  Domesticate of %s created a %s site at %d: %s\n", na,
+                        EnzymeName(db, j), s, ed);
+                errors++;
+            }
+            if (!RefMatch(ref, j, &na[s]))
+                continue;
+            if ((k >= n) || (site[k].pos != s) || (site[k].re != j) ||
+                    ((site[k].edits < 0) != RefMatch(ref, j, &ed[s])))
+            {
+                fprintf(log, "  Domesticate of %s to %s: site %d is wrong, expected %s at"
+                        " %d\n", na, ed, k, EnzymeName(db, j), s);
+                errors++;
+            }
+            k++;
+        }
+    }
+    if (!errors && (k != n))
+    {
+        fprintf(log, "  Domesticate of %s listed %ld sites, expected %d\n", na, n, k);
+        errors++;
+    }
+    if (!errors && (n > 0) && (site[0].edits != RefRemove(ref, na, len, (int)site[0].pos)))
+    {
+        fprintf(log, "  Domesticate of %s took %d changes for the site at %ld, expected"
+                " %d\n", na, site[0].edits, site[0].pos, RefRemove(ref, na, len,
+                                                                  (int)site[0].pos));
+        errors++;
+    }
+    free(site);
+    FreeSiteTable(t);
+    return(errors);
+}
+
+/* amino acid of a codon by the reference table, 0 if none */
+static int RefCodon(const REFERENCE *ref, const char *na)
+{
+    int j;
+
+    for (j = 0; j < 64; j++)
+        if (!strncmp(ref->codon[j], na, 3))
+            return(ref->aa[j]);
+    return(0);
+}
+
+/* reads the rest of a stream into a string; the caller frees it */
+static char *ReadAll(FILE *fp, long *size)
+{
+    char *buf, *p;
+    long cap = 4096;
+    size_t n;
+
+    *size = 0;
+    if ((buf = malloc(cap + 1)) == NULL)
+        return(NULL);
+    while ((n = fread(&buf[*size], 1, cap - *size, fp)) > 0)
+    {
+        *size += n;
+        if (*size < cap)
+            continue;
+        if ((p = realloc(buf, 2 * cap + 1)) == NULL)
+        {
+            free(buf);
+            return(NULL);
+        }
+        buf = p;
+        cap *= 2;
+    }
+    buf[*size] = '\0';
+    return(buf);
+}
+
+/* decodes a dump of hex words in place; -1 if it is not one */
+static long Unhex(char *buf, long size)
+{
+    long i, n = 0;
+    int high = -1, d;
+
+    for (i = 0; i < size; i++)
+    {
+        if (isspace((unsigned char)buf[i]))
+            continue;
+        if (!isxdigit((unsigned char)buf[i]))
+            return(-1);
+        d = isdigit((unsigned char)buf[i]) ? buf[i] - '0' : tolower(buf[i]) - 'a' + 10;
+        if (high < 0)
+            high = d;
+        else
+        {
+            buf[n++] = (char)(16 * high + d);
+            high = -1;
+        }
+    }
+    return(n);
+}
+
+/* drops the carriage returns, and the " (GGGCCC)" after an enzyme name at the
+   end of a line */
+static long Normalize(char *buf, long size)
+{
+    long i, k, n = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        if (buf[i] == '\r')
+            continue;
+        if ((buf[i] == ' ') && (i + 1 < size) && (buf[i + 1] == '('))
+        {
+            for (k = i + 2; (k < size) && isupper((unsigned char)buf[k]); k++)
+                ;
+            if ((k > i + 2) && (k + 1 < size) && (buf[k] == ')') &&
+                    ((buf[k + 1] == '\n') || (buf[k + 1] == '\r')))
+            {
+                i = k;
+                continue;
+            }
+        }
+        buf[n++] = buf[i];
+    }
+    return(n);
+}
+
+/* runs the menu input of silmut: 1 and an amino acid sequence, 2 and a
+   nucleic acid one, ..., 3 */
+static void RunMenu(const DATABASE *db, SCAN *scan, FILE *in, FILE *fp)
+{
+    char line[1024], seq[1024], *aa_str[16];
+    int i, n, opt;
+
+    while ((fgets(line, sizeof(line), in) != NULL) && ((opt = atoi(line)) != 3))
+    {
+        if (((opt != 1) && (opt != 2)) || (fgets(seq, sizeof(seq), in) == NULL))
+            continue;
+        seq[strcspn(seq, "\r\n")] = '\0';
+        if (!Check_Input(db, seq, opt))
+            continue;
+        aa_str[0] = seq;
+        n = (opt == 1) ? 1 : ConvertNAToAA(db, seq, aa_str, strlen(seq) % 3);
+        for (i = 0; i < n; i++)
+        {
+            if (!Duplicate(aa_str, i) && (ScanForRE(scan, aa_str[i]) >= 0))
+                PrintResult(scan, aa_str[i], fp);
+        }
+        for (i = 0; (opt == 2) && (i < n); i++)
+            free(aa_str[i]);
+    }
+}
+
+/******************************************************************************
+*                                                                             *
+*   VerifyGolden:   Runs the menu input of the example shipped with SILMUT    *
+*                   through the library and compares the result with the      *
+*                   output shipped with it.                                   *
+*                                                                             *
+*   Input:          in_fname, out_fname. the example, e.g. GPGR.IN and        *
+*                   GPGR.OUT.                                                 *
+*                                                                             *
+*   Output:         0 if the outputs agree, 1 if they differ, -1 if a file    *
+*                   cannot be read.                                           *
+*                                                                             *
+*   Notes:          GPGR.OUT is a hex dump of what a DOS build of an older    *
+*                   version printed, so it is decoded first.  Line ends are   *
+*                   made "\n", and as that version did not print the          *
+*                   recognition sequence after the enzyme names, " (GGGCCC)"  *
+*                   at the end of a line is dropped from both outputs.        *
+*                                                                             *
+******************************************************************************/
+
+int VerifyGolden(const char *aa_fname, const char *re_fname, const char *in_fname,
+                 const char *out_fname, FILE *log)
+{
+    char *got = NULL, *want = NULL;
+    long got_len = 0, want_len = 0, k;
+    int status = -1;
+    DATABASE *db;
+    SCAN *scan = NULL;
+    FILE *in = NULL, *out = NULL, *fp = NULL;
+
+    if ((db = LoadDataBase(aa_fname, re_fname, NULL)) == NULL)
+        return(-1);
+    if (((in = fopen(in_fname, "r")) != NULL) && ((out = fopen(out_fname, "rb")) != NULL) &&
+            ((fp = tmpfile()) != NULL) && ((scan = NewScan(db)) != NULL))
+    {
+        RunMenu(db, scan, in, fp);
+        rewind(fp);
+        got = ReadAll(fp, &got_len);
+        want = ReadAll(out, &want_len);
+    }
+    if ((got != NULL) && (want != NULL) && ((want_len = Unhex(want, want_len)) >= 0))
+    {
+        got_len = Normalize(got, got_len);
+        want_len = Normalize(want, want_len);
+        for (k = 0; (k < got_len) && (k < want_len) && (got[k] == want[k]); k++)
+            ;
+        status = ((k == got_len) && (k == want_len)) ? 0 : 1;
+        if (status)
+            fprintf(log, "the output of %s differs from %s at byte %ld of %ld\n",
+                    in_fname, out_fname, k, want_len);
+    }
+    else
+        fprintf(log, "cannot read %s and %s\n", in_fname, out_fname);
+
+    free(got);
+    free(want);
+    FreeScan(scan);
+    FreeDataBase(db);
+    if (in != NULL)
+        fclose(in);
+    if (out != NULL)
+        fclose(out);
+    if (fp != NULL)
+        fclose(fp);
+    return(status);
+}
+
+/******************************************************************************
+*                                                                             *
+*   CheckOrfs:      Compares FindOrfs with the ORFs of each start codon that  *
+*                   is the first since the last stop in its frame, looked     *
+*                   for on the forward strand and its reverse complement.     *
+*                   Then checks the protein of each ORF against RefTranslate  *
+*                   and that PrintOrfSites gives every site of it within the  *
+*                   bases of its codons.                                      *
+*                                                                             *
+*   Output:         the number of errors.                                     *
+*                                                                             *
+******************************************************************************/
+
+static int CheckOrfs(const DATABASE *db, const REFERENCE *ref, SCAN *scan, SEQGEN *g,
+                     const char *na, int len, FILE *log)
+{
+    char strand[2][MAX_NA_LEN + 1], aa[MAX_NA_LEN / 3 + 1], expect[MAX_NA_LEN / 3 + 1];
+    char *out = NULL, *p, orf_str[32], sign;
+    int min = 1 + (int)(SeqGenNext(g) % 12), s, i, j, k, first, nexpect = 0, errors = 0;
+    long n, from, to, pos;
+    ORF want[MAX_NA_LEN], *orf, key;
+    size_t nout;
+    FILE *fp;
+
+    strcpy(strand[0], na);
+    for (i = 0; i < len; i++)
+        strand[1][i] = base[3 - (strchr(base, na[len - 1 - i]) - base)];
+    strand[1][len] = '\0';
+    for (s = 0; s < 2; s++)
+    {
+        for (i = 0; i + 3 <= len; i++)
+        {
+            if (RefCodon(ref, &strand[s][i]) != 'M')
+                continue;
+            for (j = i - 3, first = 1; (j >= 0) && first; j -= 3)
+            {
+                k = RefCodon(ref, &strand[s][j]);
+                if ((k == 'X') || (k == 0))
+                    break;
+                first = (k != 'M');
+            }
+            for (j = i; j + 3 <= len; j += 3)
+            {
+                k = RefCodon(ref, &strand[s][j]);
+                if ((k == 'X') || (k == 0))
+                    break;
+            }
+            if (!first || (j + 3 > len) || ((j - i) / 3 < min))
+                continue;
+            want[nexpect].start = s ? len - j - 3 : i;
+            want[nexpect].end = s ? len - i : j + 3;
+            want[nexpect++].strand = s ? -1 : 1;
+        }
+    }
+
+    if ((n = FindOrfs(db, na, min, &orf)) < 0)
+        return(1);
+    for (k = 0; (k < n) && !errors; k++)
+    {
+        for (i = 0; i < nexpect; i++)
+            if ((want[i].start == orf[k].start) && (want[i].end == orf[k].end) &&
+                    (want[i].strand == orf[k].strand))
+                break;
+        if ((i == nexpect) || ((k > 0) && (orf[k].start < orf[k - 1].start)))
+        {
+            fprintf(log, "  FindOrfs of %s, at least %d codons: %ld-%ld on %d is wrong\n",
+                    na, min, orf[k].start, orf[k].end, orf[k].strand);
+            errors++;
+            break;
+        }
+
+        /* its protein and where its sites are said to be */
+        key = orf[k];
+        from = (key.strand > 0) ? key.start : len - key.end;
+        RefTranslate(ref, &strand[key.strand < 0][from], (int)(key.end - key.start - 3),
+                     expect);
+        if ((OrfProtein(db, na, &key, aa) != (int)strlen(expect)) || strcmp(aa, expect))
+        {
+            fprintf(log, "  OrfProtein of %ld-%ld on %d of %s gave %s, expected %s\n",
+                    key.start, key.end, key.strand, na, aa, expect);
+            errors++;
+            break;
+        }
+        ScanForRE(scan, aa);
+        if ((fp = open_memstream(&out, &nout)) == NULL)
+        {
+            errors++;
+            break;
+        }
+        PrintOrfSites(db, scan, aa, &key, "seq x", fp);
+        fclose(fp);
+        for (i = 0, p = out; (i < NumHits(scan)) && !errors; i++)
+        {
+            /* the codons of the motif, on the forward strand */
+            j = GetHit(scan, i)->pos;
+            from = (key.strand > 0) ? key.start + 3 * j :
+                   key.end - 3 * (j + GetHit(scan, i)->number);
+            to = from + 3 * GetHit(scan, i)->number;
+            sprintf(orf_str, "%ld-%ld", key.start + 1, key.end);
+            if ((sscanf(p, "seq %31s %c %ld", expect, &sign, &pos) != 3) ||
+                    strcmp(expect, orf_str) || (sign != ((key.strand > 0) ? '+' : '-')) ||
+                    (pos - 1 < from) || (pos - 1 + 6 > to))
+            {
+                fprintf(log, "  PrintOrfSites of %s on %d gave %.*s, expected a site in"
+                        " %ld-%ld\n", orf_str, key.strand, (int)strcspn(p, "\n"), p,
+                        from + 1, to);
+                errors++;
+            }
+            p += strcspn(p, "\n") + (*p != '\0');
+        }
+        if (!errors && (*p != '\0'))
+        {
+            fprintf(log, "  PrintOrfSites gave more rows: %.*s\n", (int)strcspn(p, "\n"),
+                    p);
+            errors++;
+        }
+        free(out);
+        out = NULL;
+    }
+    if (!errors && (n != nexpect))
+    {
+        fprintf(log, "  FindOrfs of %s, at least %d codons, gave %ld ORFs, expected %d\n",
+                na, min, n, nexpect);
+        errors++;
+    }
+    free(orf);
+    return(errors);
+}
+
+int VerifyEngine(const char *aa_fname, unsigned long seed, int ncases, FILE *log)
+{
+    static REFERENCE ref;
+    static REF_HITS hits;
+    char re_tmp[] = "/tmp/silmut-verify-XXXXXX";
+    char na[MAX_NA_LEN + 1], in[4 * MAX_NA_LEN + 1], aa[MAX_NA_LEN + 1];
+    char ext[MAX_NA_LEN + 3], expect[MAX_NA_LEN + 1], *aa_str[16], *raw_str[16];
+    int c, i, j, n, m, len, fd, failures = 0, errors;
+    size_t bad;
+    double gc;
+    SEQGEN g;
+    FILE *fp;
+    DATABASE *db;
+    SCAN *scan;
+    ATLAS *atlas = NULL;
+
+    if (RefReadCodons(&ref, aa_fname) < 0)
+        return(-1);
+    if (CheckQueue(log) > 0)
+    {
+        fprintf(log, "QUEUE check failed\n");
+        failures++;
+    }
+    if ((fd = mkstemp(re_tmp)) < 0)
+        return(-1);
+    close(fd);
+
+    for (c = 0; c < ncases; c++)
+    {
+        SeedSeqGen(&g, seed + c);
+        errors = 0;
+
+        /* Random Restriction Enzyme database */
+        ref.nre = 1 + (int)(SeqGenNext(&g) % MAX_RE);
+        gc = 0.3 + 0.4 * SeqGenUniform(&g);
+        if ((fp = fopen(re_tmp, "w")) == NULL)
+            return(-1);
+        for (j = 0; j < ref.nre; j++)
+        {
+            RandomNA(&g, ref.site[j], 6, gc);
+            fprintf(fp, "%s Rnd%d\n", ref.site[j], j + 1);
+        }
+        fclose(fp);
+        if ((db = LoadDataBase(aa_fname, re_tmp, NULL)) == NULL)
+            return(-1);
+        if ((atlas == NULL) && ((atlas = BuildAtlas(db, 6, 1)) == NULL))
+            return(-1);
+
+        /* Random codon usage, or none */
+        memset(ref.cost, 0, sizeof(ref.cost));
+        if ((SeqGenNext(&g) % 4) && ((RandomUsage(&ref, &g, re_tmp) < 0) ||
+                                     (LoadCodonUsage(db, re_tmp) < 0)))
+            return(-1);
+        scan = NewScan(db);
+
+        if (SeqGenNext(&g) & 1)
+        {
+            /* Nucleic acid sequence as it might be typed */
+            len = (int)(SeqGenNext(&g) % (MAX_NA_LEN + 1));
+            RandomNA(&g, na, len, gc);
+            j = Scramble(&g, na, in);
+            errors += CheckInvalid(db, &g, in, j, 2, log);
+            m = ConvertRawNAToAA(db, in, j, raw_str, &bad);
+
+            if ((!Check_Input(db, in, 2) != !len) || ((len > 0) && strcmp(in, na)))
+            {
+                fprintf(log, "  Check_Input normalized to %s\n", in);
+                errors++;
+            }
+
+            n = ConvertNAToAA(db, na, aa_str, len % 3);
+            for (i = 0; i < n; i++)
+            {
+                strcpy(ext, na);
+                if (len % 3 == 1)
+                {
+                    ext[len] = base[i / 4];
+                    ext[len + 1] = base[i % 4];
+                    ext[len + 2] = '\0';
+                }
+                else if (len % 3 == 2)
+                {
+                    ext[len] = base[i];
+                    ext[len + 1] = '\0';
+                }
+                RefTranslate(&ref, ext, strlen(ext), expect);
+                if (strcmp(aa_str[i], expect))
+                {
+                    fprintf(log, "  ConvertNAToAA variant %d gave %s, reference %s\n",
+                            i, aa_str[i], expect);
+                    errors++;
+                }
+                else if (!Duplicate(aa_str, i))
+                    errors += CheckScan(db, &ref, scan, &g, aa_str[i], na, atlas, &hits,
+                                        log);
+            }
+            if (n > 0)
+                errors += CheckVariants(db, &ref, scan, &g, aa_str, n, -1, &hits, log);
+            errors += CheckEdit(db, &ref, scan, &g, na, 2, log);
+            errors += CheckDesign(db, &ref, &g, na, len, &hits, log);
+            if (len > 0)
+                errors += CheckRegion(db, &ref, scan, &g, na, len, re_tmp, &hits, log);
+            errors += CheckShard(&g, na, len, re_tmp, log);
+#ifdef HAVE_ZLIB
+            errors += CheckCompressed(&g, na, len, re_tmp, log);
+#endif
+            if (n > 0)
+                errors += CheckDensity(db, scan, &g, len, aa_str[0], log);
+            errors += CheckDiff(db, &ref, scan, &g, na, len, log);
+            errors += CheckSaturation(db, &ref, na, len, log);
+            errors += CheckDomesticate(db, &ref, na, len, log);
+            errors += CheckOrfs(db, &ref, scan, &g, na, len, log);
+            if (m != (len ? n : -1))
+            {
+                fprintf(log, "  ConvertRawNAToAA gave %d sequences, expected %d\n", m, n);
+                errors++;
+            }
+            for (i = 0; i < m; i++)
+            {
+                if ((i < n) && strcmp(raw_str[i], aa_str[i]))
+                {
+                    fprintf(log, "  ConvertRawNAToAA variant %d gave %s, expected %s\n",
+                            i, raw_str[i], aa_str[i]);
+                    errors++;
+                }
+                free(raw_str[i]);
+            }
+            if (len > 0)
+            {
+                j = Scramble(&g, na, in);
+                i = (int)(SeqGenNext(&g) % j);
+                in[i] = 'N';
+                if ((ConvertRawNAToAA(db, in, j, raw_str, &bad) != -1) || (bad != (size_t)i))
+                {
+                    fprintf(log, "  ConvertRawNAToAA missed the N at %d\n", i);
+                    errors++;
+                }
+            }
+            for (i = 0; i < n; i++)
+                free(aa_str[i]);
+        }
+        else
+        {
+            len = (int)(SeqGenNext(&g) % (MAX_AA_LEN + 1));
+            RandomAA(&g, aa, len, ValidAminoAcids(db));
+            j = Scramble(&g, aa, in);
+            errors += CheckInvalid(db, &g, in, j, 1, log);
+            if ((!Check_Input(db, in, 1) != !len) || ((len > 0) && strcmp(in, aa)))
+            {
+                fprintf(log, "  Check_Input normalized %s to %s\n", aa, in);
+                errors++;
+            }
+            errors += CheckScan(db, &ref, scan, &g, aa, NULL, atlas, &hits, log);
+            errors += CheckEdit(db, &ref, scan, &g, aa, 1, log);
+            if (len > 0)
+                errors += CheckConserved(db, scan, &g, aa, len, log);
+
+            /* last, as the SCANs made before it are of the whole database */
+            errors += CheckSelect(db, &ref, &g, aa, &hits, log);
+        }
+
+        if (errors)
+        {
+            fprintf(log, "case %d (seed %lu) failed\n", c, seed + c);
+            failures++;
+        }
+        FreeScan(scan);
+        FreeDataBase(db);
+    }
+
+    FreeAtlas(atlas);
+    remove(re_tmp);
+    return(failures);
+}
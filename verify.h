@@ -0,0 +1,16 @@
+/****************************************************************************
+*                                                                           *
+*       verify: checks the SILMUT engine against a brute force reference    *
+*       on random sequences and random Restriction Enzyme databases.        *
+*                                                                           *
+****************************************************************************/
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stdio.h>
+
+int VerifyEngine(const char *aa_fname, unsigned long seed, int ncases, FILE *log);
+int VerifyGolden(const char *aa_fname, const char *re_fname, const char *in_fname,
+                 const char *out_fname, FILE *log);
+
+#endif